@@ -0,0 +1,312 @@
+// Runs a long job through the simulated controller using everything that runs after setup: single commands,
+// modal tracking and compact emission, a polyline path, a JobRunner program, continuous jogging, status reports
+// and callbacks.
+// Counts the heap allocations made meanwhile and fails if there were any. The simulator allocates freely,
+// so counting is suspended while it runs. Arcs and jogging are skipped where the build leaves them out.
+// Usage: allocation_count [segments]
+
+#include "GrblSimulator.h"
+#include "JobRunner.h"
+#if !defined(GRBL_INTERFACE_NO_JOGGING)
+#include "JogController.h"
+#endif
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+namespace
+{
+    constexpr auto FEED_RATE = 3000.0f;
+    constexpr auto JOB_TIMEOUT_MS = 600000;
+    constexpr auto JOG_HOLD_US = 500000;
+
+    bool counting = false;
+    int suspended = 0;
+    uint64_t allocations = 0;
+    uint64_t bytesAllocated = 0;
+
+    void *allocate(size_t size)
+    {
+        if (counting && suspended == 0)
+        {
+            allocations++;
+            bytesAllocated += size;
+        }
+
+        if (auto memory = malloc(size == 0 ? 1 : size))
+        {
+            return memory;
+        }
+
+        throw std::bad_alloc();
+    }
+
+    struct Uncounted
+    {
+        Uncounted()
+        {
+            suspended++;
+        }
+
+        ~Uncounted()
+        {
+            suspended--;
+        }
+    };
+
+    // Hands the simulator to the interface with counting suspended.
+    class UncountedStream : public Grbl::ByteStream
+    {
+    public:
+        explicit UncountedStream(Grbl::GrblSimulator &simulator)
+            : m_simulator(simulator)
+        {
+        }
+
+        int available() override
+        {
+            Uncounted uncounted;
+            return m_simulator.available();
+        }
+
+        int read() override
+        {
+            Uncounted uncounted;
+            return m_simulator.read();
+        }
+
+        size_t write(const uint8_t *data, size_t length) override
+        {
+            Uncounted uncounted;
+            return m_simulator.write(data, length);
+        }
+
+    private:
+        Grbl::GrblSimulator &m_simulator;
+    };
+
+    // A G-code program generated on the fly, one short segment per line.
+    class ProgramSource : public Grbl::ByteSource
+    {
+    public:
+        explicit ProgramSource(int lines)
+            : m_lines(lines),
+              m_line(0),
+              m_length(0),
+              m_offset(0)
+        {
+        }
+
+        size_t read(uint8_t *buffer, size_t length) override
+        {
+            size_t count = 0;
+
+            while (count < length)
+            {
+                if (m_offset == m_length)
+                {
+                    if (m_line == m_lines)
+                    {
+                        break;
+                    }
+
+                    const auto angle = m_line * 0.02f;
+                    m_length = snprintf(m_text, sizeof(m_text), "G1 X%d.%03d Y%d.%03d F%d ; segment %d\n",
+                                        static_cast<int>(10 + 5 * std::cos(angle)), static_cast<int>(m_line % 1000),
+                                        static_cast<int>(10 + 5 * std::sin(angle)), static_cast<int>(m_line * 7 % 1000),
+                                        static_cast<int>(FEED_RATE), m_line);
+                    m_offset = 0;
+                    m_line++;
+                }
+
+                buffer[count++] = m_text[m_offset++];
+            }
+
+            return count;
+        }
+
+    private:
+        int m_lines;
+        int m_line;
+        size_t m_length;
+        size_t m_offset;
+        char m_text[64];
+    };
+}
+
+void *operator new(size_t size)
+{
+    return allocate(size);
+}
+
+void *operator new[](size_t size)
+{
+    return allocate(size);
+}
+
+void operator delete(void *memory) noexcept
+{
+    free(memory);
+}
+
+void operator delete[](void *memory) noexcept
+{
+    free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept
+{
+    free(memory);
+}
+
+void operator delete[](void *memory, size_t) noexcept
+{
+    free(memory);
+}
+
+int main(int argc, char *argv[])
+{
+    const auto segments = argc > 1 ? atoi(argv[1]) : 5000;
+
+    // Setup, allocations are expected here.
+    Grbl::GrblSimulator simulator;
+    Grbl::Platform::setClockSource([&simulator]
+                                   { return simulator.micros(); });
+    UncountedStream stream(simulator);
+    GrblInterface grbl(stream);
+    JobRunner runner(grbl);
+#if !defined(GRBL_INTERFACE_NO_JOGGING)
+    JogController jog(grbl);
+#endif
+    ProgramSource program(segments);
+
+    size_t bytesSent = 0;
+    uint32_t statusReports = 0;
+    uint32_t failures = 0;
+    grbl.onGCodeAboutToBeSent = [&bytesSent](std::string_view line)
+    {
+        bytesSent += line.size();
+    };
+    grbl.statusReportReceived = [&statusReports](std::string_view)
+    {
+        statusReports++;
+    };
+    grbl.onCommandCompleted = [&failures](Grbl::Ticket, Grbl::CommandStatus status, Grbl::Error)
+    {
+        failures += status != Grbl::CommandStatus::Ok;
+    };
+
+    std::vector<Point> polyline(segments);
+
+    for (auto i = 0; i < segments; i++)
+    {
+        polyline[i] = {5 * std::cos(i * 0.01f), 5 * std::sin(i * 0.01f)};
+    }
+
+#if !defined(GRBL_INTERFACE_NO_ARCS)
+    const PathSegment path[] = {{Grbl::SegmentType::Line, {10, 0}, {0, 0}},
+                                {Grbl::SegmentType::CounterClockwiseArc, {0, 10}, {-10, 0}},
+                                {Grbl::SegmentType::Line, {0, 0}, {0, 0}}};
+#else
+    const PathSegment path[] = {{Grbl::SegmentType::Line, {10, 0}},
+                                {Grbl::SegmentType::Line, {0, 10}},
+                                {Grbl::SegmentType::Line, {0, 0}}};
+#endif
+
+    counting = true;
+
+    // Single commands, first with full words, then with modal tracking and compact emission.
+    grbl.setStreamingMode(true);
+    auto accepted = grbl.setUnitOfMeasurement(Grbl::UnitOfMeasurement::Millimeters) &&
+                    grbl.setDistanceMode(Grbl::DistanceMode::Absolute) &&
+                    grbl.requestParserState();
+
+    for (auto pass = 0; pass < 2; pass++)
+    {
+        grbl.setModalStateTracking(pass == 1);
+        grbl.setCompactEmission(pass == 1);
+
+        for (auto i = 0; i < segments / 10; i++)
+        {
+            const auto angle = i * 0.05f;
+            accepted = grbl.linearInterpolationPositioning(FEED_RATE, {{Grbl::Axis::X, 5 * std::cos(angle)},
+                                                                       {Grbl::Axis::Y, 5 * std::sin(angle)}}) &&
+                       accepted;
+        }
+
+#if !defined(GRBL_INTERFACE_NO_ARCS)
+        accepted = grbl.arcInterpolationPositioning(Grbl::ArcMovement::Clockwise, {{Grbl::Axis::X, 5}, {Grbl::Axis::Y, 0}},
+                                                    5, FEED_RATE) &&
+                   accepted;
+#endif
+        accepted = grbl.linearRapidPositioning({{Grbl::Axis::X, 0}, {Grbl::Axis::Y, 0}, {Grbl::Axis::Z, 1}}) &&
+                   grbl.waitForStreamToDrain(JOB_TIMEOUT_MS) &&
+                   accepted;
+
+#if !defined(GRBL_INTERFACE_NO_JOGGING)
+        // Grbl only accepts jogging while idle.
+        while (!simulator.isIdle())
+        {
+            grbl.update();
+        }
+
+        accepted = grbl.jog(FEED_RATE, {{Grbl::Axis::Z, 0}}) && grbl.waitForStreamToDrain(JOB_TIMEOUT_MS) && accepted;
+#endif
+    }
+
+    // Batched paths.
+    const auto polylineDone = grbl.waitForPath(grbl.sendPolyline(polyline.data(), polyline.size(), FEED_RATE),
+                                               JOB_TIMEOUT_MS);
+    const auto pathDone = grbl.waitForPath(grbl.sendPath(path, 3, FEED_RATE), JOB_TIMEOUT_MS);
+
+    // A streamed program.
+    auto jobStarted = runner.start(program);
+
+    while (jobStarted && (runner.state() == JobState::Running || !simulator.isIdle()))
+    {
+        runner.update();
+    }
+
+#if !defined(GRBL_INTERFACE_NO_JOGGING)
+    // A joystick held and released, then a handwheel turned.
+    const auto jogStartedAt = simulator.micros();
+
+    while (simulator.micros() - jogStartedAt < JOG_HOLD_US)
+    {
+        jog.setVelocity({{Grbl::Axis::X, FEED_RATE}, {Grbl::Axis::Y, -FEED_RATE / 2}});
+        jog.update();
+    }
+
+    jog.stop();
+
+    for (auto i = 0; i < segments / 10 || jog.state() != JogState::Idle; i++)
+    {
+        jog.addDistance(Grbl::Axis::Z, i < segments / 10 ? 0.01f : 0);
+        jog.update();
+    }
+
+    const auto jogged = jog.statistics().stopLatency.count() == 1 && jog.statistics().segmentsRejected == 0;
+#else
+    const auto jogged = true;
+#endif
+    const auto snapshot = grbl.getStatusSnapshot();
+    counting = false;
+
+    const auto progress = runner.progress();
+    printf("%d segments each as commands, path and program: %zu bytes sent, %u status reports, %u failed lines\n",
+           segments, bytesSent, statusReports, failures);
+    printf("commands %s, polyline %s, path %s, program %s (%u lines), jog %s, last reported X%.3f Y%.3f\n",
+           accepted ? "ok" : "FAILED", polylineDone ? "ok" : "FAILED", pathDone ? "ok" : "FAILED",
+           runner.state() == JobState::Completed ? "ok" : "FAILED", progress.linesCompleted,
+           jogged ? "ok" : "FAILED", snapshot.workPosition[0], snapshot.workPosition[1]);
+    printf("heap allocations after setup: %llu (%llu bytes)\n", static_cast<unsigned long long>(allocations),
+           static_cast<unsigned long long>(bytesAllocated));
+
+    Grbl::Platform::setClockSource({});
+    const auto succeeded = allocations == 0 && failures == 0 && accepted && polylineDone && pathDone &&
+                           runner.state() == JobState::Completed && jogged;
+    return succeeded ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,120 @@
+// Streams the same short-segment job to 1, 2, 4 ... simulated controllers serviced by one GrblCluster and
+// measures the host CPU time spent in GrblCluster::update() against the virtual job time.
+// Usage: cluster_scaling [max controllers] [segments per controller] [loop period us]
+
+#include "GrblCluster.h"
+#include "GrblSimulator.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+namespace
+{
+    constexpr auto SEGMENT_LENGTH = 0.1f;
+    constexpr auto FEED_RATE = 3000.0f;
+
+    struct ScalingResult
+    {
+        double virtualSeconds;
+        double cpuSeconds;
+        uint64_t updates;
+        float slowestLinesPerSecond;
+        uint32_t statusReports;
+    };
+
+    ScalingResult run(size_t controllers, int segments, uint32_t loopPeriod)
+    {
+        uint64_t now = 0;
+        Grbl::Platform::setClockSource([&now]
+                                       { return now; });
+
+        Grbl::SimulatorConfiguration configuration;
+        configuration.hostPollMicros = 0; // Time is driven by this loop for all controllers alike.
+
+        std::vector<std::unique_ptr<Grbl::GrblSimulator>> simulators;
+        std::vector<std::unique_ptr<GrblInterface>> interfaces;
+        std::vector<int> segmentsQueued(controllers, 0);
+        GrblCluster cluster;
+
+        for (size_t i = 0; i < controllers; i++)
+        {
+            simulators.push_back(std::make_unique<Grbl::GrblSimulator>(configuration));
+            interfaces.push_back(std::make_unique<GrblInterface>(*simulators.back()));
+            interfaces.back()->setStreamingMode(true);
+            interfaces.back()->setAsynchronousMode(true);
+            (void)cluster.add(*interfaces.back());
+        }
+
+        ScalingResult result = {};
+        auto busy = true;
+
+        while (busy)
+        {
+            now += loopPeriod;
+            busy = false;
+
+            for (size_t i = 0; i < controllers; i++)
+            {
+                auto &grbl = *interfaces[i];
+                simulators[i]->advance(loopPeriod);
+
+                // A polyline spiralling outwards, so consecutive segments never line up into one long move.
+                while (segmentsQueued[i] < segments && grbl.commandsQueued() < Grbl::COMMAND_QUEUE_SIZE)
+                {
+                    const auto angle = segmentsQueued[i] * SEGMENT_LENGTH / 5;
+                    const auto radius = 5 + segmentsQueued[i] * 0.001f;
+                    (void)grbl.linearInterpolationPositioning(FEED_RATE, {{Grbl::Axis::X, radius * std::cos(angle)},
+                                                                          {Grbl::Axis::Y, radius * std::sin(angle)}});
+                    segmentsQueued[i]++;
+                }
+
+                busy = busy || segmentsQueued[i] < segments || grbl.commandsQueued() > 0 ||
+                       grbl.linesInFlight() > 0 || !simulators[i]->isIdle();
+            }
+
+            const auto startedAt = std::chrono::steady_clock::now();
+            cluster.update();
+            result.cpuSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - startedAt).count();
+            result.updates++;
+        }
+
+        result.virtualSeconds = now / 1e6;
+        result.slowestLinesPerSecond = INFINITY;
+
+        for (size_t i = 0; i < controllers; i++)
+        {
+            const auto lines = cluster.getStatistics(i).streaming.linesAcknowledged;
+            result.slowestLinesPerSecond = std::min(result.slowestLinesPerSecond, static_cast<float>(lines / result.virtualSeconds));
+            result.statusReports += simulators[i]->statistics().statusReports;
+        }
+
+        Grbl::Platform::setClockSource({});
+        return result;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const auto maxControllers = argc > 1 ? static_cast<size_t>(atoi(argv[1])) : Grbl::MAX_CLUSTER_SIZE;
+    const auto segments = argc > 2 ? atoi(argv[2]) : 1000;
+    const auto loopPeriod = argc > 3 ? static_cast<uint32_t>(atol(argv[3])) : 100;
+
+    printf("%d segments of %.1f mm at F%.0f per controller, cluster updated every %u us of virtual time\n",
+           segments, SEGMENT_LENGTH, FEED_RATE, loopPeriod);
+    printf("%11s %10s %12s %14s %16s %14s %14s\n", "controllers", "job [s]", "updates", "cpu/update [us]",
+           "cpu/job-second", "lines/s (min)", "status reports");
+
+    for (size_t controllers = 1; controllers <= maxControllers; controllers *= 2)
+    {
+        const auto result = run(controllers, segments, loopPeriod);
+        printf("%11zu %10.2f %12llu %14.2f %13.2f ms %14.1f %14u\n", controllers, result.virtualSeconds,
+               static_cast<unsigned long long>(result.updates), result.cpuSeconds * 1e6 / result.updates,
+               result.cpuSeconds * 1e3 / result.virtualSeconds, result.slowestLinesPerSecond, result.statusReports);
+    }
+
+    return EXIT_SUCCESS;
+}
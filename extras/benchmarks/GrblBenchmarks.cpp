@@ -0,0 +1,328 @@
+// Google Benchmark suite for the response parser, the command serializer and full round trips through the
+// simulated controller. Every iteration handles one line, so the time column reads as ns/line; lines/s and
+// time/line (from the real time) are reported as counters as well. receiveLinesRegexp runs the same lines
+// through the Regexp-based parsing the parser replaced (RegexpBaseline.h), as a before and after. Received
+// lines are taken from corpus/traffic.txt, or from the file named by the GRBL_TRAFFIC_CORPUS environment
+// variable, one response per line.
+// Usage: grbl_benchmarks [--benchmark_filter=<regex>] [other Google Benchmark options]
+
+#include "GrblInterface.h"
+#include "GrblParser.h"
+#include "GrblSimulator.h"
+#include "RegexpBaseline.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    constexpr auto FEED_RATE = 3000.0f;
+
+    std::vector<std::string> loadCorpus(const char *prefix)
+    {
+        const auto path = getenv("GRBL_TRAFFIC_CORPUS") != nullptr ? getenv("GRBL_TRAFFIC_CORPUS") : TRAFFIC_CORPUS;
+        std::ifstream file(path);
+        std::vector<std::string> lines;
+        std::string line;
+
+        while (std::getline(file, line))
+        {
+            if (!line.empty() && line.back() == '\r')
+            {
+                line.pop_back();
+            }
+
+            if (!line.empty() && line.compare(0, strlen(prefix), prefix) == 0)
+            {
+                lines.push_back(line);
+            }
+        }
+
+        return lines;
+    }
+
+    void reportLines(benchmark::State &state)
+    {
+        const auto lines = static_cast<double>(state.iterations());
+        state.counters["lines/s"] = benchmark::Counter(lines, benchmark::Counter::kIsRate);
+        state.counters["time/line"] = benchmark::Counter(lines, benchmark::Counter::kIsRate |
+                                                                    benchmark::Counter::kInvert);
+    }
+
+    // Plays the same received lines over and over, terminated like Grbl does, and discards everything written.
+    class ReplayStream : public Grbl::ByteStream
+    {
+    public:
+        explicit ReplayStream(const std::vector<std::string> &lines)
+            : m_offset(0)
+        {
+            for (const auto &line : lines)
+            {
+                m_traffic += line + "\r\n";
+            }
+        }
+
+        int available() override
+        {
+            return static_cast<int>(m_traffic.size());
+        }
+
+        int read() override
+        {
+            const auto c = m_traffic[m_offset];
+            m_offset = (m_offset + 1) % m_traffic.size();
+            return static_cast<uint8_t>(c);
+        }
+
+        size_t write(const uint8_t *, size_t length) override
+        {
+            return length;
+        }
+
+    private:
+        std::string m_traffic;
+        size_t m_offset;
+    };
+
+    // Answers every line written with "ok" right away, like an infinitely fast controller.
+    class AcknowledgingStream : public Grbl::ByteStream
+    {
+    public:
+        int available() override
+        {
+            return static_cast<int>(m_pending.size() - m_offset);
+        }
+
+        int read() override
+        {
+            if (m_offset == m_pending.size())
+            {
+                return -1;
+            }
+
+            const auto c = m_pending[m_offset++];
+
+            if (m_offset == m_pending.size())
+            {
+                m_pending.clear();
+                m_offset = 0;
+            }
+
+            return static_cast<uint8_t>(c);
+        }
+
+        size_t write(const uint8_t *data, size_t length) override
+        {
+            for (size_t i = 0; i < length; i++)
+            {
+                if (data[i] == '\n')
+                {
+                    m_pending += "ok\r\n";
+                }
+            }
+
+            return length;
+        }
+
+    private:
+        std::string m_pending;
+        size_t m_offset = 0;
+    };
+
+    void receiveLines(benchmark::State &state, const char *prefix)
+    {
+        const auto lines = loadCorpus(prefix);
+
+        if (lines.empty())
+        {
+            state.SkipWithError("No matching lines in the traffic corpus");
+            return;
+        }
+
+        ReplayStream stream(lines);
+        GrblInterface grbl(stream);
+        grbl.setAutomaticStatusReports(false);
+
+        for (auto _ : state)
+        {
+            grbl.update(); // Returns after each complete line.
+        }
+
+        reportLines(state);
+    }
+
+    // The same lines through the Regexp patterns Grbl::Parser replaced, for a before and after in lines/s.
+    void receiveLinesRegexp(benchmark::State &state, const char *prefix)
+    {
+        const auto lines = loadCorpus(prefix);
+
+        if (lines.empty())
+        {
+            state.SkipWithError("No matching lines in the traffic corpus");
+            return;
+        }
+
+        ReplayStream stream(lines);
+        RegexpBaseline baseline(stream);
+
+        for (auto _ : state)
+        {
+            baseline.update();
+        }
+
+        benchmark::DoNotOptimize(baseline.workCoordinate());
+        reportLines(state);
+    }
+
+    void extractPosition(benchmark::State &state, const char *position)
+    {
+        Coordinate coordinate;
+
+        for (auto _ : state)
+        {
+            const char *cursor = position;
+            benchmark::DoNotOptimize(Grbl::Parser::parseValues(cursor, coordinate.data(), coordinate.size()));
+            benchmark::DoNotOptimize(coordinate);
+        }
+
+        reportLines(state);
+    }
+
+    using Command = bool (*)(GrblInterface &grbl, float value);
+
+    void sendCommand(benchmark::State &state, Command command)
+    {
+        AcknowledgingStream stream;
+        GrblInterface grbl(stream);
+        grbl.setAutomaticStatusReports(false);
+        grbl.setCompactEmission(state.range(0) != 0);
+        grbl.setModalStateTracking(state.range(0) != 0);
+
+        size_t bytesSent = 0;
+        grbl.onGCodeAboutToBeSent = [&bytesSent](std::string_view line)
+        {
+            bytesSent += line.size() + 1;
+        };
+
+        uint32_t i = 0;
+        bool accepted = true;
+
+        for (auto _ : state)
+        {
+            // A different position every time, so nothing is left out as unchanged.
+            accepted = command(grbl, static_cast<float>(i++ % 1000) * 0.125f) && accepted;
+        }
+
+        if (!accepted)
+        {
+            state.SkipWithError("Command rejected");
+        }
+
+        reportLines(state);
+        state.counters["bytes/line"] = static_cast<double>(bytesSent) / state.iterations();
+    }
+
+    bool linearRapidPositioning(GrblInterface &grbl, float value)
+    {
+        return grbl.linearRapidPositioning({{Grbl::Axis::X, value}, {Grbl::Axis::Y, -value}, {Grbl::Axis::Z, 1}});
+    }
+
+    bool linearInterpolationPositioning(GrblInterface &grbl, float value)
+    {
+        return grbl.linearInterpolationPositioning(FEED_RATE, {{Grbl::Axis::X, value}, {Grbl::Axis::Y, -value}});
+    }
+
+    bool linearPositioningInMachineCoordinate(GrblInterface &grbl, float value)
+    {
+        return grbl.linearPositioningInMachineCoordinate({{Grbl::Axis::X, value}, {Grbl::Axis::Y, -value}});
+    }
+
+#if !defined(GRBL_INTERFACE_NO_ARCS)
+    bool arcWithRadius(GrblInterface &grbl, float value)
+    {
+        return grbl.arcInterpolationPositioning(Grbl::ArcMovement::Clockwise,
+                                                {{Grbl::Axis::X, value}, {Grbl::Axis::Y, 0}}, value + 1, FEED_RATE);
+    }
+
+    bool arcWithCenter(GrblInterface &grbl, float value)
+    {
+        return grbl.arcInterpolationPositioning(Grbl::ArcMovement::CounterClockwise,
+                                                {{Grbl::Axis::X, value}, {Grbl::Axis::Y, 0}}, {value / 2, 0},
+                                                FEED_RATE);
+    }
+#endif
+
+#if !defined(GRBL_INTERFACE_NO_JOGGING)
+    bool jog(GrblInterface &grbl, float value)
+    {
+        return grbl.jog(FEED_RATE, {{Grbl::Axis::X, value}});
+    }
+#endif
+
+    // Round trips through the simulated controller, with its virtual clock.
+    void simulatorCommands(benchmark::State &state, bool streaming)
+    {
+        Grbl::GrblSimulator simulator;
+        Grbl::Platform::setClockSource([&simulator]
+                                       { return simulator.micros(); });
+
+        {
+            GrblInterface grbl(simulator);
+            grbl.setStreamingMode(streaming);
+            uint32_t i = 0;
+            bool accepted = true;
+
+            for (auto _ : state)
+            {
+                const auto value = static_cast<float>(i++ % 1000) * 0.01f;
+                accepted = grbl.linearInterpolationPositioning(FEED_RATE, {{Grbl::Axis::X, value},
+                                                                           {Grbl::Axis::Y, -value}}) &&
+                           accepted;
+            }
+
+            // Outside of the timed loop.
+            accepted = grbl.waitForStreamToDrain(Grbl::DEFAULT_COMMAND_TIMEOUT_MS * 10) && accepted;
+
+            if (!accepted)
+            {
+                state.SkipWithError("Command rejected or timed out");
+            }
+        }
+
+        Grbl::Platform::setClockSource({});
+        reportLines(state);
+    }
+}
+
+BENCHMARK_CAPTURE(receiveLines, corpus, "");
+BENCHMARK_CAPTURE(receiveLines, status_reports, "<");
+BENCHMARK_CAPTURE(receiveLines, ok, "ok");
+BENCHMARK_CAPTURE(receiveLines, error, "error:");
+BENCHMARK_CAPTURE(receiveLines, alarm, "ALARM:");
+BENCHMARK_CAPTURE(receiveLines, messages, "[");
+BENCHMARK_CAPTURE(receiveLinesRegexp, corpus, "");
+BENCHMARK_CAPTURE(receiveLinesRegexp, status_reports, "<");
+
+BENCHMARK_CAPTURE(extractPosition, three_axes, "-196.512,-197.004,-1.000");
+BENCHMARK_CAPTURE(extractPosition, six_axes, "-196.512,-197.004,-1.000,90.000,0.000,-45.250");
+
+BENCHMARK_CAPTURE(sendCommand, linear_rapid, linearRapidPositioning)->ArgName("compact")->Arg(0)->Arg(1);
+BENCHMARK_CAPTURE(sendCommand, linear_interpolation, linearInterpolationPositioning)->ArgName("compact")->Arg(0)->Arg(1);
+BENCHMARK_CAPTURE(sendCommand, machine_coordinate, linearPositioningInMachineCoordinate)->ArgName("compact")->Arg(0)->Arg(1);
+#if !defined(GRBL_INTERFACE_NO_ARCS)
+BENCHMARK_CAPTURE(sendCommand, arc_radius, arcWithRadius)->ArgName("compact")->Arg(0)->Arg(1);
+BENCHMARK_CAPTURE(sendCommand, arc_center, arcWithCenter)->ArgName("compact")->Arg(0)->Arg(1);
+#endif
+#if !defined(GRBL_INTERFACE_NO_JOGGING)
+BENCHMARK_CAPTURE(sendCommand, jog, jog)->ArgName("compact")->Arg(0)->Arg(1);
+#endif
+
+BENCHMARK_CAPTURE(simulatorCommands, send_and_wait, false);
+BENCHMARK_CAPTURE(simulatorCommands, streaming, true);
+
+BENCHMARK_MAIN();
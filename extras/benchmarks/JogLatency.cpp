@@ -0,0 +1,297 @@
+// Jogs the simulated controller the way a pendant does: a joystick held for a while and released, and a
+// handwheel turned at a steady rate and stopped. Compares one blocking jog() per input tick against
+// JogController. The input follows the virtual clock, so a blocking call that holds up the loop makes it miss
+// ticks, like it would on a pendant. Motion start, standstill and the travel after the release are taken from
+// the simulator's own position; the operator releases at the end of the hold time, whenever the loop notices.
+// Usage: jog_latency [feed rate mm/min] [hold ms] [acceleration mm/s^2] [link latency us]
+
+#include "GrblSimulator.h"
+#include "JogController.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+
+namespace
+{
+    constexpr auto TICK_MS = Grbl::DEFAULT_JOG_TICK_MS;
+    constexpr auto TICK_US = TICK_MS * 1000;
+    constexpr auto HANDWHEEL_DETENT = 0.01f; // mm
+    constexpr auto HANDWHEEL_DETENTS_PER_TICK = 5;
+    constexpr auto SETTLE_TIMEOUT_US = 60000000;
+
+    struct Setup
+    {
+        float feedRate;
+        uint32_t holdMicros;
+        float acceleration;
+        uint32_t latency;
+    };
+
+    struct JogResult
+    {
+        float startLatencyMs; // Input to the first motion.
+        float stopLatencyMs;  // Release to standstill.
+        float overrun;        // mm travelled after the release.
+        float finalPosition;  // mm
+        uint32_t linesSent;
+    };
+
+    class JogRun
+    {
+    public:
+        explicit JogRun(const Setup &setup)
+            : m_simulator(configuration(setup)),
+              m_setup(setup)
+        {
+            Grbl::Platform::setClockSource([this]
+                                           { return m_simulator.micros(); });
+        }
+
+        ~JogRun()
+        {
+            Grbl::Platform::setClockSource({});
+        }
+
+        Grbl::GrblSimulator &simulator()
+        {
+            return m_simulator;
+        }
+
+        // Calls input with the time since the start once per tick until the hold time is over, then release,
+        // and update in between.
+        JogResult run(GrblInterface &grbl, const std::function<void(uint32_t elapsed)> &input,
+                      const std::function<void()> &release, const std::function<void()> &update)
+        {
+            m_startedAt = m_simulator.micros();
+            m_startPosition = m_simulator.machinePosition()[0];
+
+            while (true)
+            {
+                const auto elapsed = static_cast<uint32_t>(m_simulator.micros() - m_startedAt);
+
+                if (elapsed >= m_setup.holdMicros)
+                {
+                    release();
+                    break;
+                }
+
+                input(elapsed);
+                observe();
+
+                const auto tickEnd = m_startedAt + (elapsed / TICK_US + 1) * TICK_US;
+
+                while (m_simulator.micros() < tickEnd)
+                {
+                    update();
+                    observe();
+                }
+            }
+
+            // Standstill is when the simulator has nothing left to do and the position stopped changing.
+            auto position = m_simulator.machinePosition()[0];
+            auto stoppedAt = m_simulator.micros();
+
+            while (m_simulator.micros() - stoppedAt < SETTLE_TIMEOUT_US &&
+                   (!m_simulator.isIdle() || grbl.linesInFlight() > 0 || grbl.commandsQueued() > 0))
+            {
+                update();
+
+                if (m_simulator.machinePosition()[0] != position)
+                {
+                    position = m_simulator.machinePosition()[0];
+                    stoppedAt = m_simulator.micros();
+                }
+            }
+
+            const auto releasedAt = m_startedAt + m_setup.holdMicros;
+            const auto stopLatency = stoppedAt > releasedAt ? stoppedAt - releasedAt : 0;
+            return {(m_movingAt - m_startedAt) / 1000.0f, stopLatency / 1000.0f,
+                    std::fabs(position - m_releasePosition), position, grbl.getStreamingStatistics().linesSent};
+        }
+
+    private:
+        Grbl::GrblSimulator m_simulator;
+        Setup m_setup;
+        uint64_t m_startedAt = 0;
+        float m_startPosition = 0;
+        uint64_t m_movingAt = 0;
+        bool m_released = false;
+        float m_releasePosition = 0;
+
+        static Grbl::SimulatorConfiguration configuration(const Setup &setup)
+        {
+            Grbl::SimulatorConfiguration configuration;
+            configuration.acceleration = setup.acceleration;
+            configuration.latencyMicros = setup.latency;
+            return configuration;
+        }
+
+        void observe()
+        {
+            const auto now = m_simulator.micros();
+            const auto position = m_simulator.machinePosition()[0];
+
+            if (m_movingAt == 0 && position != m_startPosition)
+            {
+                m_movingAt = now;
+            }
+
+            if (!m_released && now - m_startedAt >= m_setup.holdMicros)
+            {
+                m_released = true;
+                m_releasePosition = position;
+            }
+        }
+    };
+
+    [[nodiscard]] uint32_t ticksStarted(uint32_t elapsed)
+    {
+        return elapsed / TICK_US + 1;
+    }
+
+    [[nodiscard]] float handwheelTarget(uint32_t elapsed)
+    {
+        return ticksStarted(elapsed) * HANDWHEEL_DETENTS_PER_TICK * HANDWHEEL_DETENT;
+    }
+
+    [[nodiscard]] JogConfiguration jogConfiguration(const Setup &setup)
+    {
+        JogConfiguration configuration;
+        configuration.maxFeedRate = setup.feedRate;
+        configuration.acceleration = setup.acceleration;
+        return configuration;
+    }
+
+    // Keeps the controller running until a status report showed the machine at rest, for its own latencies.
+    void settle(JogController &jog)
+    {
+        const auto startedAt = Grbl::Platform::micros();
+
+        while (jog.state() != JogState::Idle && Grbl::Platform::micros() - startedAt < SETTLE_TIMEOUT_US)
+        {
+            jog.update();
+        }
+    }
+
+    // One blocking jog() per tick to where the joystick has asked the machine to be by the end of the tick, and
+    // no jog cancel.
+    JogResult blockingJoystick(const Setup &setup)
+    {
+        JogRun run(setup);
+        GrblInterface grbl(run.simulator());
+
+        return run.run(
+            grbl,
+            [&](uint32_t elapsed)
+            {
+                const auto target = setup.feedRate / 60000 * ticksStarted(elapsed) * TICK_MS;
+                (void)grbl.jog(setup.feedRate, {{Grbl::Axis::X, target}});
+            },
+            [] {},
+            [&grbl]
+            { grbl.update(); });
+    }
+
+    JogResult joystick(const Setup &setup, JogStatistics &statistics)
+    {
+        JogRun run(setup);
+        GrblInterface grbl(run.simulator());
+        JogController jog(grbl, jogConfiguration(setup));
+
+        const auto result = run.run(
+            grbl,
+            [&](uint32_t)
+            { jog.setVelocity({{Grbl::Axis::X, setup.feedRate}}); },
+            [&jog]
+            { jog.stop(); },
+            [&jog]
+            { jog.update(); });
+
+        settle(jog);
+        statistics = jog.statistics();
+        return result;
+    }
+
+    JogResult blockingHandwheel(const Setup &setup)
+    {
+        JogRun run(setup);
+        GrblInterface grbl(run.simulator());
+
+        return run.run(
+            grbl,
+            [&](uint32_t elapsed)
+            { (void)grbl.jog(setup.feedRate, {{Grbl::Axis::X, handwheelTarget(elapsed)}}); },
+            [] {},
+            [&grbl]
+            { grbl.update(); });
+    }
+
+    JogResult handwheel(const Setup &setup, JogStatistics &statistics)
+    {
+        JogRun run(setup);
+        GrblInterface grbl(run.simulator());
+        JogController jog(grbl, jogConfiguration(setup));
+        auto counted = 0.0f;
+
+        const auto result = run.run(
+            grbl,
+            [&](uint32_t elapsed)
+            {
+                const auto target = handwheelTarget(elapsed);
+                jog.addDistance(Grbl::Axis::X, target - counted);
+                counted = target;
+            },
+            [] {},
+            [&jog]
+            { jog.update(); });
+
+        settle(jog);
+        statistics = jog.statistics();
+        return result;
+    }
+
+    void print(const char *name, const JogResult &result)
+    {
+        printf("%-26s %7.1f ms start %7.1f ms stop %8.3f mm overrun %8.3f mm final %5u lines\n", name,
+               result.startLatencyMs, result.stopLatencyMs, result.overrun, result.finalPosition, result.linesSent);
+    }
+
+    void print(const JogStatistics &statistics)
+    {
+        printf("%-26s %7.1f ms start", "  as JogController saw it", statistics.startLatency.mean() / 1000.0f);
+
+        // The handwheel is never released, its motion just runs out.
+        if (statistics.stopLatency.count() > 0)
+        {
+            printf(" %7.1f ms stop", statistics.stopLatency.mean() / 1000.0f);
+        }
+
+        printf(" from status reports, %u segments, %u rejected, %.3f mm dropped\n", statistics.segmentsSent,
+               statistics.segmentsRejected, statistics.distanceDropped);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const Setup setup = {argc > 1 ? static_cast<float>(atof(argv[1])) : 3000.0f,
+                         static_cast<uint32_t>(argc > 2 ? atoi(argv[2]) : 1000) * 1000,
+                         argc > 3 ? static_cast<float>(atof(argv[3])) : 100.0f,
+                         argc > 4 ? static_cast<uint32_t>(atol(argv[4])) : 1000};
+
+    printf("joystick held %u ms at F%.0f, handwheel %d detents of %.3f mm per %d ms, %.0f mm/s^2, "
+           "%u us link latency, braking from F%.0f takes %.3f mm\n",
+           setup.holdMicros / 1000, setup.feedRate, HANDWHEEL_DETENTS_PER_TICK, HANDWHEEL_DETENT, TICK_MS,
+           setup.acceleration, setup.latency, setup.feedRate,
+           std::pow(setup.feedRate / 60, 2) / (2 * setup.acceleration));
+
+    JogStatistics statistics;
+    print("joystick, blocking jog()", blockingJoystick(setup));
+    print("joystick, JogController", joystick(setup, statistics));
+    print(statistics);
+    print("handwheel, blocking jog()", blockingHandwheel(setup));
+    print("handwheel, JogController", handwheel(setup, statistics));
+    print(statistics);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,184 @@
+// Streams jobs through the simulated controller and samples the position a DRO would show at a fixed rate:
+// the last status report as is, and GrblInterface::estimatedPosition(). Both are compared against the
+// simulator's own position while the machine moves, along with how often the error stayed within the
+// estimate's uncertainty.
+// Usage: position_estimate [report interval ms] [sample interval ms] [feed rate mm/min] [link latency us]
+
+#include "GrblInterface.h"
+#include "GrblSimulator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+
+namespace
+{
+    constexpr auto REPORT_RESOLUTION = 0.001f; // Grbl prints positions with three decimals.
+    constexpr auto LINE_LENGTH = 64;
+    constexpr auto DRAIN_TIMEOUT_US = 60000000;
+
+    struct Setup
+    {
+        uint16_t reportInterval;
+        uint32_t sampleInterval;
+        float feedRate;
+        uint32_t latency;
+    };
+
+    struct ErrorResult
+    {
+        uint32_t samples;
+        float reportedMean; // mm
+        float reportedMax;
+        float estimatedMean;
+        float estimatedMax;
+        float uncertaintyMean;
+        float withinUncertainty; // Fraction of the samples.
+    };
+
+    [[nodiscard]] float distance(const Coordinate &a, const std::array<float, Grbl::MAX_NUMBER_OF_AXES> &b)
+    {
+        auto sum = 0.0f;
+
+        for (size_t i = 0; i < a.size(); i++)
+        {
+            sum += (a[i] - b[i]) * (a[i] - b[i]);
+        }
+
+        return std::sqrt(sum);
+    }
+
+    // Calls line(i, buffer) for every line of the job and keeps the interface fed, sampling in between.
+    ErrorResult runJob(const Setup &setup, int lines, const std::function<void(int, char *)> &line)
+    {
+        Grbl::SimulatorConfiguration configuration;
+        configuration.latencyMicros = setup.latency;
+        Grbl::GrblSimulator simulator(configuration);
+        Grbl::Platform::setClockSource([&simulator]
+                                       { return simulator.micros(); });
+
+        GrblInterface grbl(simulator);
+        grbl.setStreamingMode(true);
+        grbl.setAsynchronousMode(true);
+        grbl.setStatusReportIntervals(setup.reportInterval, setup.reportInterval);
+        grbl.setEstimatorAcceleration(configuration.acceleration);
+
+        // Moves are placed from a report of the machine at rest, as before any job.
+        while (grbl.getStatusSnapshot().receivedAt == 0)
+        {
+            grbl.update();
+        }
+
+        ErrorResult result{};
+        double reportedSum = 0, estimatedSum = 0, uncertaintySum = 0;
+        uint32_t within = 0;
+        uint64_t nextSample = 0;
+        char buffer[LINE_LENGTH];
+        auto sent = 0;
+        const auto startedAt = simulator.micros();
+
+        while (sent < lines || !simulator.isIdle() || grbl.linesInFlight() > 0 || grbl.commandsQueued() > 0)
+        {
+            if (simulator.micros() - startedAt > DRAIN_TIMEOUT_US)
+            {
+                fprintf(stderr, "The job did not finish in time\n");
+                break;
+            }
+
+            while (sent < lines && grbl.commandsQueued() < Grbl::COMMAND_QUEUE_SIZE / 2)
+            {
+                line(sent++, buffer);
+                (void)grbl.sendLine(buffer);
+            }
+
+            grbl.update();
+
+            const auto now = simulator.micros();
+
+            if (now < nextSample)
+            {
+                continue;
+            }
+
+            nextSample = now + setup.sampleInterval;
+
+            if (simulator.isIdle())
+            {
+                continue;
+            }
+
+            const auto &actual = simulator.machinePosition();
+            const auto estimate = grbl.estimatedPosition();
+            const auto reportedError = distance(grbl.getMachineCoordinate(), actual);
+            const auto estimatedError = distance(estimate.machinePosition, actual);
+
+            result.samples++;
+            reportedSum += reportedError;
+            estimatedSum += estimatedError;
+            uncertaintySum += estimate.uncertainty;
+            result.reportedMax = std::max(result.reportedMax, reportedError);
+            result.estimatedMax = std::max(result.estimatedMax, estimatedError);
+            within += estimatedError <= estimate.uncertainty + REPORT_RESOLUTION;
+        }
+
+        Grbl::Platform::setClockSource({});
+
+        if (result.samples > 0)
+        {
+            result.reportedMean = static_cast<float>(reportedSum / result.samples);
+            result.estimatedMean = static_cast<float>(estimatedSum / result.samples);
+            result.uncertaintyMean = static_cast<float>(uncertaintySum / result.samples);
+            result.withinUncertainty = static_cast<float>(within) / result.samples;
+        }
+
+        return result;
+    }
+
+    void print(const char *name, const ErrorResult &result)
+    {
+        printf("%-16s %6u samples  last report %7.3f mm mean %7.3f mm max  estimate %7.3f mm mean %7.3f mm max"
+               "  uncertainty %7.3f mm mean, held %5.1f%%\n",
+               name, result.samples, result.reportedMean, result.reportedMax, result.estimatedMean,
+               result.estimatedMax, result.uncertaintyMean, result.withinUncertainty * 100);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const Setup setup = {static_cast<uint16_t>(argc > 1 ? atoi(argv[1]) : 200),
+                         static_cast<uint32_t>(argc > 2 ? atof(argv[2]) * 1000 : 5000),
+                         argc > 3 ? static_cast<float>(atof(argv[3])) : 3000.0f,
+                         argc > 4 ? static_cast<uint32_t>(atol(argv[4])) : 1000};
+
+    printf("status report every %u ms, DRO sample every %.1f ms, F%.0f, %u us link latency\n",
+           setup.reportInterval, setup.sampleInterval / 1000.0f, setup.feedRate, setup.latency);
+
+    // Rectangles of 40 x 20 mm: long moves that accelerate and brake at every corner.
+    print("long moves", runJob(setup, 40, [&setup](int i, char *line)
+                               {
+                                   static constexpr float corners[][2] = {{40, 0}, {40, 20}, {0, 20}, {0, 0}};
+                                   snprintf(line, LINE_LENGTH, "G1X%.3fY%.3fF%.0f", corners[i % 4][0],
+                                            corners[i % 4][1], setup.feedRate);
+                               }));
+
+    // An outward spiral of 0.5 mm segments.
+    print("short segments", runJob(setup, 2000, [&setup](int i, char *line)
+                                   {
+                                       const auto radius = 5 + i * 0.002f;
+                                       const auto angle = i * 0.5f / radius;
+                                       snprintf(line, LINE_LENGTH, "G1X%.3fY%.3fF%.0f", radius * std::cos(angle),
+                                                radius * std::sin(angle), setup.feedRate);
+                                   }));
+
+    // Half circles of 10 mm radius, which are not followed, only where they end.
+    print("arcs", runJob(setup, 20, [&setup](int i, char *line)
+                         {
+                             const auto radius = i % 2 == 0 ? 10 : -10;
+                             snprintf(line, LINE_LENGTH, i == 0 ? "G0X10Y0" : "G2X%dY0I%dJ0F%.0f", -radius, -radius,
+                                      setup.feedRate);
+                         }));
+
+    return EXIT_SUCCESS;
+}
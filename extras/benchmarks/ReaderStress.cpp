@@ -0,0 +1,190 @@
+// Feeds status reports and "ok" traffic through a pipe that behaves like a UART with a small receive buffer
+// (bytes arriving while it is full are lost), while the application loop is periodically busy. Runs once
+// with update() polling the stream and once with the reader task, and counts the status reports lost.
+// Usage: reader_stress [seconds] [busy ms] [status reports/s] [oks/s] [uart buffer bytes]
+
+#include "GrblInterface.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+namespace
+{
+    constexpr auto BAUD_RATE = 115200;
+
+    struct Traffic
+    {
+        int seconds;
+        int busyMillis;
+        int statusReportsPerSecond;
+        int oksPerSecond;
+        int uartBufferSize;
+    };
+
+    struct StressResult
+    {
+        uint32_t statusReportsSent;
+        uint32_t statusReportsReceived;
+        uint32_t statusReportsLost;
+        uint32_t bytesDropped;
+    };
+
+    // Writes into the host's end of the pipe at wire speed and drops whatever does not fit the UART buffer.
+    void emulateController(const Traffic &traffic, int toHost, int fromHost, std::atomic<bool> &stop,
+                           StressResult &result)
+    {
+        using Clock = std::chrono::steady_clock;
+        const auto startedAt = Clock::now();
+        const auto bytesPerSecond = BAUD_RATE / 10.0;
+        double lineBudget = 0;
+        double statusBudget = 0;
+        double wireBudget = 0;
+        char line[128];
+        char discard[64];
+
+        while (!stop)
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(500));
+            const auto elapsed = std::chrono::duration<double>(Clock::now() - startedAt).count();
+            wireBudget = std::min(wireBudget + bytesPerSecond * 0.0005, bytesPerSecond * 0.01);
+            statusBudget = traffic.statusReportsPerSecond * elapsed - result.statusReportsSent;
+            lineBudget += traffic.oksPerSecond * 0.0005;
+
+            while (read(fromHost, discard, sizeof(discard)) > 0)
+            {
+            }
+
+            while (statusBudget >= 1 || lineBudget >= 1)
+            {
+                int length;
+
+                if (statusBudget >= 1)
+                {
+                    length = snprintf(line, sizeof(line), "<Run|MPos:%u.000,10.000,-2.500|FS:1200,8000>\r\n",
+                                      ++result.statusReportsSent);
+                    statusBudget--;
+                }
+                else
+                {
+                    length = snprintf(line, sizeof(line), "ok\r\n");
+                    lineBudget--;
+                }
+
+                if (wireBudget < length)
+                {
+                    break;
+                }
+
+                wireBudget -= length;
+
+                int pending = 0;
+                ioctl(toHost, FIONREAD, &pending);
+                const auto room = std::max(0, traffic.uartBufferSize - pending);
+                const auto accepted = std::min(room, length);
+
+                if (accepted > 0)
+                {
+                    (void)write(toHost, line, accepted);
+                }
+
+                result.bytesDropped += length - accepted;
+            }
+        }
+    }
+
+    StressResult run(const Traffic &traffic, bool threaded)
+    {
+        int toHost[2];
+        int fromHost[2];
+
+        if (pipe(toHost) != 0 || pipe(fromHost) != 0)
+        {
+            perror("pipe");
+            exit(EXIT_FAILURE);
+        }
+
+        fcntl(fromHost[0], F_SETFL, O_NONBLOCK);
+
+        StressResult result = {};
+        Grbl::PosixStream stream(toHost[0], fromHost[1]);
+        GrblInterface grbl(stream);
+        uint32_t lastSequence = 0;
+
+        grbl.onPositionUpdate = [&](Grbl::MachineState, Grbl::CoordinateMode)
+        {
+            const auto sequence = static_cast<uint32_t>(std::lround(grbl.getWorkCoordinate(Grbl::Axis::X)));
+            result.statusReportsReceived++;
+            result.statusReportsLost += sequence > lastSequence + 1 ? sequence - lastSequence - 1 : 0;
+            lastSequence = sequence;
+        };
+
+        if (threaded && !grbl.startReaderTask(-1))
+        {
+            fprintf(stderr, "Unable to start the reader task\n");
+            exit(EXIT_FAILURE);
+        }
+
+        std::atomic<bool> stop{false};
+        std::thread controller(emulateController, std::cref(traffic), toHost[1], fromHost[0], std::ref(stop),
+                               std::ref(result));
+
+        const auto endAt = Grbl::Platform::millis() + traffic.seconds * 1000;
+
+        while (Grbl::Platform::millis() < endAt)
+        {
+            // The rest of the application, e.g. redrawing a display or serving a web request.
+            std::this_thread::sleep_for(std::chrono::milliseconds(traffic.busyMillis));
+
+            const auto loopUntil = Grbl::Platform::millis() + 5;
+
+            while (Grbl::Platform::millis() < loopUntil)
+            {
+                grbl.update();
+            }
+        }
+
+        stop = true;
+        controller.join();
+        grbl.stopReaderTask();
+
+        for (const auto fd : {toHost[0], toHost[1], fromHost[0], fromHost[1]})
+        {
+            close(fd);
+        }
+
+        return result;
+    }
+
+    void print(const char *name, const StressResult &result)
+    {
+        printf("%-10s %8u sent %8u received %8u lost (%5.1f%%) %10u bytes dropped\n", name,
+               result.statusReportsSent, result.statusReportsReceived, result.statusReportsLost,
+               100.0 * result.statusReportsLost / std::max(1u, result.statusReportsSent), result.bytesDropped);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    Traffic traffic;
+    traffic.seconds = argc > 1 ? atoi(argv[1]) : 5;
+    traffic.busyMillis = argc > 2 ? atoi(argv[2]) : 250;
+    traffic.statusReportsPerSecond = argc > 3 ? atoi(argv[3]) : 20;
+    traffic.oksPerSecond = argc > 4 ? atoi(argv[4]) : 200;
+    traffic.uartBufferSize = argc > 5 ? atoi(argv[5]) : 256;
+
+    printf("%d s, loop busy for %d ms at a time, %d status reports/s, %d oks/s, %d byte UART buffer\n",
+           traffic.seconds, traffic.busyMillis, traffic.statusReportsPerSecond, traffic.oksPerSecond,
+           traffic.uartBufferSize);
+
+    print("polling", run(traffic, false));
+    print("threaded", run(traffic, true));
+    return EXIT_SUCCESS;
+}
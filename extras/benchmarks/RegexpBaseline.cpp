@@ -0,0 +1,621 @@
+#include "RegexpBaseline.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+    constexpr auto VALUE_SEPARATOR = ',';
+    constexpr auto EOL = '\r';
+
+    namespace RegEx
+    {
+        constexpr auto STATUS_REPORT = "<([%w:%d]+)%|(%w+):([-%d.,]+)[%|]?.*>";
+        constexpr auto FEED_AND_SPEED = "FS:(%-?%d+%.?%d*),(%-?%d+%.?%d*)";
+        constexpr auto LIMIT_SWITCH = "Pn:([A-Z]+)";
+        constexpr auto WORK_COORDINATE_OFFSET = "WCO:([%-?%d+%.?%d*,]*)";
+        constexpr auto OK_RESPONSE = "ok";
+        constexpr auto ALARM_CODE = "ALARM:([%d]+)";
+        constexpr auto ERROR_CODE = "error:([%d]+)";
+    }
+
+    namespace ResponseIndex
+    {
+        constexpr auto STATUS_REPORT_MACHINE_STATE = 0;
+        constexpr auto STATUS_REPORT_POSITION_MODE = 1;
+        constexpr auto STATUS_REPORT_POSITION = 2;
+        constexpr auto STATUS_REPORT_FEED_RATE = 0;
+        constexpr auto STATUS_REPORT_SPINDLE_SPEED = 1;
+        constexpr auto STATUS_REPORT_LIMIT_SWITCH = 0;
+        constexpr auto STATUS_REPORT_WORK_COORDINATE_OFFSET = 0;
+    }
+
+    // The Lua 5.1 pattern matcher as the Regexp library ships it, without the %b, %f and back-reference items
+    // and the character classes other than %a, %d, %s and %w, which the patterns above do not use. Malformed
+    // patterns do not match instead of raising an error.
+    class MatchState
+    {
+    public:
+        void Target(const char *target)
+        {
+            m_source = target;
+            m_sourceEnd = target + strlen(target);
+        }
+
+        int Match(const char *pattern)
+        {
+            const auto anchor = *pattern == '^';
+            const auto p = anchor ? pattern + 1 : pattern;
+            auto s = m_source;
+
+            do
+            {
+                m_level = 0;
+
+                if (match(s, p) != nullptr)
+                {
+                    return 1;
+                }
+            } while (s++ < m_sourceEnd && !anchor);
+
+            return 0;
+        }
+
+        void GetCapture(char *buffer, int index) const
+        {
+            const auto length = m_captures[index].length < 0 ? 0 : m_captures[index].length;
+            memcpy(buffer, m_captures[index].init, length);
+            buffer[length] = '\0';
+        }
+
+    private:
+        static constexpr auto MAX_CAPTURES = 32;
+        static constexpr auto CAPTURE_UNFINISHED = -1;
+        static constexpr auto CAPTURE_POSITION = -2;
+        static constexpr auto ESCAPE = '%';
+
+        struct Capture
+        {
+            const char *init;
+            ptrdiff_t length;
+        };
+
+        const char *m_source = nullptr;
+        const char *m_sourceEnd = nullptr;
+        int m_level = 0;
+        Capture m_captures[MAX_CAPTURES] = {};
+
+        static const char *classEnd(const char *p)
+        {
+            switch (*p++)
+            {
+            case ESCAPE:
+            {
+                return *p == '\0' ? nullptr : p + 1;
+            }
+            case '[':
+            {
+                if (*p == '^')
+                {
+                    p++;
+                }
+
+                do
+                {
+                    if (*p == '\0')
+                    {
+                        return nullptr;
+                    }
+
+                    if (*(p++) == ESCAPE && *p != '\0')
+                    {
+                        p++;
+                    }
+                } while (*p != ']');
+
+                return p + 1;
+            }
+            default:
+            {
+                return p;
+            }
+            }
+        }
+
+        static bool matchClass(int c, int cl)
+        {
+            bool result;
+
+            switch (tolower(cl))
+            {
+            case 'a':
+            {
+                result = isalpha(c);
+                break;
+            }
+            case 'd':
+            {
+                result = isdigit(c);
+                break;
+            }
+            case 's':
+            {
+                result = isspace(c);
+                break;
+            }
+            case 'w':
+            {
+                result = isalnum(c);
+                break;
+            }
+            default:
+            {
+                return cl == c;
+            }
+            }
+
+            return islower(cl) ? result : !result;
+        }
+
+        static bool matchBracketClass(int c, const char *p, const char *ec)
+        {
+            auto sig = true;
+
+            if (*(p + 1) == '^')
+            {
+                sig = false;
+                p++;
+            }
+
+            while (++p < ec)
+            {
+                if (*p == ESCAPE)
+                {
+                    p++;
+
+                    if (matchClass(c, static_cast<unsigned char>(*p)))
+                    {
+                        return sig;
+                    }
+                }
+                else if (*(p + 1) == '-' && p + 2 < ec)
+                {
+                    p += 2;
+
+                    if (static_cast<unsigned char>(*(p - 2)) <= c && c <= static_cast<unsigned char>(*p))
+                    {
+                        return sig;
+                    }
+                }
+                else if (static_cast<unsigned char>(*p) == c)
+                {
+                    return sig;
+                }
+            }
+
+            return !sig;
+        }
+
+        static bool singleMatch(int c, const char *p, const char *ep)
+        {
+            switch (*p)
+            {
+            case '.':
+            {
+                return true;
+            }
+            case ESCAPE:
+            {
+                return matchClass(c, static_cast<unsigned char>(*(p + 1)));
+            }
+            case '[':
+            {
+                return matchBracketClass(c, p, ep - 1);
+            }
+            default:
+            {
+                return static_cast<unsigned char>(*p) == c;
+            }
+            }
+        }
+
+        const char *maxExpand(const char *s, const char *p, const char *ep)
+        {
+            ptrdiff_t i = 0;
+
+            while (s + i < m_sourceEnd && singleMatch(static_cast<unsigned char>(*(s + i)), p, ep))
+            {
+                i++;
+            }
+
+            for (; i >= 0; i--)
+            {
+                if (const auto result = match(s + i, ep + 1))
+                {
+                    return result;
+                }
+            }
+
+            return nullptr;
+        }
+
+        const char *minExpand(const char *s, const char *p, const char *ep)
+        {
+            for (;;)
+            {
+                if (const auto result = match(s, ep + 1))
+                {
+                    return result;
+                }
+
+                if (s < m_sourceEnd && singleMatch(static_cast<unsigned char>(*s), p, ep))
+                {
+                    s++;
+                }
+                else
+                {
+                    return nullptr;
+                }
+            }
+        }
+
+        const char *startCapture(const char *s, const char *p, ptrdiff_t what)
+        {
+            if (m_level >= MAX_CAPTURES)
+            {
+                return nullptr;
+            }
+
+            m_captures[m_level].init = s;
+            m_captures[m_level].length = what;
+            m_level++;
+            const auto result = match(s, p);
+
+            if (result == nullptr)
+            {
+                m_level--;
+            }
+
+            return result;
+        }
+
+        const char *endCapture(const char *s, const char *p)
+        {
+            auto level = m_level - 1;
+
+            while (level >= 0 && m_captures[level].length != CAPTURE_UNFINISHED)
+            {
+                level--;
+            }
+
+            if (level < 0)
+            {
+                return nullptr;
+            }
+
+            m_captures[level].length = s - m_captures[level].init;
+            const auto result = match(s, p);
+
+            if (result == nullptr)
+            {
+                m_captures[level].length = CAPTURE_UNFINISHED;
+            }
+
+            return result;
+        }
+
+        const char *match(const char *s, const char *p)
+        {
+            for (;;)
+            {
+                switch (*p)
+                {
+                case '(':
+                {
+                    return *(p + 1) == ')' ? startCapture(s, p + 2, CAPTURE_POSITION)
+                                           : startCapture(s, p + 1, CAPTURE_UNFINISHED);
+                }
+                case ')':
+                {
+                    return endCapture(s, p + 1);
+                }
+                case '\0':
+                {
+                    return s;
+                }
+                case '$':
+                {
+                    if (*(p + 1) == '\0')
+                    {
+                        return s == m_sourceEnd ? s : nullptr;
+                    }
+
+                    break;
+                }
+                default:
+                {
+                    break;
+                }
+                }
+
+                const auto ep = classEnd(p);
+
+                if (ep == nullptr)
+                {
+                    return nullptr;
+                }
+
+                const auto matched = s < m_sourceEnd && singleMatch(static_cast<unsigned char>(*s), p, ep);
+
+                switch (*ep)
+                {
+                case '?':
+                {
+                    if (matched)
+                    {
+                        if (const auto result = match(s + 1, ep + 1))
+                        {
+                            return result;
+                        }
+                    }
+
+                    p = ep + 1;
+                    continue;
+                }
+                case '*':
+                {
+                    return maxExpand(s, p, ep);
+                }
+                case '+':
+                {
+                    return matched ? maxExpand(s + 1, p, ep) : nullptr;
+                }
+                case '-':
+                {
+                    return minExpand(s, p, ep);
+                }
+                default:
+                {
+                    if (!matched)
+                    {
+                        return nullptr;
+                    }
+
+                    s++;
+                    p = ep;
+                    continue;
+                }
+                }
+            }
+        }
+    };
+
+    Grbl::MachineState getMachineState(const char *state)
+    {
+        for (size_t i = 0; i < Grbl::machineStates.size(); i++)
+        {
+            if (strcmp(state, Grbl::machineStates[i]) == 0)
+            {
+                return static_cast<Grbl::MachineState>(i);
+            }
+        }
+
+        return Grbl::MachineState::Unknown;
+    }
+
+    Grbl::CoordinateMode getCoordinateMode(const char *coordinateMode)
+    {
+        for (size_t i = 0; i < Grbl::coordinateModes.size(); i++)
+        {
+            if (strcmp(coordinateMode, Grbl::coordinateModes[i]) == 0)
+            {
+                return static_cast<Grbl::CoordinateMode>(i);
+            }
+        }
+
+        return Grbl::CoordinateMode::Unknown;
+    }
+
+    void extractPosition(const char *positionString, Coordinate *positionArray)
+    {
+        std::string pos(positionString);
+        std::string position;
+        std::stringstream ss(pos);
+        const auto numberOfAxes = std::count(pos.begin(), pos.end(), VALUE_SEPARATOR) + 1;
+
+        if (numberOfAxes > Grbl::MAX_NUMBER_OF_AXES)
+        {
+            return;
+        }
+
+        for (auto i = 0; i < numberOfAxes; i++)
+        {
+            std::getline(ss, position, VALUE_SEPARATOR);
+
+            if (!position.empty())
+            {
+                try
+                {
+                    (*positionArray)[i] = std::stof(position);
+                }
+                catch (std::invalid_argument &)
+                {
+                    return;
+                }
+            }
+        }
+    }
+}
+
+RegexpBaseline::RegexpBaseline(Grbl::ByteStream &stream)
+    : m_stream(&stream),
+      m_machineState(Grbl::MachineState::Unknown),
+      m_workCoordinate{},
+      m_workCoordinateOffset{},
+      m_currentFeedRate(0),
+      m_currentSpindleSpeed(0),
+      m_currentAlarm(Grbl::Alarm::None),
+      m_currentError(Grbl::Error::None)
+{
+}
+
+void RegexpBaseline::update(uint16_t timeout)
+{
+    if (!m_stream->available())
+    {
+        return;
+    }
+
+    const auto timeoutAt = Grbl::Platform::millis() + timeout;
+    std::stringstream ss;
+
+    while (m_stream->available() && Grbl::Platform::millis() < timeoutAt)
+    {
+        const char c = m_stream->read();
+
+        if (c == EOL)
+        {
+            m_buffer.append(ss.str());
+            processBuffer();
+            return;
+        }
+
+        ss << c;
+    }
+
+    if (!ss.str().empty())
+    {
+        m_buffer.append(ss.str());
+    }
+}
+
+Grbl::MachineState RegexpBaseline::machineState() const
+{
+    return m_machineState;
+}
+
+const Coordinate &RegexpBaseline::workCoordinate() const
+{
+    return m_workCoordinate;
+}
+
+// --------------------------------------------------------------------------------------------------
+// Private methods
+// --------------------------------------------------------------------------------------------------
+
+void RegexpBaseline::processBuffer()
+{
+    static MatchState ms;
+    char buffer[Grbl::RECEIVED_LINE_SIZE];
+    char tempBuffer[Grbl::RECEIVED_LINE_SIZE];
+
+    // An unknown state used to leave the line in the buffer, so the next one was appended to it. Kept, but
+    // bounded.
+    if (m_buffer.length() >= sizeof(buffer))
+    {
+        m_buffer.clear();
+        return;
+    }
+
+    strcpy(buffer, m_buffer.c_str());
+    ms.Target(buffer);
+
+    if (ms.Match(RegEx::FEED_AND_SPEED) > 0)
+    {
+        ms.GetCapture(tempBuffer, ResponseIndex::STATUS_REPORT_FEED_RATE);
+        m_currentFeedRate = atof(tempBuffer);
+        ms.GetCapture(tempBuffer, ResponseIndex::STATUS_REPORT_SPINDLE_SPEED);
+        m_currentSpindleSpeed = atof(tempBuffer);
+    }
+
+    if (ms.Match(RegEx::WORK_COORDINATE_OFFSET) > 0)
+    {
+        ms.GetCapture(tempBuffer, ResponseIndex::STATUS_REPORT_WORK_COORDINATE_OFFSET);
+        extractPosition(tempBuffer, &m_workCoordinateOffset);
+    }
+
+    if (ms.Match(RegEx::STATUS_REPORT) > 0)
+    {
+        ms.GetCapture(tempBuffer, ResponseIndex::STATUS_REPORT_MACHINE_STATE);
+        auto machineState = getMachineState(tempBuffer);
+
+        if (machineState == Grbl::MachineState::Unknown)
+        {
+            return;
+        }
+
+        m_machineState = machineState;
+        ms.GetCapture(tempBuffer, ResponseIndex::STATUS_REPORT_POSITION_MODE);
+        auto coordinateMode = getCoordinateMode(tempBuffer);
+
+        if (coordinateMode == Grbl::CoordinateMode::Unknown)
+        {
+            return;
+        }
+
+        ms.GetCapture(tempBuffer, ResponseIndex::STATUS_REPORT_POSITION);
+        extractPosition(tempBuffer, &m_workCoordinate);
+
+        if (coordinateMode == Grbl::CoordinateMode::Machine)
+        {
+            for (auto i = 0; i < Grbl::MAX_NUMBER_OF_AXES; i++)
+            {
+                m_workCoordinate[i] = m_workCoordinate[i] - m_workCoordinateOffset[i];
+            }
+        }
+
+        m_limitSwitchesTriggered.clear();
+
+        if (ms.Match(RegEx::LIMIT_SWITCH) > 0)
+        {
+            ms.GetCapture(tempBuffer, ResponseIndex::STATUS_REPORT_LIMIT_SWITCH);
+
+            for (auto i = 0; i < Grbl::MAX_NUMBER_OF_AXES; i++)
+            {
+                for (const auto c : tempBuffer)
+                {
+                    if (c == Grbl::axes[i])
+                    {
+                        m_limitSwitchesTriggered.push_back(static_cast<Grbl::Axis>(i));
+                    }
+                }
+            }
+        }
+    }
+
+    (void)ms.Match(RegEx::OK_RESPONSE);
+
+    if (ms.Match(RegEx::ALARM_CODE) > 0)
+    {
+        ms.GetCapture(tempBuffer, 0);
+
+        try
+        {
+            m_currentAlarm = static_cast<Grbl::Alarm>(std::stoi(tempBuffer));
+        }
+        catch (std::invalid_argument &)
+        {
+            return;
+        }
+    }
+
+    if (ms.Match(RegEx::ERROR_CODE) > 0)
+    {
+        ms.GetCapture(tempBuffer, 0);
+
+        try
+        {
+            m_currentError = static_cast<Grbl::Error>(std::stoi(tempBuffer));
+        }
+        catch (std::invalid_argument &)
+        {
+            return;
+        }
+    }
+
+    m_buffer.clear();
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "GrblInterface.h"
+
+#include <string>
+#include <vector>
+
+// The response handling GrblInterface had before Grbl::Parser, kept to benchmark the parser against. Lines are
+// read as before and matched against the same Lua patterns, by a port of the matcher of the Regexp library
+// (Lua 5.1's lstrlib) that GrblInterface depended on then.
+class RegexpBaseline
+{
+public:
+    explicit RegexpBaseline(Grbl::ByteStream &stream);
+
+    // Returns after each complete line, like GrblInterface::update().
+    void update(uint16_t timeout = Grbl::DEFAULT_TIMEOUT_MS);
+
+    [[nodiscard]] Grbl::MachineState machineState() const;
+    [[nodiscard]] const Coordinate &workCoordinate() const;
+
+private:
+    Grbl::ByteStream *m_stream;
+    std::string m_buffer;
+    Grbl::MachineState m_machineState;
+    Coordinate m_workCoordinate;
+    Coordinate m_workCoordinateOffset;
+    float m_currentFeedRate;
+    float m_currentSpindleSpeed;
+    Grbl::Alarm m_currentAlarm;
+    Grbl::Error m_currentError;
+    std::vector<Grbl::Axis> m_limitSwitchesTriggered;
+
+    void processBuffer();
+};
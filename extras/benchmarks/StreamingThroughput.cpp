@@ -0,0 +1,137 @@
+// Runs the same short-segment job through the simulated controller with send-and-wait, with character-counting
+// streaming, with streaming plus modal-state tracking and compact emission, and with planner flow control on
+// top, and reports virtual job time, lines per second and bytes per line for each. Motion stops show how
+// smoothly the job ran, the moves queued ahead (planner blocks plus lines in flight, averaged over the job)
+// how long a stop would take to take effect. Fails if planner flow control queues as many moves as character
+// counting does with the same lines.
+// Usage: streaming_throughput [segments] [segment length mm] [feed rate mm/min] [link latency us]
+
+#include "GrblInterface.h"
+#include "GrblSimulator.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+    struct JobResult
+    {
+        double seconds;
+        uint32_t linesAcknowledged;
+        float bytesPerLine;
+        float queuedAhead;
+        Grbl::SimulatorStatistics simulator;
+    };
+
+    struct JobOptions
+    {
+        bool streaming;
+        bool modalStateTracking;
+        bool compactEmission;
+        bool plannerFlowControl;
+    };
+
+    JobResult runJob(const JobOptions &options, int segments, float segmentLength, float feedRate, uint32_t latency)
+    {
+        Grbl::SimulatorConfiguration configuration;
+        configuration.latencyMicros = latency;
+        Grbl::GrblSimulator simulator(configuration);
+        Grbl::Platform::setClockSource([&simulator]
+                                       { return simulator.micros(); });
+
+        GrblInterface grbl(simulator);
+        grbl.setStreamingMode(options.streaming);
+        grbl.setModalStateTracking(options.modalStateTracking);
+        grbl.setCompactEmission(options.compactEmission);
+        grbl.setPlannerFlowControl(options.plannerFlowControl);
+
+        // Feed rates are only left out once G94 is known to be active.
+        if (options.modalStateTracking)
+        {
+            (void)grbl.requestParserState();
+            (void)grbl.waitForStreamToDrain(Grbl::DEFAULT_COMMAND_TIMEOUT_MS);
+        }
+
+        uint32_t linesAcknowledged = 0;
+        grbl.onCommandCompleted = [&linesAcknowledged](Grbl::Ticket, Grbl::CommandStatus, Grbl::Error)
+        {
+            linesAcknowledged++;
+        };
+
+        // A polyline spiralling outwards, so consecutive segments never line up into one long move.
+        float angle = 0;
+        float radius = 5;
+        uint64_t queuedAhead = 0;
+
+        for (auto i = 0; i < segments; i++)
+        {
+            angle += segmentLength / radius;
+            radius += 0.001f;
+
+            if (!grbl.linearInterpolationPositioning(feedRate, {{Grbl::Axis::X, radius * std::cos(angle)},
+                                                                {Grbl::Axis::Y, radius * std::sin(angle)}}))
+            {
+                fprintf(stderr, "Segment %d was not acknowledged in time\n", i);
+            }
+
+            queuedAhead += simulator.plannerBlocksQueued() + grbl.linesInFlight();
+        }
+
+        while (!simulator.isIdle() || grbl.linesInFlight() > 0)
+        {
+            grbl.update();
+        }
+
+        const auto statistics = grbl.getStreamingStatistics();
+        const JobResult result = {simulator.micros() / 1e6, linesAcknowledged,
+                                  static_cast<float>(statistics.bytesSent) / statistics.linesSent,
+                                  static_cast<float>(queuedAhead) / segments,
+                                  simulator.statistics()};
+        Grbl::Platform::setClockSource({});
+        return result;
+    }
+
+    void print(const char *name, const JobResult &result)
+    {
+        printf("%-24s %10.2f s %12.1f lines/s %8.1f bytes/line %10u stops %8.1f queued %8u errors %8u overflows\n",
+               name, result.seconds, result.linesAcknowledged / result.seconds, result.bytesPerLine,
+               result.simulator.motionStops, result.queuedAhead, result.simulator.errorResponses, result.simulator.rxOverflows);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const auto segments = argc > 1 ? atoi(argv[1]) : 2000;
+    const auto segmentLength = argc > 2 ? static_cast<float>(atof(argv[2])) : 0.1f;
+    const auto feedRate = argc > 3 ? static_cast<float>(atof(argv[3])) : 3000.0f;
+    const auto latency = argc > 4 ? static_cast<uint32_t>(atol(argv[4])) : 1000;
+
+    printf("%d segments of %.3f mm at F%.0f, %u us link latency, ideal job time %.2f s\n",
+           segments, segmentLength, feedRate, latency, segments * segmentLength / feedRate * 60);
+
+    const auto sendAndWait = runJob({false, false, false, false}, segments, segmentLength, feedRate, latency);
+    const auto streaming = runJob({true, false, false, false}, segments, segmentLength, feedRate, latency);
+    const auto modal = runJob({true, true, false, false}, segments, segmentLength, feedRate, latency);
+    const auto compact = runJob({true, true, true, false}, segments, segmentLength, feedRate, latency);
+    const auto planner = runJob({true, true, true, true}, segments, segmentLength, feedRate, latency);
+
+    print("send-and-wait", sendAndWait);
+    print("character-counting", streaming);
+    print("+ modal tracking", modal);
+    print("+ compact emission", compact);
+    print("+ planner flow control", planner);
+    printf("speed-up: %.2fx streaming, %.2fx modal, %.2fx compact, %.2fx planner flow control\n",
+           sendAndWait.seconds / streaming.seconds, sendAndWait.seconds / modal.seconds,
+           sendAndWait.seconds / compact.seconds, sendAndWait.seconds / planner.seconds);
+    printf("queued ahead: %.1f with planner flow control, %.1f with character counting of the same lines, "
+           "%.1f of full lines\n", planner.queuedAhead, compact.queuedAhead, streaming.queuedAhead);
+
+    if (planner.queuedAhead >= compact.queuedAhead)
+    {
+        fprintf(stderr, "Planner flow control queued no fewer moves than character counting\n");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,66 @@
+// Host counterpart of the BasicUsage example: connects to a Grbl controller over a serial device
+// and prints the state, position and feed rate whenever they change, and every alarm and error.
+// Usage: grbl_monitor /dev/ttyUSB0 [baud rate]
+
+#include "GrblInterface.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "Usage: %s <serial device> [baud rate]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const auto baudRate = argc > 2 ? static_cast<uint32_t>(atol(argv[2])) : 115200;
+    Grbl::PosixStream stream(argv[1], baudRate);
+
+    if (!stream.isOpen())
+    {
+        fprintf(stderr, "Unable to open %s\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    GrblInterface grbl(stream);
+
+    const auto printed = static_cast<uint16_t>(Grbl::StatusChange::State) |
+                         static_cast<uint16_t>(Grbl::StatusChange::Position) |
+                         static_cast<uint16_t>(Grbl::StatusChange::FeedAndSpeed);
+
+    (void)grbl.subscribe(printed, [&grbl](uint16_t, const StatusSnapshot &, const StatusSnapshot &current)
+                         {
+                             printf("%s %s", grbl.getMachineState(current.machineState),
+                                    grbl.getCoordinateMode(current.coordinateMode));
+
+                             for (const auto &coordinate : current.workPosition)
+                             {
+                                 printf(" %.3f", coordinate);
+                             }
+
+                             printf(" F%.0f S%.0f\n", current.feedRate, current.spindleSpeed);
+                         });
+
+    const auto events = static_cast<uint16_t>(Grbl::StatusChange::Alarm) |
+                        static_cast<uint16_t>(Grbl::StatusChange::Error);
+
+    (void)grbl.subscribe(events, [](uint16_t changes, const StatusSnapshot &, const StatusSnapshot &current)
+                         {
+                             if ((changes & static_cast<uint16_t>(Grbl::StatusChange::Alarm)) != 0)
+                             {
+                                 printf("ALARM:%u\n", static_cast<unsigned>(current.alarm));
+                             }
+
+                             if ((changes & static_cast<uint16_t>(Grbl::StatusChange::Error)) != 0)
+                             {
+                                 printf("error:%u\n", static_cast<unsigned>(current.error));
+                             }
+                         });
+
+    while (true)
+    {
+        grbl.update();
+    }
+}
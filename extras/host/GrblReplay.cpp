@@ -0,0 +1,197 @@
+// Plays a traffic log written by Grbl::TrafficRecorder (e.g. by grbl_send --record) back through
+// GrblInterface. The recorded commands are issued again when the log reaches them, the recorded responses
+// arrive at their original pace or, with --fast, as fast as they are parsed on the log's virtual clock.
+// Usage: grbl_replay <log> [--fast] [--verbose]
+
+#include "GrblInterface.h"
+#include "TrafficLog.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <string>
+
+namespace
+{
+    constexpr auto DRAIN_TIMEOUT_MS = 5000;
+
+    struct Outcome
+    {
+        uint32_t ok;
+        uint32_t errors;
+        uint32_t timeouts;
+        uint32_t cancelled;
+    };
+
+    [[nodiscard]] bool isRealtimeCommand(uint8_t byte)
+    {
+        return byte == '?' || byte == '!' || byte == '~' || byte == 0x18 || byte >= 0x80;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "Usage: %s <log> [--fast] [--verbose]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    auto fast = false;
+    auto verbose = false;
+
+    for (auto i = 2; i < argc; i++)
+    {
+        fast = fast || strcmp(argv[i], "--fast") == 0;
+        verbose = verbose || strcmp(argv[i], "--verbose") == 0;
+    }
+
+    std::ifstream file(argv[1], std::ios::binary);
+
+    if (!file)
+    {
+        fprintf(stderr, "Unable to open %s\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    Grbl::IstreamSource source(file);
+    Grbl::TrafficReplay replay(source, !fast);
+
+    if (!replay.valid())
+    {
+        fprintf(stderr, "%s is not a traffic log\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    if (fast)
+    {
+        Grbl::Platform::setClockSource([&replay]
+                                       { return replay.micros(); });
+    }
+
+    GrblInterface grbl(replay);
+    grbl.setAutomaticStatusReports(false); // The recorded status reports arrive anyway.
+    grbl.setAsynchronousMode(true);
+    grbl.setStreamingMode(true);
+
+    // Sent records are split into lines and realtime commands, and issued once update() has returned.
+    std::string sent;
+    std::string line;
+    std::deque<std::string> lines;
+    replay.onSent = [&sent](const Grbl::TrafficRecord &record)
+    {
+        sent.append(reinterpret_cast<const char *>(record.data), record.length);
+    };
+
+    Outcome outcome{};
+    grbl.onCommandCompleted = [&outcome, &replay, verbose](Grbl::Ticket ticket, Grbl::CommandStatus status,
+                                                          Grbl::Error error)
+    {
+        switch (status)
+        {
+        case Grbl::CommandStatus::Ok:
+        {
+            outcome.ok++;
+            return;
+        }
+        case Grbl::CommandStatus::Error:
+        {
+            outcome.errors++;
+            break;
+        }
+        case Grbl::CommandStatus::Timeout:
+        {
+            outcome.timeouts++;
+            break;
+        }
+        default:
+        {
+            outcome.cancelled++;
+            break;
+        }
+        }
+
+        if (verbose)
+        {
+            printf("%10.3f s command %u failed with status %d, error %d\n", replay.micros() / 1e6, ticket,
+                   static_cast<int>(status), static_cast<int>(error));
+        }
+    };
+
+    grbl.onPositionUpdate = [&grbl, &replay, verbose](Grbl::MachineState machineState, Grbl::CoordinateMode)
+    {
+        if (verbose)
+        {
+            const auto &position = grbl.getMachineCoordinate();
+            printf("%10.3f s %-5s", replay.micros() / 1e6, grbl.getMachineState(machineState));
+
+            for (const auto coordinate : position)
+            {
+                printf(" %9.3f", coordinate);
+            }
+
+            printf("\n");
+        }
+    };
+
+    const auto issue = [&]
+    {
+        for (const auto c : sent)
+        {
+            if (isRealtimeCommand(static_cast<uint8_t>(c)))
+            {
+                grbl.sendRealtimeCommand(static_cast<Grbl::RealtimeCommand>(c));
+            }
+            else if (c == '\n')
+            {
+                lines.push_back(line);
+                line.clear();
+            }
+            else if (c != '\r')
+            {
+                line += c;
+            }
+        }
+
+        sent.clear();
+
+        while (!lines.empty() && grbl.sendLine(lines.front().c_str()) != Grbl::INVALID_TICKET)
+        {
+            lines.pop_front();
+        }
+    };
+
+    while (!replay.finished() || !sent.empty() || !lines.empty())
+    {
+        grbl.update();
+        issue();
+    }
+
+    const auto logEnd = replay.micros();
+    (void)grbl.waitForStreamToDrain(DRAIN_TIMEOUT_MS); // Lines Grbl had not answered when the log ended.
+
+    printf("%.3f s of traffic, %u records, %u mismatches between the log and what was sent\n", logEnd / 1e6,
+           replay.recordsPlayed(), replay.mismatches());
+    printf("commands: %u ok, %u errors, %u timeouts, %u cancelled, %zu unanswered at the end\n", outcome.ok,
+           outcome.errors, outcome.timeouts, outcome.cancelled, grbl.linesInFlight());
+    printf("final state %s, alarm %d, error %d, machine position", grbl.getMachineState(grbl.currentMachineState()),
+           static_cast<int>(grbl.currentAlarm()), static_cast<int>(grbl.currentError()));
+
+    for (const auto coordinate : grbl.getMachineCoordinate())
+    {
+        printf(" %.3f", coordinate);
+    }
+
+    printf("\n");
+
+#if !defined(GRBL_INTERFACE_NO_STATS)
+    const auto stats = grbl.getStats();
+    printf("parsing %u lines: %u us mean, %u us max\n", stats.linesReceived, stats.parseTime.mean(),
+           stats.parseTime.maximum());
+#endif
+
+    Grbl::Platform::setClockSource({});
+    return replay.mismatches() == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
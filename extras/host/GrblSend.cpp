@@ -0,0 +1,189 @@
+// Streams a G-code file to a Grbl controller and prints the progress once per second, and the link metrics
+// at the end. Without a serial device the program runs against the simulated controller instead. --record
+// writes the traffic to a log that grbl_replay plays back.
+// Usage: grbl_send [--record <log>] <file> [serial device] [baud rate]
+
+#include "GrblSimulator.h"
+#include "JobRunner.h"
+#include "TrafficLog.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+
+namespace
+{
+    constexpr auto PROGRESS_INTERVAL_MS = 1000;
+
+    const char *getJobState(JobState state)
+    {
+        switch (state)
+        {
+        case JobState::Idle:
+        {
+            return "Idle";
+        }
+        case JobState::Running:
+        {
+            return "Running";
+        }
+        case JobState::Paused:
+        {
+            return "Paused";
+        }
+        case JobState::Completed:
+        {
+            return "Completed";
+        }
+        case JobState::Aborted:
+        {
+            return "Aborted";
+        }
+        case JobState::Failed:
+        {
+            return "Failed";
+        }
+        }
+
+        return "";
+    }
+
+    void printProgress(JobRunner &job)
+    {
+        const auto progress = job.progress();
+        printf("%-9s %8u/%u bytes %7u lines sent %7u done %4u errors %8.1f lines/s ETA %6.1f s\n",
+               getJobState(job.state()), progress.bytesRead, progress.totalBytes, progress.linesSent,
+               progress.linesCompleted, progress.errors, progress.linesPerSecond, progress.remainingMillis / 1000.0);
+    }
+
+#if !defined(GRBL_INTERFACE_NO_STATS)
+    void printStats(GrblInterface &grbl)
+    {
+        const auto stats = grbl.getStats();
+        printf("link      %8.0f B/s sent %8.0f B/s received %8.1f lines/s received, %u dropped\n",
+               stats.txBytesPerSecond, stats.rxBytesPerSecond, stats.linesReceivedPerSecond, stats.linesDropped);
+        printf("ok after  %8u us median %8u us p99 %8u us max\n", stats.roundTripTime.percentile(0.5f),
+               stats.roundTripTime.percentile(0.99f), stats.roundTripTime.maximum());
+        printf("parsing   %8u us median %8u us p99 %8u us max\n", stats.parseTime.percentile(0.5f),
+               stats.parseTime.percentile(0.99f), stats.parseTime.maximum());
+        printf("reports   %8u us mean interval %8.0f us jitter %8u us max, %u received\n",
+               stats.statusReportInterval.mean(), stats.statusReportJitter, stats.statusReportInterval.maximum(),
+               stats.statusReports);
+        printf("failures  %8u timeouts %8u errors %8u alarms\n", stats.timeouts, stats.errors, stats.alarms);
+    }
+#endif
+}
+
+int main(int argc, char *argv[])
+{
+    const auto program = argv[0];
+    const char *logPath = nullptr;
+
+    if (argc > 2 && strcmp(argv[1], "--record") == 0)
+    {
+        logPath = argv[2];
+        argv += 2;
+        argc -= 2;
+    }
+
+    if (argc < 2)
+    {
+        fprintf(stderr, "Usage: %s [--record <log>] <file> [serial device] [baud rate]\n", program);
+        return EXIT_FAILURE;
+    }
+
+    std::ifstream file(argv[1], std::ios::binary);
+
+    if (!file)
+    {
+        fprintf(stderr, "Unable to open %s\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    std::unique_ptr<Grbl::ByteStream> stream;
+
+    if (argc > 2)
+    {
+        const auto baudRate = argc > 3 ? static_cast<uint32_t>(atol(argv[3])) : 115200;
+        auto serial = std::make_unique<Grbl::PosixStream>(argv[2], baudRate);
+
+        if (!serial->isOpen())
+        {
+            fprintf(stderr, "Unable to open %s\n", argv[2]);
+            return EXIT_FAILURE;
+        }
+
+        stream = std::move(serial);
+    }
+    else
+    {
+        auto simulator = std::make_unique<Grbl::GrblSimulator>();
+        Grbl::Platform::setClockSource([controller = simulator.get()]
+                                       { return controller->micros(); });
+        stream = std::move(simulator);
+    }
+
+    std::ofstream logFile;
+    std::unique_ptr<Grbl::OstreamSink> logSink;
+    std::unique_ptr<Grbl::TrafficRecorder> recorder;
+    std::unique_ptr<Grbl::RecordingStream> recordingStream;
+
+    if (logPath != nullptr)
+    {
+        logFile.open(logPath, std::ios::binary);
+
+        if (!logFile)
+        {
+            fprintf(stderr, "Unable to create %s\n", logPath);
+            return EXIT_FAILURE;
+        }
+
+        logSink = std::make_unique<Grbl::OstreamSink>(logFile);
+        recorder = std::make_unique<Grbl::TrafficRecorder>(*logSink);
+        recordingStream = std::make_unique<Grbl::RecordingStream>(*stream, *recorder);
+    }
+
+    GrblInterface grbl(recordingStream ? *recordingStream : *stream);
+    JobRunner job(grbl);
+    Grbl::IstreamSource source(file);
+
+    if (!job.start(source))
+    {
+        fprintf(stderr, "Unable to start the job\n");
+        return EXIT_FAILURE;
+    }
+
+    auto nextProgressAt = Grbl::Platform::millis();
+
+    while (job.state() == JobState::Running)
+    {
+        job.update();
+
+        if (Grbl::Platform::millis() - nextProgressAt < UINT32_MAX / 2)
+        {
+            printProgress(job);
+            nextProgressAt += PROGRESS_INTERVAL_MS;
+        }
+    }
+
+    printProgress(job);
+
+    if (recorder)
+    {
+        recorder->flush();
+    }
+
+#if !defined(GRBL_INTERFACE_NO_STATS)
+    printStats(grbl);
+#endif
+
+    if (job.progress().failedLine != 0)
+    {
+        fprintf(stderr, "First error on line %u\n", job.progress().failedLine);
+    }
+
+    Grbl::Platform::setClockSource({});
+    return job.state() == JobState::Completed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
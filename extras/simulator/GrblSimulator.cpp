@@ -0,0 +1,1266 @@
+#include "GrblSimulator.h"
+#include "GrblParser.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+    constexpr auto LINE_BUFFER_SIZE = 80;
+    constexpr auto MAX_STEP_MICROS = 1000;
+    constexpr auto BITS_PER_BYTE = 10; // 8N1 framing.
+    constexpr auto MM_PER_INCH = 25.4f;
+    constexpr auto MIN_OVERRIDE = 10;
+    constexpr auto MAX_OVERRIDE = 200;
+    constexpr auto WELCOME_MESSAGE = "Grbl 1.1h ['$' for help]";
+
+    namespace Realtime
+    {
+        constexpr uint8_t STATUS_REPORT = '?';
+        constexpr uint8_t FEED_HOLD = '!';
+        constexpr uint8_t CYCLE_START = '~';
+        constexpr uint8_t SOFT_RESET = 0x18;
+        constexpr uint8_t SAFETY_DOOR = 0x84;
+        constexpr uint8_t JOG_CANCEL = 0x85;
+        constexpr uint8_t FEED_OVERRIDE_RESET = 0x90;
+        constexpr uint8_t FEED_OVERRIDE_COARSE_PLUS = 0x91;
+        constexpr uint8_t FEED_OVERRIDE_COARSE_MINUS = 0x92;
+        constexpr uint8_t FEED_OVERRIDE_FINE_PLUS = 0x93;
+        constexpr uint8_t FEED_OVERRIDE_FINE_MINUS = 0x94;
+        constexpr uint8_t RAPID_OVERRIDE_RESET = 0x95;
+        constexpr uint8_t RAPID_OVERRIDE_MEDIUM = 0x96;
+        constexpr uint8_t RAPID_OVERRIDE_LOW = 0x97;
+        constexpr uint8_t SPINDLE_OVERRIDE_RESET = 0x99;
+        constexpr uint8_t SPINDLE_OVERRIDE_COARSE_PLUS = 0x9A;
+        constexpr uint8_t SPINDLE_OVERRIDE_COARSE_MINUS = 0x9B;
+        constexpr uint8_t SPINDLE_OVERRIDE_FINE_PLUS = 0x9C;
+        constexpr uint8_t SPINDLE_OVERRIDE_FINE_MINUS = 0x9D;
+        constexpr uint8_t SPINDLE_STOP = 0x9E;
+        constexpr uint8_t FLOOD_COOLANT = 0xA0;
+        constexpr uint8_t MIST_COOLANT = 0xA1;
+    }
+
+    struct Word
+    {
+        char letter;
+        float value;
+    };
+
+    [[nodiscard]] Grbl::Error parseWords(const std::string &line, std::vector<Word> &words)
+    {
+        auto cursor = line.c_str();
+
+        while (*cursor != '\0')
+        {
+            const auto letter = *cursor++;
+
+            if (letter < 'A' || letter > 'Z')
+            {
+                return Grbl::Error::ExpectedGCodeCommandLetter;
+            }
+
+            // Like Grbl's read_float(): no exponents or hex, which strtof() would read out of e.g. "G0X5".
+            float value;
+
+            if (!Grbl::Parser::parseFloat(cursor, value))
+            {
+                return Grbl::Error::BadGCodeNumberFormat;
+            }
+
+            words.push_back({letter, value});
+        }
+
+        return Grbl::Error::None;
+    }
+
+    [[nodiscard]] uint8_t adjustOverride(uint8_t value, int delta)
+    {
+        return static_cast<uint8_t>(std::clamp(value + delta, MIN_OVERRIDE, MAX_OVERRIDE));
+    }
+}
+
+Grbl::GrblSimulator::GrblSimulator(const SimulatorConfiguration &configuration)
+    : m_configuration(configuration),
+      m_statistics{},
+      m_now(0),
+      m_byteMicros((1000000 * BITS_PER_BYTE + configuration.baudRate - 1) / configuration.baudRate),
+      m_toControllerFreeAt(0),
+      m_toHostFreeAt(0),
+      m_lineOverflow(false),
+      m_inComment(false),
+      m_inLineComment(false),
+      m_hasPendingLine(false),
+      m_responseDeferred(false),
+      m_mainLoopFreeAt(0),
+      m_velocity(0),
+      m_jogCancel(false),
+      m_nextAutoReportAt(configuration.autoReportIntervalMicros),
+      m_reportCounter(0),
+      m_state(MachineState::Idle),
+      m_hold(false),
+      m_door(false),
+      m_machinePosition{},
+      m_plannedPosition{},
+      m_coordinateSystems{},
+      m_coordinateOffset{},
+      m_activeCoordinateSystem(0),
+      m_motionMode(0),
+      m_plane(0),
+      m_inches(false),
+      m_incremental(false),
+      m_feedRate(0),
+      m_spindleSpeed(0),
+      m_spindleDirection(0),
+      m_flood(false),
+      m_mist(false),
+      m_lineNumber(0),
+      m_feedOverride(100),
+      m_rapidOverride(100),
+      m_spindleOverride(100)
+{
+}
+
+int Grbl::GrblSimulator::available()
+{
+    advance(m_configuration.hostPollMicros);
+
+    auto count = 0;
+
+    for (const auto &timedByte : m_toHost)
+    {
+        if (timedByte.at > m_now)
+        {
+            break;
+        }
+
+        count++;
+    }
+
+    return count;
+}
+
+int Grbl::GrblSimulator::read()
+{
+    if (m_toHost.empty() || m_toHost.front().at > m_now)
+    {
+        return -1;
+    }
+
+    const auto byte = m_toHost.front().byte;
+    m_toHost.pop_front();
+    return byte;
+}
+
+size_t Grbl::GrblSimulator::write(const uint8_t *data, size_t length)
+{
+    for (size_t i = 0; i < length; i++)
+    {
+        m_toControllerFreeAt = std::max(m_now, m_toControllerFreeAt) + m_byteMicros;
+        m_toController.push_back({m_toControllerFreeAt + m_configuration.latencyMicros, data[i]});
+    }
+
+    return length;
+}
+
+uint64_t Grbl::GrblSimulator::micros() const
+{
+    return m_now;
+}
+
+void Grbl::GrblSimulator::advance(uint64_t duration)
+{
+    advanceTo(m_now + duration);
+}
+
+void Grbl::GrblSimulator::injectError(Error error)
+{
+    m_injectedErrors.push_back(error);
+}
+
+void Grbl::GrblSimulator::injectAlarm(Alarm alarm)
+{
+    raiseAlarm(alarm);
+}
+
+void Grbl::GrblSimulator::setPins(const char *pins)
+{
+    m_pins = pins;
+}
+
+Grbl::MachineState Grbl::GrblSimulator::state() const
+{
+    return m_state;
+}
+
+const std::array<float, Grbl::MAX_NUMBER_OF_AXES> &Grbl::GrblSimulator::machinePosition() const
+{
+    return m_machinePosition;
+}
+
+size_t Grbl::GrblSimulator::plannerBlocksQueued() const
+{
+    return m_planner.size();
+}
+
+size_t Grbl::GrblSimulator::rxBytesQueued() const
+{
+    return m_rxBuffer.size();
+}
+
+bool Grbl::GrblSimulator::isIdle() const
+{
+    return m_planner.empty() && m_rxBuffer.empty() && m_toController.empty() && !m_hasPendingLine;
+}
+
+const Grbl::SimulatorStatistics &Grbl::GrblSimulator::statistics() const
+{
+    return m_statistics;
+}
+
+// --------------------------------------------------------------------------------------------------
+// Private methods
+// --------------------------------------------------------------------------------------------------
+
+void Grbl::GrblSimulator::advanceTo(uint64_t time)
+{
+    while (m_now < time)
+    {
+        const auto next = std::min<uint64_t>(time, m_now + MAX_STEP_MICROS);
+
+        while (!m_toController.empty() && m_toController.front().at <= next)
+        {
+            receive(m_toController.front().byte);
+            m_toController.pop_front();
+        }
+
+        const auto elapsed = next - m_now;
+        m_now = next;
+        runMainLoop(m_now);
+        stepMotion(elapsed / 1e6f);
+        runMainLoop(m_now);
+
+        if (m_configuration.autoReportIntervalMicros > 0 && m_now >= m_nextAutoReportAt)
+        {
+            sendStatusReport();
+            m_nextAutoReportAt = m_now + m_configuration.autoReportIntervalMicros;
+        }
+    }
+}
+
+void Grbl::GrblSimulator::receive(uint8_t byte)
+{
+    if (byte == Realtime::STATUS_REPORT ||
+        byte == Realtime::FEED_HOLD ||
+        byte == Realtime::CYCLE_START ||
+        byte >= 0x80 ||
+        byte == Realtime::SOFT_RESET)
+    {
+        m_statistics.realtimeCommands++;
+        handleRealtimeCommand(byte);
+        return;
+    }
+
+    if (m_rxBuffer.size() >= m_configuration.rxBufferSize - 1u)
+    {
+        m_statistics.rxOverflows++;
+        return;
+    }
+
+    m_rxBuffer.push_back(byte);
+}
+
+void Grbl::GrblSimulator::handleRealtimeCommand(uint8_t byte)
+{
+    switch (byte)
+    {
+    case Realtime::STATUS_REPORT:
+        sendStatusReport();
+        break;
+    case Realtime::FEED_HOLD:
+        if (m_state == MachineState::Jog)
+        {
+            m_jogCancel = true;
+        }
+        else if (m_state == MachineState::Run || m_state == MachineState::Idle)
+        {
+            m_hold = !m_planner.empty() || m_state == MachineState::Run;
+        }
+        break;
+    case Realtime::CYCLE_START:
+        if (!m_door)
+        {
+            m_hold = false;
+        }
+        break;
+    case Realtime::SOFT_RESET:
+        reset();
+        break;
+    case Realtime::SAFETY_DOOR:
+        m_door = true;
+        m_hold = true;
+        break;
+    case Realtime::JOG_CANCEL:
+        if (m_state == MachineState::Jog)
+        {
+            m_jogCancel = true;
+        }
+        break;
+    case Realtime::FEED_OVERRIDE_RESET:
+        m_feedOverride = 100;
+        break;
+    case Realtime::FEED_OVERRIDE_COARSE_PLUS:
+        m_feedOverride = adjustOverride(m_feedOverride, 10);
+        break;
+    case Realtime::FEED_OVERRIDE_COARSE_MINUS:
+        m_feedOverride = adjustOverride(m_feedOverride, -10);
+        break;
+    case Realtime::FEED_OVERRIDE_FINE_PLUS:
+        m_feedOverride = adjustOverride(m_feedOverride, 1);
+        break;
+    case Realtime::FEED_OVERRIDE_FINE_MINUS:
+        m_feedOverride = adjustOverride(m_feedOverride, -1);
+        break;
+    case Realtime::RAPID_OVERRIDE_RESET:
+        m_rapidOverride = 100;
+        break;
+    case Realtime::RAPID_OVERRIDE_MEDIUM:
+        m_rapidOverride = 50;
+        break;
+    case Realtime::RAPID_OVERRIDE_LOW:
+        m_rapidOverride = 25;
+        break;
+    case Realtime::SPINDLE_OVERRIDE_RESET:
+        m_spindleOverride = 100;
+        break;
+    case Realtime::SPINDLE_OVERRIDE_COARSE_PLUS:
+        m_spindleOverride = adjustOverride(m_spindleOverride, 10);
+        break;
+    case Realtime::SPINDLE_OVERRIDE_COARSE_MINUS:
+        m_spindleOverride = adjustOverride(m_spindleOverride, -10);
+        break;
+    case Realtime::SPINDLE_OVERRIDE_FINE_PLUS:
+        m_spindleOverride = adjustOverride(m_spindleOverride, 1);
+        break;
+    case Realtime::SPINDLE_OVERRIDE_FINE_MINUS:
+        m_spindleOverride = adjustOverride(m_spindleOverride, -1);
+        break;
+    case Realtime::SPINDLE_STOP:
+        if (m_hold)
+        {
+            m_spindleDirection = 0;
+        }
+        break;
+    case Realtime::FLOOD_COOLANT:
+        m_flood = !m_flood;
+        break;
+    case Realtime::MIST_COOLANT:
+        m_mist = !m_mist;
+        break;
+    default:
+        break;
+    }
+}
+
+void Grbl::GrblSimulator::runMainLoop(uint64_t until)
+{
+    while (m_mainLoopFreeAt <= until)
+    {
+        if (m_responseDeferred)
+        {
+            if (!m_planner.empty())
+            {
+                return;
+            }
+
+            m_responseDeferred = false;
+            respond("ok");
+        }
+
+        if (!m_hasPendingLine)
+        {
+            auto complete = false;
+
+            while (!m_rxBuffer.empty() && !complete)
+            {
+                const auto c = static_cast<char>(m_rxBuffer.front());
+                m_rxBuffer.pop_front();
+
+                if (c == '\n' || c == '\r')
+                {
+                    complete = true;
+                }
+                else if (m_inComment)
+                {
+                    m_inComment = c != ')';
+                }
+                else if (m_inLineComment || c == ' ')
+                {
+                }
+                else if (c == '(')
+                {
+                    m_inComment = true;
+                }
+                else if (c == ';')
+                {
+                    m_inLineComment = true;
+                }
+                else if (m_line.length() >= LINE_BUFFER_SIZE - 1)
+                {
+                    m_lineOverflow = true;
+                }
+                else
+                {
+                    m_line += (c >= 'a' && c <= 'z') ? static_cast<char>(c - 'a' + 'A') : c;
+                }
+            }
+
+            if (!complete)
+            {
+                return;
+            }
+
+            m_inComment = false;
+            m_inLineComment = false;
+
+            if (m_lineOverflow)
+            {
+                m_lineOverflow = false;
+                m_line.clear();
+                respondError(Error::LineTooLong);
+                continue;
+            }
+
+            m_pendingLine.swap(m_line);
+            m_line.clear();
+            m_hasPendingLine = true;
+        }
+
+        if (!executeLine(m_pendingLine))
+        {
+            return;
+        }
+
+        m_hasPendingLine = false;
+        m_statistics.linesProcessed++;
+        m_mainLoopFreeAt = std::max(m_mainLoopFreeAt, m_now) + m_configuration.lineProcessingMicros;
+    }
+}
+
+bool Grbl::GrblSimulator::executeLine(const std::string &line)
+{
+    if (!m_injectedErrors.empty())
+    {
+        respondError(m_injectedErrors.front());
+        m_injectedErrors.pop_front();
+        return true;
+    }
+
+    if (line.empty())
+    {
+        respond("ok");
+        return true;
+    }
+
+    // Grbl stops reading its RX buffer while the planner is full, which is what makes
+    // character-counting senders block.
+    if (m_planner.size() >= m_configuration.plannerBlocks - 1u)
+    {
+        return false;
+    }
+
+    auto error = Error::None;
+
+    if (line.compare(0, 3, "$J=") == 0)
+    {
+        if (m_state != MachineState::Idle && m_state != MachineState::Jog)
+        {
+            error = Error::CommandRequiresIdleState;
+        }
+        else
+        {
+            error = executeGCode(line.substr(3), true);
+        }
+    }
+    else if (line[0] == '$')
+    {
+        error = executeSystemCommand(line);
+    }
+    else if (m_state == MachineState::Alarm)
+    {
+        error = Error::GCodeCannotBeExecutedInLockOrAlarmState;
+    }
+    else
+    {
+        // Commands that are synchronised with the planner wait until all motion has completed.
+        std::vector<Word> words;
+        const auto synchronised = parseWords(line, words) == Error::None &&
+                                  std::any_of(words.begin(), words.end(), [](const Word &word)
+                                              { return word.letter == 'M' ||
+                                                       (word.letter == 'G' && (word.value == 4 || word.value == 10 ||
+                                                                               word.value == 28 || word.value == 30 ||
+                                                                               word.value == 92)); });
+
+        if (synchronised && !m_planner.empty())
+        {
+            return false;
+        }
+
+        error = executeGCode(line, false);
+    }
+
+    if (error != Error::None)
+    {
+        respondError(error);
+    }
+    else if (!m_responseDeferred)
+    {
+        respond("ok");
+    }
+
+    return true;
+}
+
+Grbl::Error Grbl::GrblSimulator::executeGCode(const std::string &line, bool jog)
+{
+    std::vector<Word> words;
+    const auto parseError = parseWords(line, words);
+
+    if (parseError != Error::None)
+    {
+        return parseError;
+    }
+
+    auto motionMode = jog ? 1 : static_cast<int>(m_motionMode);
+    auto inches = m_inches;
+    auto incremental = m_incremental;
+    auto machineCoordinates = false;
+    auto nonModal = 0;
+    std::array<float, MAX_NUMBER_OF_AXES> axisWords{};
+    std::array<bool, MAX_NUMBER_OF_AXES> hasAxisWord{};
+    auto hasAxisWords = false;
+    auto feedRate = -1.0f;
+    float i = 0, j = 0, radius = 0, p = -1, l = -1;
+    auto hasOffsets = false;
+    auto hasRadius = false;
+
+    for (const auto &word : words)
+    {
+        switch (word.letter)
+        {
+        case 'G':
+        {
+            const auto code = static_cast<int>(std::lround(word.value * 10));
+
+            switch (code)
+            {
+            case 0:
+            case 10:
+            case 20:
+            case 30:
+                if (jog)
+                {
+                    return Error::InvalidJogCommand;
+                }
+                motionMode = code / 10;
+                break;
+            case 800:
+                motionMode = -1;
+                break;
+            case 40:
+            case 100:
+            case 280:
+            case 300:
+            case 920:
+            case 921:
+                nonModal = code;
+                break;
+            case 530:
+                machineCoordinates = true;
+                break;
+            case 170:
+            case 180:
+            case 190:
+                m_plane = static_cast<uint8_t>(code / 10 - 17);
+                break;
+            case 200:
+            case 210:
+                inches = code == 200;
+                break;
+            case 900:
+            case 910:
+                incremental = code == 910;
+                break;
+            case 540:
+            case 550:
+            case 560:
+            case 570:
+            case 580:
+            case 590:
+                m_activeCoordinateSystem = static_cast<uint8_t>(code / 10 - 54);
+                break;
+            case 930:
+            case 940:
+                break;
+            default:
+                return Error::UnsupportedGCodeCommand;
+            }
+
+            break;
+        }
+        case 'M':
+        {
+            switch (static_cast<int>(word.value))
+            {
+            case 0:
+            case 1:
+            case 6:
+                break;
+            case 2:
+            case 30:
+                m_spindleDirection = 0;
+                m_flood = false;
+                m_mist = false;
+                break;
+            case 3:
+                m_spindleDirection = 1;
+                break;
+            case 4:
+                m_spindleDirection = -1;
+                break;
+            case 5:
+                m_spindleDirection = 0;
+                break;
+            case 7:
+                m_mist = true;
+                break;
+            case 8:
+                m_flood = true;
+                break;
+            case 9:
+                m_flood = false;
+                m_mist = false;
+                break;
+            default:
+                return Error::UnsupportedGCodeCommand;
+            }
+
+            break;
+        }
+        case 'F':
+            feedRate = word.value;
+            break;
+        case 'S':
+            m_spindleSpeed = word.value;
+            break;
+        case 'N':
+            m_lineNumber = static_cast<uint32_t>(word.value);
+            break;
+        case 'P':
+            p = word.value;
+            break;
+        case 'L':
+            l = word.value;
+            break;
+        case 'R':
+            radius = word.value;
+            hasRadius = true;
+            break;
+        case 'I':
+            i = word.value;
+            hasOffsets = true;
+            break;
+        case 'J':
+            j = word.value;
+            hasOffsets = true;
+            break;
+        case 'K':
+        case 'T':
+            break;
+        default:
+        {
+            const auto axis = axisIndex(word.letter);
+
+            if (axis < 0 || axis >= m_configuration.numberOfAxes)
+            {
+                return Error::UnsupportedGCodeCommand;
+            }
+
+            axisWords[axis] = word.value;
+            hasAxisWord[axis] = true;
+            hasAxisWords = true;
+            break;
+        }
+        }
+    }
+
+    const auto scale = inches ? MM_PER_INCH : 1.0f;
+
+    if (feedRate >= 0 && !jog)
+    {
+        m_feedRate = feedRate * scale;
+    }
+
+    if (!jog)
+    {
+        m_inches = inches;
+        m_incremental = incremental;
+
+        if (motionMode >= 0)
+        {
+            m_motionMode = static_cast<uint8_t>(motionMode);
+        }
+    }
+
+    switch (nonModal)
+    {
+    case 40:
+    {
+        if (p < 0)
+        {
+            return Error::GCodeValueWordMissing;
+        }
+
+        queueBlock({BlockType::Dwell, {}, p * 1e6f, 0, false, false, m_lineNumber});
+        m_responseDeferred = true;
+        return Error::None;
+    }
+    case 100:
+    {
+        if (p < 0 || (l != 2 && l != 20))
+        {
+            return Error::GCodeValueWordMissing;
+        }
+
+        if (p > 6)
+        {
+            return Error::GCodeUnsupportedCoordinateSystem;
+        }
+
+        const auto system = p == 0 ? m_activeCoordinateSystem : static_cast<int>(p) - 1;
+
+        for (auto axis = 0; axis < m_configuration.numberOfAxes; axis++)
+        {
+            if (hasAxisWord[axis])
+            {
+                m_coordinateSystems[system][axis] = l == 2
+                                                        ? axisWords[axis] * scale
+                                                        : m_plannedPosition[axis] - m_coordinateOffset[axis] - axisWords[axis] * scale;
+            }
+        }
+
+        return Error::None;
+    }
+    case 920:
+    {
+        for (auto axis = 0; axis < m_configuration.numberOfAxes; axis++)
+        {
+            if (hasAxisWord[axis])
+            {
+                m_coordinateOffset[axis] = m_plannedPosition[axis] -
+                                           m_coordinateSystems[m_activeCoordinateSystem][axis] -
+                                           axisWords[axis] * scale;
+            }
+        }
+
+        return Error::None;
+    }
+    case 921:
+        m_coordinateOffset = {};
+        return Error::None;
+    case 280:
+    case 300:
+        hasAxisWord.fill(true);
+        axisWords = {};
+        machineCoordinates = true;
+        motionMode = 0;
+        hasAxisWords = true;
+        break;
+    default:
+        break;
+    }
+
+    if (!hasAxisWords)
+    {
+        return Error::None;
+    }
+
+    if (motionMode < 0)
+    {
+        return Error::GCodeExtraAxisWords;
+    }
+
+    const auto jogFeedRate = feedRate * scale;
+
+    if ((jog && feedRate <= 0) || (!jog && motionMode > 0 && m_feedRate <= 0))
+    {
+        return Error::GCodeUndefinedFeedRate;
+    }
+
+    auto target = m_plannedPosition;
+
+    for (auto axis = 0; axis < m_configuration.numberOfAxes; axis++)
+    {
+        if (!hasAxisWord[axis])
+        {
+            continue;
+        }
+
+        if (machineCoordinates)
+        {
+            target[axis] = axisWords[axis] * scale;
+        }
+        else if (incremental)
+        {
+            target[axis] = m_plannedPosition[axis] + axisWords[axis] * scale;
+        }
+        else
+        {
+            target[axis] = axisWords[axis] * scale + workCoordinateOffset(axis);
+        }
+    }
+
+    std::array<float, MAX_NUMBER_OF_AXES> delta{};
+    float length = 0;
+
+    for (auto axis = 0; axis < MAX_NUMBER_OF_AXES; axis++)
+    {
+        delta[axis] = target[axis] - m_plannedPosition[axis];
+        length += delta[axis] * delta[axis];
+    }
+
+    length = std::sqrt(length);
+
+    // Arcs are travelled along their chord, but take as long as the arc itself would.
+    auto pathLength = length;
+
+    if (motionMode == 2 || motionMode == 3)
+    {
+        if (!hasOffsets && !hasRadius)
+        {
+            return Error::GCodeNoOffsetsInPlane;
+        }
+
+        const auto arcRadius = hasRadius ? std::abs(radius * scale) : std::hypot(i, j) * scale;
+
+        if (arcRadius * 2 < length - 1e-3f)
+        {
+            return Error::GCodeArcRadiusError;
+        }
+
+        pathLength = 2 * arcRadius * std::asin(std::min(1.0f, length / (2 * arcRadius)));
+    }
+
+    if (length < 1e-6f)
+    {
+        return Error::None;
+    }
+
+    Block block{BlockType::Motion, {}, pathLength, 0, motionMode == 0, jog, m_lineNumber};
+
+    for (auto axis = 0; axis < MAX_NUMBER_OF_AXES; axis++)
+    {
+        block.direction[axis] = delta[axis] / pathLength;
+    }
+
+    block.feedRate = std::min(jog ? jogFeedRate : (block.rapid ? m_configuration.maxRate : m_feedRate),
+                              m_configuration.maxRate);
+    queueBlock(block);
+    m_plannedPosition = target;
+    return Error::None;
+}
+
+Grbl::Error Grbl::GrblSimulator::executeSystemCommand(const std::string &line)
+{
+    const auto command = line.substr(1);
+    const auto requiresIdle = m_state != MachineState::Idle && m_state != MachineState::Alarm;
+
+    if (command.empty())
+    {
+        respond("[HLP:$$ $# $G $I $N $x=val $Nx=line $J=line $SLP $C $X $H ~ ! ? ctrl-x]");
+        return Error::None;
+    }
+
+    if (command == "G")
+    {
+        char report[96];
+        snprintf(report, sizeof(report), "[GC:G%d G%d G%d G%d G%d G94 M%d M9 T0 F%.0f S%.0f]",
+                 m_motionMode, 54 + m_activeCoordinateSystem, 17 + m_plane, m_inches ? 20 : 21,
+                 m_incremental ? 91 : 90, m_spindleDirection > 0 ? 3 : (m_spindleDirection < 0 ? 4 : 5),
+                 m_feedRate, m_spindleSpeed);
+        respond(report);
+        return Error::None;
+    }
+
+    if (command == "C")
+    {
+        return Error::None;
+    }
+
+    if (requiresIdle)
+    {
+        return Error::CommandRequiresIdleState;
+    }
+
+    if (command == "X")
+    {
+        if (m_state == MachineState::Alarm)
+        {
+            m_state = MachineState::Idle;
+            respond("[MSG:Caution: Unlocked]");
+        }
+
+        return Error::None;
+    }
+
+    if (command[0] == 'H')
+    {
+        m_state = MachineState::Home;
+        queueBlock({BlockType::Homing, {}, static_cast<float>(m_configuration.homingMicros), 0, false, false, 0});
+        m_responseDeferred = true;
+        return Error::None;
+    }
+
+    if (command == "$")
+    {
+        respond("$0=10");
+        respond("$1=25");
+        respond("$110=5000.000");
+        return Error::None;
+    }
+
+    if (command == "#")
+    {
+        char report[96];
+
+        for (auto system = 0; system < 6; system++)
+        {
+            const auto &offset = m_coordinateSystems[system];
+            snprintf(report, sizeof(report), "[G%d:%.3f,%.3f,%.3f]", 54 + system, offset[0], offset[1], offset[2]);
+            respond(report);
+        }
+
+        return Error::None;
+    }
+
+    if (command == "I")
+    {
+        respond("[VER:1.1h.20190830:]");
+        respond("[OPT:V,15,128]");
+        return Error::None;
+    }
+
+    if (command == "N")
+    {
+        respond("$N0=");
+        respond("$N1=");
+        return Error::None;
+    }
+
+    if (command == "SLP")
+    {
+        m_state = MachineState::Sleep;
+        return Error::None;
+    }
+
+    if (command.compare(0, 4, "RST=") == 0 || command.find('=') != std::string::npos)
+    {
+        return Error::None;
+    }
+
+    return Error::InvalidGrblStatement;
+}
+
+void Grbl::GrblSimulator::stepMotion(float seconds)
+{
+    if (m_planner.empty())
+    {
+        m_velocity = 0;
+    }
+    else if (m_planner.front().type != BlockType::Motion)
+    {
+        auto &block = m_planner.front();
+
+        if (!m_hold)
+        {
+            block.remaining -= seconds * 1e6f;
+        }
+
+        if (block.remaining <= 0)
+        {
+            if (block.type == BlockType::Homing)
+            {
+                m_machinePosition = {};
+                m_plannedPosition = {};
+                m_state = MachineState::Idle;
+            }
+
+            m_planner.pop_front();
+        }
+    }
+    else
+    {
+        // Look-ahead: never go faster than what still allows stopping at the end of the queued path.
+        float queuedDistance = 0;
+
+        for (const auto &block : m_planner)
+        {
+            if (block.type != BlockType::Motion)
+            {
+                break;
+            }
+
+            queuedDistance += block.remaining;
+        }
+
+        const auto &front = m_planner.front();
+        const auto override = front.rapid ? m_rapidOverride : (front.jog ? 100 : m_feedOverride);
+        const auto acceleration = m_configuration.acceleration;
+        const auto feedLimit = front.feedRate / 60 * override / 100;
+        const auto targetVelocity = (m_hold || m_jogCancel)
+                                        ? 0.0f
+                                        : std::min(feedLimit, std::sqrt(2 * acceleration * queuedDistance));
+
+        m_velocity = m_velocity < targetVelocity
+                         ? std::min(targetVelocity, m_velocity + acceleration * seconds)
+                         : std::max(targetVelocity, m_velocity - acceleration * seconds);
+
+        auto distance = m_velocity * seconds;
+
+        if (m_velocity > 0)
+        {
+            m_statistics.motionMicros += static_cast<uint64_t>(seconds * 1e6f);
+        }
+
+        while (distance > 0 && !m_planner.empty() && m_planner.front().type == BlockType::Motion)
+        {
+            auto &block = m_planner.front();
+            const auto step = std::min(distance, block.remaining);
+
+            for (auto axis = 0; axis < MAX_NUMBER_OF_AXES; axis++)
+            {
+                m_machinePosition[axis] += block.direction[axis] * step;
+            }
+
+            block.remaining -= step;
+            distance -= step;
+            m_statistics.distanceTravelled += step;
+
+            if (block.remaining <= 1e-6f)
+            {
+                m_planner.pop_front();
+            }
+        }
+
+        if (m_planner.empty())
+        {
+            m_statistics.motionStops++;
+            m_velocity = 0;
+            m_machinePosition = m_plannedPosition;
+        }
+
+        if (m_jogCancel && m_velocity == 0)
+        {
+            m_planner.erase(std::remove_if(m_planner.begin(), m_planner.end(), [](const Block &block)
+                                           { return block.jog; }),
+                            m_planner.end());
+            m_plannedPosition = m_machinePosition;
+            m_jogCancel = false;
+        }
+    }
+
+    if (m_state == MachineState::Alarm || m_state == MachineState::Home || m_state == MachineState::Sleep)
+    {
+        return;
+    }
+
+    if (m_door)
+    {
+        m_state = MachineState::Door;
+    }
+    else if (m_hold)
+    {
+        m_state = MachineState::Hold;
+    }
+    else if (!m_planner.empty())
+    {
+        m_state = m_planner.front().jog ? MachineState::Jog : MachineState::Run;
+    }
+    else
+    {
+        m_state = MachineState::Idle;
+    }
+}
+
+void Grbl::GrblSimulator::queueBlock(const Block &block)
+{
+    m_planner.push_back(block);
+
+    if (block.type == BlockType::Motion && m_state == MachineState::Idle)
+    {
+        m_state = block.jog ? MachineState::Jog : MachineState::Run;
+    }
+}
+
+void Grbl::GrblSimulator::reset()
+{
+    const auto abortedMotion = isMoving() || m_state == MachineState::Home;
+
+    m_rxBuffer.clear();
+    m_line.clear();
+    m_lineOverflow = false;
+    m_inComment = false;
+    m_inLineComment = false;
+    m_hasPendingLine = false;
+    m_responseDeferred = false;
+    m_planner.clear();
+    m_velocity = 0;
+    m_jogCancel = false;
+    m_hold = false;
+    m_door = false;
+    m_plannedPosition = m_machinePosition;
+    m_motionMode = 0;
+    m_spindleDirection = 0;
+    m_flood = false;
+    m_mist = false;
+    m_feedOverride = 100;
+    m_rapidOverride = 100;
+    m_spindleOverride = 100;
+
+    if (abortedMotion)
+    {
+        raiseAlarm(Alarm::AbortDuringCycle);
+    }
+    else if (m_state != MachineState::Alarm)
+    {
+        m_state = MachineState::Idle;
+    }
+
+    respond("");
+    respond(WELCOME_MESSAGE);
+}
+
+void Grbl::GrblSimulator::raiseAlarm(Alarm alarm)
+{
+    m_planner.clear();
+    m_velocity = 0;
+    m_plannedPosition = m_machinePosition;
+    m_responseDeferred = false;
+    m_state = MachineState::Alarm;
+    m_statistics.alarms++;
+
+    char message[16];
+    snprintf(message, sizeof(message), "ALARM:%d", static_cast<int>(alarm));
+    respond(message);
+}
+
+void Grbl::GrblSimulator::respond(const char *text)
+{
+    if (strcmp(text, "ok") == 0)
+    {
+        m_statistics.okResponses++;
+    }
+
+    const auto send = [this](char c)
+    {
+        m_toHostFreeAt = std::max(m_now, m_toHostFreeAt) + m_byteMicros;
+        m_toHost.push_back({m_toHostFreeAt + m_configuration.latencyMicros, static_cast<uint8_t>(c)});
+    };
+
+    for (auto c = text; *c != '\0'; c++)
+    {
+        send(*c);
+    }
+
+    send('\r');
+    send('\n');
+}
+
+void Grbl::GrblSimulator::respondError(Error error)
+{
+    m_statistics.errorResponses++;
+
+    char message[16];
+    snprintf(message, sizeof(message), "error:%d", static_cast<int>(error));
+    respond(message);
+}
+
+void Grbl::GrblSimulator::sendStatusReport()
+{
+    m_statistics.statusReports++;
+
+    char report[256];
+    auto length = 0;
+    const auto append = [&report, &length](const char *format, auto... values)
+    {
+        length += snprintf(report + length, sizeof(report) - length, format, values...);
+    };
+
+    switch (m_state)
+    {
+    case MachineState::Hold:
+        append(m_velocity > 0 ? "<Hold:1" : "<Hold:0");
+        break;
+    case MachineState::Door:
+        append(m_velocity > 0 ? "<Door:2" : "<Door:0");
+        break;
+    default:
+        append("<%s", machineStates[static_cast<int>(m_state)]);
+        break;
+    }
+
+    for (auto axis = 0; axis < m_configuration.numberOfAxes; axis++)
+    {
+        append(axis == 0 ? "|MPos:%.3f" : ",%.3f", m_machinePosition[axis]);
+    }
+
+    append("|Bf:%d,%d", static_cast<int>(m_configuration.plannerBlocks - 1 - m_planner.size()),
+           static_cast<int>(m_configuration.rxBufferSize - m_rxBuffer.size()));
+
+    if (m_lineNumber > 0)
+    {
+        append("|Ln:%u", m_planner.empty() ? m_lineNumber : m_planner.front().lineNumber);
+    }
+
+    append("|FS:%.0f,%.0f", m_velocity * 60, m_spindleDirection != 0 ? m_spindleSpeed * m_spindleOverride / 100 : 0.0f);
+
+    if (!m_pins.empty())
+    {
+        append("|Pn:%s", m_pins.c_str());
+    }
+
+    const auto interval = std::max<uint8_t>(m_configuration.workCoordinateOffsetReportInterval, 2);
+
+    if (m_reportCounter % interval == 0)
+    {
+        for (auto axis = 0; axis < m_configuration.numberOfAxes; axis++)
+        {
+            append(axis == 0 ? "|WCO:%.3f" : ",%.3f", workCoordinateOffset(axis));
+        }
+    }
+    else if (m_reportCounter % interval == interval / 2)
+    {
+        append("|Ov:%d,%d,%d", m_feedOverride, m_rapidOverride, m_spindleOverride);
+
+        if (m_spindleDirection != 0 || m_flood || m_mist)
+        {
+            append("|A:%s%s%s", m_spindleDirection > 0 ? "S" : (m_spindleDirection < 0 ? "C" : ""),
+                   m_flood ? "F" : "", m_mist ? "M" : "");
+        }
+    }
+
+    m_reportCounter++;
+    append(">");
+    respond(report);
+}
+
+float Grbl::GrblSimulator::workCoordinateOffset(int axis) const
+{
+    return m_coordinateSystems[m_activeCoordinateSystem][axis] + m_coordinateOffset[axis];
+}
+
+bool Grbl::GrblSimulator::isMoving() const
+{
+    return m_velocity > 0;
+}
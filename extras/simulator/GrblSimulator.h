@@ -0,0 +1,161 @@
+#pragma once
+
+#include "GrblPlatform.h"
+#include "GrblConstants.h"
+
+#include <array>
+#include <deque>
+#include <string>
+
+namespace Grbl
+{
+    struct SimulatorConfiguration
+    {
+        uint32_t baudRate = 115200;
+        uint16_t rxBufferSize = 128;     // Grbl's RX_BUFFER_SIZE.
+        uint8_t plannerBlocks = 16;      // Grbl's BLOCK_BUFFER_SIZE, one block is always kept free.
+        uint8_t numberOfAxes = 3;
+        float acceleration = 500;        // mm/s^2, same for all axes.
+        float maxRate = 5000;            // mm/min, used for rapids.
+        uint32_t latencyMicros = 0;      // Extra one-way link latency, e.g. USB-serial bridge frame timing.
+        uint32_t hostPollMicros = 20;    // Virtual time consumed by every available() call of the host.
+        uint32_t lineProcessingMicros = 50;
+        uint32_t homingMicros = 2000000;
+        uint32_t autoReportIntervalMicros = 0; // Unsolicited status reports, 0 disables them.
+        uint8_t workCoordinateOffsetReportInterval = 10;
+    };
+
+    struct SimulatorStatistics
+    {
+        uint32_t linesProcessed;
+        uint32_t okResponses;
+        uint32_t errorResponses;
+        uint32_t alarms;
+        uint32_t statusReports;
+        uint32_t realtimeCommands;
+        uint32_t rxOverflows;
+        uint32_t motionStops; // Times the planner ran dry and the machine had to come to a stop.
+        uint64_t motionMicros;
+        float distanceTravelled;
+    };
+
+    // Virtual Grbl 1.1 controller that plugs in where the serial stream goes. Time is virtual and only
+    // advances while the host polls available() or calls advance(), so every run is deterministic.
+    // Bind it to the library's clock with Grbl::Platform::setClockSource.
+    class GrblSimulator : public ByteStream
+    {
+    public:
+        explicit GrblSimulator(const SimulatorConfiguration &configuration = {});
+
+        [[nodiscard]] int available() override;
+        [[nodiscard]] int read() override;
+        size_t write(const uint8_t *data, size_t length) override;
+
+        [[nodiscard]] uint64_t micros() const;
+        void advance(uint64_t duration);
+
+        // Error injection: the next received line is answered with error, or an alarm is raised right away.
+        void injectError(Error error);
+        void injectAlarm(Alarm alarm);
+        void setPins(const char *pins);
+
+        [[nodiscard]] MachineState state() const;
+        [[nodiscard]] const std::array<float, MAX_NUMBER_OF_AXES> &machinePosition() const;
+        [[nodiscard]] size_t plannerBlocksQueued() const;
+        [[nodiscard]] size_t rxBytesQueued() const;
+        [[nodiscard]] bool isIdle() const;
+        [[nodiscard]] const SimulatorStatistics &statistics() const;
+
+    private:
+        enum class BlockType
+        {
+            Motion,
+            Dwell,
+            Homing
+        };
+
+        struct Block
+        {
+            BlockType type;
+            std::array<float, MAX_NUMBER_OF_AXES> direction;
+            float remaining; // mm for motion, microseconds for dwell and homing.
+            float feedRate;  // mm/min
+            bool rapid;
+            bool jog;
+            uint32_t lineNumber;
+        };
+
+        struct TimedByte
+        {
+            uint64_t at;
+            uint8_t byte;
+        };
+
+        SimulatorConfiguration m_configuration;
+        SimulatorStatistics m_statistics;
+        uint64_t m_now;
+        uint32_t m_byteMicros;
+
+        std::deque<TimedByte> m_toController;
+        std::deque<TimedByte> m_toHost;
+        uint64_t m_toControllerFreeAt;
+        uint64_t m_toHostFreeAt;
+
+        std::deque<uint8_t> m_rxBuffer;
+        std::string m_line;
+        bool m_lineOverflow;
+        bool m_inComment;
+        bool m_inLineComment;
+        std::string m_pendingLine;
+        bool m_hasPendingLine;
+        bool m_responseDeferred; // "ok" is sent once the planner has drained, e.g. after G4 or $H.
+        uint64_t m_mainLoopFreeAt;
+        std::deque<Error> m_injectedErrors;
+
+        std::deque<Block> m_planner;
+        float m_velocity; // mm/s
+        bool m_jogCancel;
+        uint64_t m_nextAutoReportAt;
+        uint32_t m_reportCounter;
+
+        MachineState m_state;
+        bool m_hold;
+        bool m_door;
+        std::array<float, MAX_NUMBER_OF_AXES> m_machinePosition;
+        std::array<float, MAX_NUMBER_OF_AXES> m_plannedPosition;
+        std::array<std::array<float, MAX_NUMBER_OF_AXES>, 6> m_coordinateSystems;
+        std::array<float, MAX_NUMBER_OF_AXES> m_coordinateOffset;
+        uint8_t m_activeCoordinateSystem;
+        uint8_t m_motionMode;
+        uint8_t m_plane;
+        bool m_inches;
+        bool m_incremental;
+        float m_feedRate;
+        float m_spindleSpeed;
+        int m_spindleDirection; // 1 = M3, -1 = M4, 0 = off.
+        bool m_flood;
+        bool m_mist;
+        uint32_t m_lineNumber;
+        uint8_t m_feedOverride;
+        uint8_t m_rapidOverride;
+        uint8_t m_spindleOverride;
+        std::string m_pins;
+
+        void advanceTo(uint64_t time);
+        void receive(uint8_t byte);
+        void handleRealtimeCommand(uint8_t byte);
+        void runMainLoop(uint64_t until);
+        [[nodiscard]] bool executeLine(const std::string &line);
+        [[nodiscard]] Error executeGCode(const std::string &line, bool jog);
+        [[nodiscard]] Error executeSystemCommand(const std::string &line);
+        void stepMotion(float seconds);
+        void queueBlock(const Block &block);
+        void reset();
+        void raiseAlarm(Alarm alarm);
+        void respond(const char *text);
+        void respondError(Error error);
+        void sendStatusReport();
+        [[nodiscard]] float workCoordinateOffset(int axis) const;
+        [[nodiscard]] bool isMoving() const;
+    };
+}
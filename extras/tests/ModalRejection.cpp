@@ -0,0 +1,138 @@
+// Checks that modal-state tracking only leaves words out against modes Grbl has acknowledged. A rejected
+// "G1 F100 X1" must not let the move queued behind it go out without its G1 and F words, where Grbl would
+// run it in the old motion mode and feed rate.
+// Usage: modal_rejection
+
+#include "GrblInterface.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // Keeps every line written and hands out the responses the test puts in.
+    class ScriptedStream : public Grbl::ByteStream
+    {
+    public:
+        ScriptedStream()
+            : m_offset(0)
+        {
+        }
+
+        void respond(const char *response)
+        {
+            m_pending += response;
+            m_pending += "\r\n";
+        }
+
+        [[nodiscard]] const std::vector<std::string> &written() const
+        {
+            return m_written;
+        }
+
+        int available() override
+        {
+            return static_cast<int>(m_pending.size() - m_offset);
+        }
+
+        int read() override
+        {
+            return m_offset < m_pending.size() ? static_cast<uint8_t>(m_pending[m_offset++]) : -1;
+        }
+
+        size_t write(const uint8_t *data, size_t length) override
+        {
+            for (size_t i = 0; i < length; i++)
+            {
+                if (data[i] == '\n')
+                {
+                    m_written.push_back(m_line);
+                    m_line.clear();
+                }
+                else if (data[i] >= ' ')
+                {
+                    m_line += static_cast<char>(data[i]);
+                }
+            }
+
+            return length;
+        }
+
+    private:
+        std::string m_pending;
+        size_t m_offset;
+        std::string m_line;
+        std::vector<std::string> m_written;
+    };
+
+    int failures = 0;
+
+    void answer(GrblInterface &grbl, ScriptedStream &stream, const char *response)
+    {
+        stream.respond(response);
+
+        while (stream.available() > 0)
+        {
+            grbl.update();
+        }
+    }
+
+    // The last line written, which must or must not carry the words.
+    void expectWords(const ScriptedStream &stream, const char *words, bool present, const char *when)
+    {
+        const auto &line = stream.written().back();
+        const auto found = line.find(words) != std::string::npos;
+
+        if (found != present)
+        {
+            printf("%s: \"%s\" %s %s\n", when, line.c_str(), present ? "lacks" : "still has", words);
+            failures++;
+        }
+    }
+
+    void setUp(GrblInterface &grbl, ScriptedStream &stream)
+    {
+        grbl.setStreamingMode(true);
+        grbl.setAsynchronousMode(true);
+        grbl.setModalStateTracking(true);
+        (void)grbl.sendLine("G21 G90 G94");
+        answer(grbl, stream, "ok");
+    }
+}
+
+int main()
+{
+    {
+        ScriptedStream stream;
+        GrblInterface grbl(stream);
+        setUp(grbl, stream);
+
+        (void)grbl.sendLine("G1 F100 X1");
+        (void)grbl.linearInterpolationPositioning(100, {{Grbl::Axis::X, 2}});
+        expectWords(stream, "G1", true, "queued behind an unacknowledged G1");
+        expectWords(stream, "F100", true, "queued behind an unacknowledged F100");
+
+        answer(grbl, stream, "error:20");
+        answer(grbl, stream, "ok");
+        (void)grbl.linearInterpolationPositioning(100, {{Grbl::Axis::X, 3}});
+        expectWords(stream, "G1", true, "after the rejection");
+        expectWords(stream, "F100", true, "after the rejection");
+    }
+
+    // Once Grbl accepted the modes, they are left out.
+    {
+        ScriptedStream stream;
+        GrblInterface grbl(stream);
+        setUp(grbl, stream);
+
+        (void)grbl.sendLine("G1 F100 X1");
+        answer(grbl, stream, "ok");
+        (void)grbl.linearInterpolationPositioning(100, {{Grbl::Axis::X, 2}});
+        expectWords(stream, "G1", false, "after the acknowledgement");
+        expectWords(stream, "F100", false, "after the acknowledgement");
+    }
+
+    printf("%d failures\n", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,188 @@
+// Feeds the traffic corpus through GrblInterface line by line and checks the status report getters after
+// the reports listed below. Fields a report leaves out must read as documented: Bf, Ln and Pn as absent,
+// the overrides and accessories as last reported, except that Ov without A clears the accessories.
+// Usage: status_report_fields [corpus]
+
+#include "GrblInterface.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+namespace
+{
+    constexpr auto SPINDLE_CW = static_cast<uint8_t>(Grbl::Accessory::SpindleClockwise);
+    constexpr auto SPINDLE_CCW = static_cast<uint8_t>(Grbl::Accessory::SpindleCounterClockwise);
+    constexpr auto FLOOD = static_cast<uint8_t>(Grbl::Accessory::FloodCoolant);
+    constexpr auto MIST = static_cast<uint8_t>(Grbl::Accessory::MistCoolant);
+
+    constexpr auto PROBE = static_cast<uint8_t>(Grbl::ControlPin::Probe);
+    constexpr auto DOOR = static_cast<uint8_t>(Grbl::ControlPin::Door);
+    constexpr auto HOLD = static_cast<uint8_t>(Grbl::ControlPin::Hold);
+    constexpr auto SOFT_RESET = static_cast<uint8_t>(Grbl::ControlPin::SoftReset);
+    constexpr auto CYCLE_START = static_cast<uint8_t>(Grbl::ControlPin::CycleStart);
+
+    struct Expectation
+    {
+        const char *line;
+        Grbl::MachineState machineState;
+        uint8_t subState;
+        int16_t plannerBlocksAvailable;
+        int16_t rxBytesAvailable;
+        uint32_t lineNumber;
+        uint8_t feedOverride;
+        uint8_t accessories;
+        uint8_t controlPins;
+        uint8_t limitSwitches;
+        float feedRate;
+        float spindleSpeed;
+    };
+
+    // In corpus order. The values are those after the line, so kept fields depend on the lines before it.
+    const Expectation expectations[] = {
+        {"<Alarm|MPos:0.000,0.000,0.000|Bf:15,128|FS:0,0|Pn:XYZ|WCO:0.000,0.000,0.000>",
+         Grbl::MachineState::Alarm, 0, 15, 128, 0, 100, 0, 0, 0b111, 0, 0},
+        {"<Run|MPos:-188.007,-191.342,-1.000|Bf:1,3|FS:1500,12000|A:S>",
+         Grbl::MachineState::Run, 0, 1, 3, 0, 100, SPINDLE_CW, 0, 0, 1500, 12000},
+        // Neither Ov nor A: the accessories are kept.
+        {"<Run|MPos:-180.251,-185.113,-3.500|Bf:0,27|FS:800,12000>",
+         Grbl::MachineState::Run, 0, 0, 27, 0, 100, SPINDLE_CW, 0, 0, 800, 12000},
+        {"<Hold:1|MPos:-155.002,-167.503,-3.500|Bf:1,18|FS:642,12000|Pn:H>",
+         Grbl::MachineState::Hold, 1, 1, 18, 0, 100, SPINDLE_CW, HOLD, 0, 642, 12000},
+        // Ov without A: everything is off.
+        {"<Run|MPos:-150.333,-164.128,-3.500|Bf:0,31|FS:1500,12000|Ov:110,100,100>",
+         Grbl::MachineState::Run, 0, 0, 31, 0, 110, 0, 0, 0, 1500, 12000},
+        {"<Door:0|MPos:-140.000,-160.000,-1.000|Bf:15,128|FS:0,0|Pn:D>",
+         Grbl::MachineState::Door, 0, 15, 128, 0, 110, 0, DOOR, 0, 0, 0},
+        {"<Alarm|MPos:-140.000,-160.000,-1.000|Bf:15,128|FS:0,0|Pn:Y>",
+         Grbl::MachineState::Alarm, 0, 15, 128, 0, 110, 0, 0, 0b010, 0, 0},
+        // A controller with Bf: turned off ($10) and without variable spindle speed (F: instead of FS:).
+        {"<Idle|MPos:0.000,0.000,0.000|F:0|Pn:R>",
+         Grbl::MachineState::Idle, 0, -1, -1, 0, 110, 0, SOFT_RESET, 0, 0, 0},
+        {"<Run|MPos:12.500,4.000,-1.000|Ln:120|F:1200|Ov:100,100,100|A:CFM>",
+         Grbl::MachineState::Run, 0, -1, -1, 120, 100, SPINDLE_CCW | FLOOD | MIST, 0, 0, 1200, 0},
+        {"<Run|MPos:14.000,5.250,-1.000|Ln:121|F:1200|Pn:PS>",
+         Grbl::MachineState::Run, 0, -1, -1, 121, 100, SPINDLE_CCW | FLOOD | MIST, PROBE | CYCLE_START, 0, 1200, 0},
+        {"<Hold:0|MPos:15.125,6.000,-1.000|Ln:121|F:0|Ov:100,100,100>",
+         Grbl::MachineState::Hold, 0, -1, -1, 121, 100, 0, 0, 0, 0, 0},
+    };
+
+    // Hands out one line at a time, terminated like Grbl does, and discards everything written.
+    class LineStream : public Grbl::ByteStream
+    {
+    public:
+        LineStream()
+            : m_offset(0)
+        {
+        }
+
+        void receive(const std::string &line)
+        {
+            m_pending = line + "\r\n";
+            m_offset = 0;
+        }
+
+        int available() override
+        {
+            return static_cast<int>(m_pending.size() - m_offset);
+        }
+
+        int read() override
+        {
+            return m_offset < m_pending.size() ? static_cast<uint8_t>(m_pending[m_offset++]) : -1;
+        }
+
+        size_t write(const uint8_t *, size_t length) override
+        {
+            return length;
+        }
+
+    private:
+        std::string m_pending;
+        size_t m_offset;
+    };
+
+    int failures = 0;
+
+    template <typename T>
+    void expect(const char *line, const char *field, T actual, T expected)
+    {
+        if (actual != expected)
+        {
+            printf("%s\n  %s: %g, expected %g\n", line, field, static_cast<double>(actual),
+                   static_cast<double>(expected));
+            failures++;
+        }
+    }
+
+    void check(GrblInterface &grbl, const Expectation &expected)
+    {
+        const auto line = expected.line;
+        expect(line, "machine state", static_cast<int>(grbl.currentMachineState()),
+               static_cast<int>(expected.machineState));
+        expect(line, "sub-state", grbl.currentSubState(), expected.subState);
+        expect(line, "planner blocks", grbl.plannerBlocksAvailable(), expected.plannerBlocksAvailable);
+        expect(line, "RX bytes", grbl.rxBytesAvailable(), expected.rxBytesAvailable);
+        expect(line, "line number", grbl.currentLineNumber(), expected.lineNumber);
+        expect(line, "feed override", grbl.feedOverride(), expected.feedOverride);
+        expect(line, "accessories", grbl.accessoryMask(), expected.accessories);
+        expect(line, "control pins", grbl.controlPinMask(), expected.controlPins);
+        expect(line, "limit switches", grbl.limitSwitchMask(), expected.limitSwitches);
+        expect(line, "feed rate", grbl.getCurrentFeedRate(), expected.feedRate);
+        expect(line, "spindle speed", grbl.getCurrentSpindleSpeed(), expected.spindleSpeed);
+
+        // Other tasks see the same values.
+        const auto snapshot = grbl.getStatusSnapshot();
+        expect(line, "snapshot planner blocks", snapshot.plannerBlocksAvailable, expected.plannerBlocksAvailable);
+        expect(line, "snapshot accessories", snapshot.accessories, expected.accessories);
+        expect(line, "snapshot control pins", snapshot.controlPins, expected.controlPins);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const auto path = argc > 1 ? argv[1] : TRAFFIC_CORPUS;
+    std::ifstream file(path);
+
+    if (!file)
+    {
+        fprintf(stderr, "Unable to open %s\n", path);
+        return 1;
+    }
+
+    LineStream stream;
+    GrblInterface grbl(stream);
+    size_t next = 0;
+    std::string line;
+
+    while (std::getline(file, line))
+    {
+        if (!line.empty() && line.back() == '\r')
+        {
+            line.pop_back();
+        }
+
+        stream.receive(line);
+
+        while (stream.available() > 0)
+        {
+            grbl.update();
+        }
+
+        if (next < std::size(expectations) && line == expectations[next].line)
+        {
+            check(grbl, expectations[next]);
+            next++;
+        }
+    }
+
+    for (; next < std::size(expectations); next++)
+    {
+        printf("%s\n  not found in %s\n", expectations[next].line, path);
+        failures++;
+    }
+
+    printf("%zu reports checked, %d failures\n", std::size(expectations), failures);
+    return failures == 0 ? 0 : 1;
+}
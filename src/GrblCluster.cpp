@@ -0,0 +1,134 @@
+#include "GrblCluster.h"
+
+#include <algorithm>
+
+bool GrblCluster::add(GrblInterface &controller)
+{
+    if (m_size == m_controllers.size())
+    {
+        return false;
+    }
+
+    m_controllers[m_size] = &controller;
+    m_statistics[m_size] = {};
+    m_size++;
+    return true;
+}
+
+size_t GrblCluster::size()
+{
+    return m_size;
+}
+
+GrblInterface &GrblCluster::operator[](size_t index)
+{
+    return *m_controllers[index];
+}
+
+void GrblCluster::update()
+{
+    pollStatusReports();
+
+    for (size_t i = 0; i < m_size; i++)
+    {
+        const auto index = (m_next + i) % m_size;
+        auto &statistics = m_statistics[index];
+        const auto startedAt = Grbl::Platform::micros();
+
+        m_controllers[index]->update();
+
+        const auto duration = Grbl::Platform::micros() - startedAt;
+        statistics.updates++;
+        statistics.busyMicros += duration;
+        statistics.maxUpdateMicros = std::max(statistics.maxUpdateMicros, duration);
+    }
+
+    if (m_size > 0)
+    {
+        m_next = (m_next + 1) % m_size;
+    }
+}
+
+ClusterSnapshot GrblCluster::getSnapshot() const
+{
+    ClusterSnapshot snapshot = {};
+    snapshot.size = m_size;
+    snapshot.allIdle = true;
+    auto neverReported = false;
+
+    for (size_t i = 0; i < m_size; i++)
+    {
+        const auto &controller = snapshot.controllers[i] = m_controllers[i]->getStatusSnapshot();
+        snapshot.allIdle = snapshot.allIdle && controller.machineState == Grbl::MachineState::Idle;
+        snapshot.anyAlarm = snapshot.anyAlarm || controller.machineState == Grbl::MachineState::Alarm;
+
+        if (controller.receivedAt == 0)
+        {
+            neverReported = true;
+        }
+        else if (snapshot.oldestReportAt == 0 || static_cast<int32_t>(controller.receivedAt - snapshot.oldestReportAt) < 0)
+        {
+            snapshot.oldestReportAt = controller.receivedAt;
+        }
+    }
+
+    if (neverReported)
+    {
+        snapshot.oldestReportAt = 0;
+    }
+
+    return snapshot;
+}
+
+ControllerStatistics GrblCluster::getStatistics(size_t index)
+{
+    auto statistics = m_statistics[index];
+    statistics.streaming = m_controllers[index]->getStreamingStatistics();
+    return statistics;
+}
+
+void GrblCluster::resetStatistics()
+{
+    for (size_t i = 0; i < m_size; i++)
+    {
+        m_statistics[i] = {};
+        m_controllers[i]->resetStreamingStatistics();
+    }
+}
+
+// --------------------------------------------------------------------------------------------------
+// Private methods
+// --------------------------------------------------------------------------------------------------
+
+void GrblCluster::pollStatusReports()
+{
+    if (m_size == 0)
+    {
+        return;
+    }
+
+    uint32_t interval = UINT32_MAX;
+
+    for (size_t i = 0; i < m_size; i++)
+    {
+        interval = std::min(interval, m_controllers[i]->statusReportInterval());
+    }
+
+    const auto now = Grbl::Platform::millis();
+
+    if (now - m_statusReportsRequestedAt < interval)
+    {
+        return;
+    }
+
+    m_statusReportsRequestedAt = now;
+
+    for (size_t i = 0; i < m_size; i++)
+    {
+        if (!m_controllers[i]->statusReportPending())
+        {
+            (void)m_controllers[i]->getStatusReport();
+            m_statistics[i].statusReportsRequested++;
+        }
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "GrblInterface.h"
+
+#include <array>
+
+namespace Grbl
+{
+    constexpr auto MAX_CLUSTER_SIZE = 8;
+}
+
+struct ControllerStatistics
+{
+    StreamingStatistics streaming;
+    uint32_t updates;
+    uint32_t statusReportsRequested;
+    uint32_t busyMicros;      // Time spent in the controller's update().
+    uint32_t maxUpdateMicros; // Longest single update().
+};
+
+struct ClusterSnapshot
+{
+    size_t size;
+    std::array<StatusSnapshot, Grbl::MAX_CLUSTER_SIZE> controllers;
+    bool allIdle;
+    bool anyAlarm;
+    uint32_t oldestReportAt; // receivedAt of the least recent report, 0 if a controller never reported.
+};
+
+// Services several controllers, each on its own stream, from one loop or task. Every update() gives each
+// controller one turn, starting with a different one each time so none is always served last. Status
+// reports are requested from all controllers at once, at the shortest interval any of them needs, so
+// the reports arrive together and aggregated snapshots are close in time. The controllers keep their own
+// polling, which only comes into play when the cluster is not updated, e.g. during a blocking call on one.
+class GrblCluster
+{
+public:
+    [[nodiscard]] bool add(GrblInterface &controller);
+    [[nodiscard]] size_t size();
+    [[nodiscard]] GrblInterface &operator[](size_t index);
+
+    void update();
+
+    [[nodiscard]] ClusterSnapshot getSnapshot() const;
+    [[nodiscard]] ControllerStatistics getStatistics(size_t index);
+    void resetStatistics();
+
+private:
+    std::array<GrblInterface *, Grbl::MAX_CLUSTER_SIZE> m_controllers{};
+    std::array<ControllerStatistics, Grbl::MAX_CLUSTER_SIZE> m_statistics{};
+    size_t m_size = 0;
+    size_t m_next = 0;
+    uint32_t m_statusReportsRequestedAt = 0;
+
+    void pollStatusReports();
+};
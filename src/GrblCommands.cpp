@@ -2,7 +2,7 @@
 
 #include <array>
 
-constexpr std::array<char *, 63> commands = {
+constexpr std::array<const char *, 63> commands = {
     "G0",      // G0_RapidPositioning
     "G1",      // G1_LinearInterpolation
     "G2",      // G2_ClockwiseCircularInterpolation
@@ -68,7 +68,7 @@ constexpr std::array<char *, 63> commands = {
     "$Bye"     // RebootProcessor
 };
 
-char *Grbl::getCommand(const Command command)
+const char *Grbl::getCommand(const Command command)
 {
     return commands[static_cast<int>(command)];
 }
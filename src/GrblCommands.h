@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 namespace Grbl
 {
     enum class Command
@@ -74,5 +76,33 @@ namespace Grbl
         RebootProcessor
     };
 
-    [[nodiscard]] char *getCommand(Command command);
+    // Realtime commands are single bytes that Grbl picks off the serial stream as soon as they arrive.
+    // They bypass the RX buffer and the planner, and are never acknowledged with "ok".
+    enum class RealtimeCommand : uint8_t
+    {
+        StatusReport = '?',
+        CycleStart = '~',
+        FeedHold = '!',
+        SoftReset = 0x18,
+        SafetyDoor = 0x84,
+        JogCancel = 0x85,
+        FeedOverrideReset = 0x90,
+        FeedOverrideCoarseIncrease = 0x91,
+        FeedOverrideCoarseDecrease = 0x92,
+        FeedOverrideFineIncrease = 0x93,
+        FeedOverrideFineDecrease = 0x94,
+        RapidOverrideReset = 0x95,
+        RapidOverrideMedium = 0x96,
+        RapidOverrideLow = 0x97,
+        SpindleOverrideReset = 0x99,
+        SpindleOverrideCoarseIncrease = 0x9A,
+        SpindleOverrideCoarseDecrease = 0x9B,
+        SpindleOverrideFineIncrease = 0x9C,
+        SpindleOverrideFineDecrease = 0x9D,
+        ToggleSpindleStop = 0x9E,
+        ToggleFloodCoolant = 0xA0,
+        ToggleMistCoolant = 0xA1
+    };
+
+    [[nodiscard]] const char *getCommand(Command command);
 }
\ No newline at end of file
@@ -1,12 +1,82 @@
 #pragma once
 
 #include <array>
+#include <cstdint>
+
+// Build configuration, set through the compiler flags (e.g. build_flags in platformio.ini):
+//   GRBL_INTERFACE_AXES=n                   Axes Grbl is compiled for, 1 to 6, sizes every coordinate.
+//   GRBL_INTERFACE_NO_ARCS                  Leaves out G2/G3 commands and arc path segments.
+//   GRBL_INTERFACE_NO_JOGGING               Leaves out jog(), cancelJog() and JogController.
+//   GRBL_INTERFACE_NO_WORK_COORDINATE_OFFSET Leaves out WCO tracking; only the position Grbl reports is known,
+//                                           the other one mirrors it as if the offset were zero.
+//   GRBL_INTERFACE_NO_STATS                 Leaves out GrblInterface::Stats and the measurements behind it.
+//   GRBL_INTERFACE_NO_READER_TASK           Leaves out startReaderTask() and the queue of received lines behind it.
+#if !defined(GRBL_INTERFACE_AXES)
+#define GRBL_INTERFACE_AXES 6
+#endif
+
+static_assert(GRBL_INTERFACE_AXES >= 1 && GRBL_INTERFACE_AXES <= 6, "Grbl supports 1 to 6 axes");
 
 namespace Grbl
 {
     constexpr auto DEFAULT_TIMEOUT_MS = 100;
-    constexpr auto MAX_NUMBER_OF_AXES = 6;
+    constexpr auto MAX_NUMBER_OF_AXES = GRBL_INTERFACE_AXES;
     constexpr auto FLOAT_PRECISION = 3;
+    constexpr auto DEFAULT_COMPACT_TOLERANCE = 0.0005f; // Half a digit of FLOAT_PRECISION, as exact as fixed decimals.
+    constexpr auto RX_BUFFER_SIZE = 127;     // Usable bytes of Grbl's serial receive buffer.
+    constexpr auto RX_BUFFER_SIZE_UNCHANGED = 0; // Keeps the RX buffer size set before.
+    constexpr auto MAX_LINES_IN_FLIGHT = 32; // Upper bound of unacknowledged lines tracked while streaming.
+    constexpr auto COMMAND_QUEUE_SIZE = 16;  // Lines waiting to be handed over to Grbl.
+    // Outcomes of the last commands completed, kept for status queries. Covers every line one update() can
+    // complete, the lines in flight and the queued lines withdrawn by a reset.
+    constexpr auto COMMAND_HISTORY_SIZE = MAX_LINES_IN_FLIGHT + COMMAND_QUEUE_SIZE;
+    constexpr auto DEFAULT_COMMAND_TIMEOUT_MS = 1000;
+    constexpr auto PLANNER_BLOCKS = 15; // A stock Grbl 1.1 keeps one of its 16 planner blocks free.
+    constexpr auto PLANNER_TARGET_DEPTH_AUTO = 0; // The planner capacity learned from Bf:.
+
+    // Identifies a queued command. Tickets are handed out and completed in ascending order.
+    using Ticket = uint32_t;
+    constexpr Ticket INVALID_TICKET = 0;
+
+    // Identifies a path submitted with GrblInterface::sendPath() or sendPolyline().
+    using PathHandle = uint32_t;
+    constexpr PathHandle INVALID_PATH = 0;
+    constexpr auto MAX_PATH_SEGMENTS_PENDING = COMMAND_QUEUE_SIZE + MAX_LINES_IN_FLIGHT;
+
+    // Identifies a listener added with GrblInterface::subscribe().
+    using SubscriptionHandle = uint8_t;
+    constexpr SubscriptionHandle INVALID_SUBSCRIPTION = 0;
+    constexpr auto MAX_STATUS_SUBSCRIPTIONS = 8;
+    constexpr auto DEFAULT_POSITION_CHANGE_THRESHOLD = 0.001f; // mm, the resolution of the reported positions.
+
+    enum class CommandStatus
+    {
+        Queued,    // Waiting for room in Grbl's RX buffer.
+        Sent,      // Waiting for "ok" or "error:".
+        Ok,
+        Error,
+        Timeout,   // The controller went silent, or a blocking call gave up before the line was sent.
+        Cancelled, // Discarded by a reset or a jog cancel.
+        Unknown
+    };
+
+    enum class PathState
+    {
+        Running,
+        Completed,
+        Failed,    // At least one segment was rejected or timed out.
+        Cancelled, // Stopped by cancelPath() or a reset before all segments were sent.
+        Unknown
+    };
+
+    enum class SegmentType : uint8_t
+    {
+        Line,
+#if !defined(GRBL_INTERFACE_NO_ARCS)
+        ClockwiseArc,
+        CounterClockwiseArc
+#endif
+    };
 
     enum class UnitOfMeasurement
     {
@@ -28,15 +98,15 @@ namespace Grbl
         Unknown
     };
 
-    inline constexpr std::array<char *, 9> machineStates = {"Idle",
-                                                            "Run",
-                                                            "Hold",
-                                                            "Jog",
-                                                            "Alarm",
-                                                            "Door",
-                                                            "Check",
-                                                            "Home",
-                                                            "Sleep"};
+    inline constexpr std::array<const char *, 9> machineStates = {"Idle",
+                                                                  "Run",
+                                                                  "Hold",
+                                                                  "Jog",
+                                                                  "Alarm",
+                                                                  "Door",
+                                                                  "Check",
+                                                                  "Home",
+                                                                  "Sleep"};
 
     enum class Axis
     {
@@ -49,7 +119,75 @@ namespace Grbl
         Unknown
     };
 
-    inline constexpr std::array<char, MAX_NUMBER_OF_AXES> axes = {'X', 'Y', 'Z', 'A', 'B', 'C'};
+    [[nodiscard]] constexpr std::array<char, MAX_NUMBER_OF_AXES> makeAxes()
+    {
+        constexpr char letters[] = "XYZABC";
+        std::array<char, MAX_NUMBER_OF_AXES> axes = {};
+
+        for (auto i = 0; i < MAX_NUMBER_OF_AXES; i++)
+        {
+            axes[i] = letters[i];
+        }
+
+        return axes;
+    }
+
+    inline constexpr std::array<char, MAX_NUMBER_OF_AXES> axes = makeAxes();
+
+    // Position of an axis in axes and in every coordinate, -1 if it is unknown or not configured.
+    [[nodiscard]] constexpr int axisIndex(Axis axis)
+    {
+        return axis != Axis::Unknown && static_cast<int>(axis) < MAX_NUMBER_OF_AXES ? static_cast<int>(axis) : -1;
+    }
+
+    [[nodiscard]] constexpr int axisIndex(char letter)
+    {
+        if (letter >= 'X' && letter <= 'Z')
+        {
+            return axisIndex(static_cast<Axis>(letter - 'X'));
+        }
+
+        if (letter >= 'A' && letter <= 'C')
+        {
+            return axisIndex(static_cast<Axis>(letter - 'A' + 3));
+        }
+
+        return -1;
+    }
+
+    // Control pins reported in the Pn: field of status reports, as bits of a mask.
+    enum class ControlPin : uint8_t
+    {
+        Probe = 1 << 0,     // P
+        Door = 1 << 1,      // D
+        Hold = 1 << 2,      // H
+        SoftReset = 1 << 3, // R
+        CycleStart = 1 << 4 // S
+    };
+
+    // Accessories reported in the A: field of status reports, as bits of a mask.
+    enum class Accessory : uint8_t
+    {
+        SpindleClockwise = 1 << 0,        // S
+        SpindleCounterClockwise = 1 << 1, // C
+        FloodCoolant = 1 << 2,            // F
+        MistCoolant = 1 << 3              // M
+    };
+
+    // Groups of status fields, as bits of the masks GrblInterface::subscribe() takes and hands to listeners.
+    enum class StatusChange : uint16_t
+    {
+        State = 1 << 0,                // Machine state or sub-state.
+        Position = 1 << 1,             // Moved further than the position change threshold.
+        WorkCoordinateOffset = 1 << 2, // WCO:
+        FeedAndSpeed = 1 << 3,         // FS:
+        Pins = 1 << 4,                 // Limit switches or control pins.
+        Overrides = 1 << 5,            // Ov:
+        Accessories = 1 << 6,          // A:
+        LineNumber = 1 << 7,           // Ln:
+        Alarm = 1 << 8,                // An "ALARM:" message, also when it repeats the last one.
+        Error = 1 << 9                 // An "error:" response.
+    };
 
     enum class CoordinateMode
     {
@@ -59,7 +197,7 @@ namespace Grbl
         Unknown
     };
 
-    inline constexpr std::array<char *, 3> coordinateModes = {"MPos", "WPos", "WCO"};
+    inline constexpr std::array<const char *, 3> coordinateModes = {"MPos", "WPos", "WCO"};
 
     enum class DistanceMode
     {
@@ -89,6 +227,22 @@ namespace Grbl
         P6
     };
 
+    enum class OverrideAdjustment
+    {
+        Reset,          // Back to 100%
+        CoarseIncrease, // +10%
+        CoarseDecrease, // -10%
+        FineIncrease,   // +1%
+        FineDecrease    // -1%
+    };
+
+    enum class RapidOverride
+    {
+        Full,   // 100%
+        Medium, // 50%
+        Low     // 25%
+    };
+
     enum class Plane
     {
         XY,
@@ -1,734 +1,2608 @@
 #include "GrblInterface.h"
 #include "Utils.h"
 
-#include <Regexp.h>
+#include "GrblParser.h"
 
 #include <algorithm>
+#include <cmath>
+#include <cstring>
 
 namespace
 {
     constexpr auto COORDINATE_SYSTEM_INDICATOR = 'P';
     constexpr auto RADIUS_INDICATOR = 'R';
     constexpr auto FEED_RATE_INDICATOR = 'F';
-    constexpr auto VALUE_SEPARATOR = ',';
-    constexpr auto ERROR_RESPONSE = "error";
     constexpr auto EOL = '\r';
-    constexpr auto STATUS_REPORT_MIN_INTERVAL_MS = 200; // Limits the status report query to 5Hz, as recommended by Grbl.
+    constexpr auto LINE_TERMINATOR = '\n'; // Grbl acknowledges '\r' and '\n' separately, so only one is sent.
+    constexpr auto STATUS_REPORT_INTERVAL_MS = 200; // 5Hz, as recommended by Grbl, for states without motion.
+    constexpr auto STATUS_REPORT_MOTION_INTERVAL_MS = 100;
+    constexpr auto STATUS_REPORT_IDLE_INTERVAL_MS = 1000;
+    constexpr auto STATUS_REPORT_RESPONSE_TIMEOUT_MS = 500; // A request whose report got lost is repeated.
+    constexpr auto PLANNER_FLOW_CONTROL_REPORT_INTERVAL_MS = 10;
+    constexpr auto PLANNER_FLOW_CONTROL_LINES_AHEAD = 2; // In flight beyond the target, raised if it runs short.
+    constexpr auto MICROS_PER_MINUTE = 60000000.0f;
     constexpr auto RESPONSE_TIMEOUT = 200;
+    constexpr auto DEFAULT_OVERRIDE = 100;
+    constexpr auto JITTER_SMOOTHING = 16.0f; // Gain 1/16 as in RFC 3550.
 
-    namespace RegEx
+    namespace Response
     {
-        // Note: To test Lua style regex, use the following tool:
-        // https://montymahato.github.io/lua-pattern-tester/
-        constexpr auto STATUS_REPORT = "<([%w:%d]+)%|(%w+):([-%d.,]+)[%|]?.*>";
-        constexpr auto FEED_AND_SPEED = "FS:(%-?%d+%.?%d*),(%-?%d+%.?%d*)";
-        constexpr auto LIMIT_SWITCH = "Pn:([A-Z]+)";
-        constexpr auto WORK_COORDINATE_OFFSET = "WCO:([%-?%d+%.?%d*,]*)";
-        constexpr auto OK_RESPONSE = "ok";
-        constexpr auto ALARM_CODE = "ALARM:([%d]+)";
-        constexpr auto ERROR_CODE = "error:([%d]+)";
+        constexpr auto STATUS_REPORT_START = '<';
+        constexpr auto STATUS_REPORT_END = '>';
+        constexpr auto FIELD_SEPARATOR = '|';
+        constexpr auto SUB_STATE_SEPARATOR = ':';
+        constexpr auto VALUE_SEPARATOR = ',';
+        constexpr auto OK = "ok";
+        constexpr auto ERROR_CODE = "error:";
+        constexpr auto ALARM_CODE = "ALARM:";
+        constexpr auto WELCOME_MESSAGE = "Grbl ";
+        constexpr auto MACHINE_POSITION = "MPos:";
+        constexpr auto WORK_POSITION = "WPos:";
+        constexpr auto WORK_COORDINATE_OFFSET = "WCO:";
+        constexpr auto FEED_AND_SPEED = "FS:";
+        constexpr auto FEED = "F:"; // Instead of FS: when Grbl is built without variable spindle speed.
+        constexpr auto PINS = "Pn:";
+        constexpr auto BUFFER_STATE = "Bf:";
+        constexpr auto LINE_NUMBER = "Ln:";
+        constexpr auto OVERRIDES = "Ov:";
+        constexpr auto ACCESSORIES = "A:";
+        constexpr auto PARSER_STATE = "[GC:";
     }
 
-    namespace ResponseIndex
+    [[nodiscard]] Grbl::MachineState findMachineState(const char *name, size_t length)
     {
-        constexpr auto STATUS_REPORT_MACHINE_STATE = 0;
-        constexpr auto STATUS_REPORT_POSITION_MODE = 1;
-        constexpr auto STATUS_REPORT_POSITION = 2;
-        constexpr auto STATUS_REPORT_FEED_RATE = 0;
-        constexpr auto STATUS_REPORT_SPINDLE_SPEED = 1;
-        constexpr auto STATUS_REPORT_LIMIT_SWITCH = 0;
-        constexpr auto STATUS_REPORT_WORK_COORDINATE_OFFSET = 0;
+        for (size_t i = 0; i < Grbl::machineStates.size(); i++)
+        {
+            const auto state = Grbl::machineStates[i];
+
+            if (strncmp(name, state, length) == 0 && state[length] == '\0')
+            {
+                return static_cast<Grbl::MachineState>(i);
+            }
+        }
+
+        return Grbl::MachineState::Unknown;
+    }
+
+    [[nodiscard]] uint8_t findControlPin(char letter)
+    {
+        switch (letter)
+        {
+        case 'P':
+        {
+            return static_cast<uint8_t>(Grbl::ControlPin::Probe);
+        }
+        case 'D':
+        {
+            return static_cast<uint8_t>(Grbl::ControlPin::Door);
+        }
+        case 'H':
+        {
+            return static_cast<uint8_t>(Grbl::ControlPin::Hold);
+        }
+        case 'R':
+        {
+            return static_cast<uint8_t>(Grbl::ControlPin::SoftReset);
+        }
+        case 'S':
+        {
+            return static_cast<uint8_t>(Grbl::ControlPin::CycleStart);
+        }
+        default:
+        {
+            return 0;
+        }
+        }
+    }
+
+    [[nodiscard]] uint8_t findAccessory(char letter)
+    {
+        switch (letter)
+        {
+        case 'S':
+        {
+            return static_cast<uint8_t>(Grbl::Accessory::SpindleClockwise);
+        }
+        case 'C':
+        {
+            return static_cast<uint8_t>(Grbl::Accessory::SpindleCounterClockwise);
+        }
+        case 'F':
+        {
+            return static_cast<uint8_t>(Grbl::Accessory::FloodCoolant);
+        }
+        case 'M':
+        {
+            return static_cast<uint8_t>(Grbl::Accessory::MistCoolant);
+        }
+        default:
+        {
+            return 0;
+        }
+        }
     }
 }
 
+PositionList::PositionList(std::initializer_list<PositionPair> positions)
+    : PositionList(positions.begin(), positions.size())
+{
+}
+
+PositionList::PositionList(const std::vector<PositionPair> &positions)
+    : PositionList(positions.data(), positions.size())
+{
+}
+
+PositionList::PositionList(const PositionPair *positions, size_t count)
+    : m_positions{},
+      m_count(std::min<size_t>(count, Grbl::MAX_NUMBER_OF_AXES)),
+      m_overflowed(count > Grbl::MAX_NUMBER_OF_AXES)
+{
+    std::copy(positions, positions + m_count, m_positions.begin());
+}
+
+const PositionPair *PositionList::begin() const
+{
+    return m_positions.data();
+}
+
+const PositionPair *PositionList::end() const
+{
+    return m_positions.data() + m_count;
+}
+
+size_t PositionList::size() const
+{
+    return m_count;
+}
+
+bool PositionList::overflowed() const
+{
+    return m_overflowed;
+}
+
+#if defined(ARDUINO)
 GrblInterface::GrblInterface(Stream &stream)
+    : GrblInterface(static_cast<Grbl::ByteStream &>(m_arduinoStream))
+{
+    m_arduinoStream = Grbl::ArduinoStream(stream);
+}
+#endif
+
+GrblInterface::GrblInterface(Grbl::ByteStream &stream)
     : m_stream(&stream),
+      m_received{},
+      m_machineState(Grbl::MachineState::Unknown),
+      m_workCoordinate{},
+#if !defined(GRBL_INTERFACE_NO_WORK_COORDINATE_OFFSET)
+      m_workCoordinateOffset{},
+#endif
+      m_machineCoordinate{},
       m_currentFeedRate(0),
       m_currentSpindleSpeed(0),
       m_currentAlarm(Grbl::Alarm::None),
-      m_currentError(Grbl::Error::None)
+      m_currentError(Grbl::Error::None),
+      m_limitSwitches(0),
+      m_controlPins(0),
+      m_subState(0),
+      m_plannerBlocksAvailable(-1),
+      m_rxBytesAvailable(-1),
+      m_lineNumber(0),
+      m_feedOverride(DEFAULT_OVERRIDE),
+      m_rapidOverride(DEFAULT_OVERRIDE),
+      m_spindleOverride(DEFAULT_OVERRIDE),
+      m_accessories(0),
+      m_lastLineReceivedAt(0),
+      m_motionStatusReportInterval(STATUS_REPORT_MOTION_INTERVAL_MS),
+      m_idleStatusReportInterval(STATUS_REPORT_IDLE_INTERVAL_MS),
+      m_statusReportRequestedAt(0),
+      m_statusReportRequestedAtMicros(0),
+      m_statusReportPending(false),
+      m_automaticStatusReports(true),
+      m_compactEmission(false),
+      m_compactTolerance(Grbl::DEFAULT_COMPACT_TOLERANCE),
+      m_modalStateTracking(false),
+      m_modalChangeTicket(Grbl::INVALID_TICKET),
+      m_parserStateTicket(Grbl::INVALID_TICKET),
+      m_subscriptions{},
+      m_notifiedSnapshot{},
+      m_positionChangeThreshold(Grbl::DEFAULT_POSITION_CHANGE_THRESHOLD),
+      m_streamingMode(false),
+      m_plannerFlowControl(false),
+      m_plannerTargetDepth(Grbl::PLANNER_TARGET_DEPTH_AUTO),
+      m_plannerCapacity(-1),
+      m_plannerBlocksQueued(0),
+      m_linesAcknowledgedSinceReport(0),
+      m_plannerReportAt(0),
+      m_plannerReportFeedRate(0),
+      m_plannerBlockLength(0),
+      m_plannerLinesAhead(PLANNER_FLOW_CONTROL_LINES_AHEAD),
+      m_plannerHeldBack(false),
+      m_asynchronousMode(false),
+      m_resetPending(false),
+      m_rxBufferSize(Grbl::RX_BUFFER_SIZE),
+      m_commandTimeout(Grbl::DEFAULT_COMMAND_TIMEOUT_MS),
+      m_lastTicket(Grbl::INVALID_TICKET),
+      m_lastCompletedTicket(Grbl::INVALID_TICKET),
+      m_completedCommands{},
+      m_bytesInFlight(0),
+      m_streamingStartedAt(0),
+      m_streamingStatistics{},
+#if !defined(GRBL_INTERFACE_NO_STATS)
+      m_stats{},
+      m_statsStartedAt(Grbl::Platform::millis()),
+      m_lastStatusReportAt(0),
+      m_lastStatusReportInterval(0),
+#endif
+      m_pathSegments(nullptr),
+      m_pathPoints(nullptr),
+      m_pathFeedRate(0),
+      m_pathStopOnError(true),
+      m_pathStopped(false),
+      m_pathCancelled(false),
+      m_pathHandle(Grbl::INVALID_PATH),
+      m_pathProgress{}
 {
+    m_pathProgress.state = Grbl::PathState::Unknown;
+    m_notifiedSnapshot = publishStatusSnapshot(Grbl::CoordinateMode::Unknown, 0);
 }
 
 void GrblInterface::update(uint16_t timeout)
 {
-    static uint32_t nextStatusReportRequestAt = 0;
+    pollStatusReport();
+    feedPath();
+    dispatchQueuedLines();
+    checkCommandTimeout();
 
-    if (millis() >= nextStatusReportRequestAt)
+#if !defined(GRBL_INTERFACE_NO_READER_TASK)
+    if (m_reader.running())
     {
-        sendCommand(Grbl::Command::StatusReport, false);
-        nextStatusReportRequestAt = millis() + STATUS_REPORT_MIN_INTERVAL_MS;
+        processReceivedLines();
+        return;
     }
+#endif
 
     if (!m_stream->available())
     {
         return;
     }
 
-    const auto timeoutAt = millis() + timeout;
-    std::stringstream ss;
+    const auto timeoutAt = Grbl::Platform::millis() + timeout;
 
-    while (m_stream->available() && millis() < timeoutAt)
+    while (m_stream->available() && Grbl::Platform::millis() < timeoutAt)
     {
         const char c = m_stream->read();
-        // Serial.print(c);
+#if !defined(GRBL_INTERFACE_NO_STATS)
+        m_stats.bytesReceived++;
+#endif
 
         if (c == EOL)
         {
-            m_buffer.append(ss.str());
-            processBuffer();
+            // A truncated status report or message would be misread, so it is dropped altogether.
+            if (!m_received.truncated)
+            {
+                m_received.text[m_received.length] = '\0';
+                processLine(m_received.text, m_received.length);
+            }
+#if !defined(GRBL_INTERFACE_NO_STATS)
+            else
+            {
+                m_stats.linesDropped++;
+            }
+#endif
+
+            m_received.length = 0;
+            m_received.truncated = false;
+            dispatchQueuedLines();
             return;
         }
 
-        ss << c;
-    }
-
-    if (!ss.str().empty())
-    {
-        m_buffer.append(ss.str());
+        if (m_received.length < sizeof(m_received.text) - 1)
+        {
+            m_received.text[m_received.length++] = c;
+        }
+        else
+        {
+            m_received.truncated = true;
+        }
     }
 }
 
 void GrblInterface::clearBuffer()
 {
+#if !defined(GRBL_INTERFACE_NO_READER_TASK)
+    if (m_reader.running())
+    {
+        while (m_reader.front() != nullptr)
+        {
+            m_reader.pop();
+        }
+
+        return;
+    }
+#endif
+
     while (m_stream->available())
     {
         m_stream->read();
     }
 }
 
-bool GrblInterface::getStatusReport(bool waitForOkResponse)
+bool GrblInterface::getStatusReport()
 {
-    return sendCommand(Grbl::Command::StatusReport, waitForOkResponse);
+    // '?' is a realtime command: Grbl answers with a status report, never with "ok".
+    sendRealtimeCommand(Grbl::RealtimeCommand::StatusReport);
+    m_statusReportRequestedAt = Grbl::Platform::millis();
+    m_statusReportRequestedAtMicros = Grbl::Platform::micros();
+    m_statusReportPending = true;
+    return true;
 }
 
-std::vector<Grbl::Axis> GrblInterface::limitSwitchesTriggered()
+void GrblInterface::setStatusReportIntervals(uint16_t motionInterval, uint16_t idleInterval)
 {
-    return m_limitSwitchesTriggered;
+    m_motionStatusReportInterval = motionInterval;
+    m_idleStatusReportInterval = idleInterval;
 }
 
-// G-codes
-bool GrblInterface::setUnitOfMeasurement(const Grbl::UnitOfMeasurement unitOfMeasurement)
+void GrblInterface::setAutomaticStatusReports(bool enabled)
 {
-    switch (unitOfMeasurement)
+    m_automaticStatusReports = enabled;
+}
+
+uint32_t GrblInterface::statusReportInterval()
+{
+    // Lines held back by the planner flow control wait for a report showing that blocks were executed, even
+    // when the last one said Idle.
+    if (!m_queuedLines.empty() && plannerDepthReached())
     {
-    case Grbl::UnitOfMeasurement::Inches:
+        return PLANNER_FLOW_CONTROL_REPORT_INTERVAL_MS;
+    }
+
+    const auto waitingForGrbl = !m_linesInFlight.empty();
+
+    switch (m_machineState)
+    {
+    case Grbl::MachineState::Run:
+    case Grbl::MachineState::Jog:
+    case Grbl::MachineState::Home:
+    {
+        break;
+    }
+    case Grbl::MachineState::Idle:
+    case Grbl::MachineState::Alarm:
     {
-        return sendCommand(Grbl::Command::G20_UnitsInches);
+        if (!waitingForGrbl)
+        {
+            return m_idleStatusReportInterval;
+        }
+
+        break;
     }
-    case Grbl::UnitOfMeasurement::Millimeters:
+    default:
     {
-        return sendCommand(Grbl::Command::G21_UnitsMillimeters);
+        if (!waitingForGrbl)
+        {
+            return STATUS_REPORT_INTERVAL_MS;
+        }
+
+        break;
+    }
     }
+
+    // A nearly full RX buffer means Grbl is busy parsing streamed lines; every report costs it time as well.
+    if (m_streamingMode && m_bytesInFlight * 4 >= m_rxBufferSize * 3)
+    {
+        return m_motionStatusReportInterval * 2;
     }
+
+    return m_motionStatusReportInterval;
 }
 
-bool GrblInterface::setDistanceMode(Grbl::DistanceMode distanceMode)
+bool GrblInterface::statusReportPending()
 {
-    switch (distanceMode)
-    {
-    case Grbl::DistanceMode::Absolute:
+    // A request whose report got lost does not block the next one forever.
+    return m_statusReportPending &&
+           Grbl::Platform::millis() - m_statusReportRequestedAt < STATUS_REPORT_RESPONSE_TIMEOUT_MS;
+}
+
+uint8_t GrblInterface::limitSwitchMask()
+{
+    return m_limitSwitches;
+}
+
+std::vector<Grbl::Axis> GrblInterface::limitSwitchesTriggered()
+{
+    std::vector<Grbl::Axis> axes;
+
+    for (auto i = 0; i < Grbl::MAX_NUMBER_OF_AXES; i++)
     {
-        return sendCommand(Grbl::Command::G90_DistanceModeAbsolute);
+        if (m_limitSwitches & (1 << i))
+        {
+            axes.push_back(static_cast<Grbl::Axis>(i));
+        }
     }
-    case Grbl::DistanceMode::Incremental:
+
+    return axes;
+}
+
+void GrblInterface::setStreamingMode(bool enabled, uint16_t rxBufferSize)
+{
+    m_streamingMode = enabled;
+
+    if (rxBufferSize != Grbl::RX_BUFFER_SIZE_UNCHANGED)
     {
-        return sendCommand(Grbl::Command::G91_DistanceModeIncremental);
+        m_rxBufferSize = rxBufferSize;
     }
+}
+
+bool GrblInterface::streamingModeEnabled()
+{
+    return m_streamingMode;
+}
+
+void GrblInterface::setPlannerFlowControl(bool enabled, uint8_t targetDepth)
+{
+    m_plannerFlowControl = enabled;
+    m_plannerTargetDepth = targetDepth;
+    m_plannerLinesAhead = PLANNER_FLOW_CONTROL_LINES_AHEAD;
+}
+
+bool GrblInterface::plannerFlowControlEnabled()
+{
+    return m_plannerFlowControl;
+}
+
+int GrblInterface::plannerDepthEstimate()
+{
+    if (m_plannerCapacity < 0)
+    {
+        return -1;
     }
+
+    return m_plannerBlocksQueued + m_linesAcknowledgedSinceReport - plannerBlocksRunSinceReport() +
+           static_cast<int>(m_linesInFlight.size());
 }
 
-bool GrblInterface::setCoordinateOffset(const std::vector<PositionPair> &position)
+void GrblInterface::setAsynchronousMode(bool enabled)
 {
-    resetStringStream();
-    appendCommand(Grbl::Command::G92_CoordinateOffset);
-    serializePosition(position);
-    send();
+    m_asynchronousMode = enabled;
 }
 
-bool GrblInterface::clearCoordinateOffset()
+bool GrblInterface::asynchronousModeEnabled()
 {
-    sendCommand(Grbl::Command::G92_1_ClearCoordinateSystemOffsets);
+    return m_asynchronousMode;
 }
 
-bool GrblInterface::linearRapidPositioning(const std::vector<PositionPair> &position)
+void GrblInterface::setCommandTimeout(uint32_t timeout)
 {
-    resetStringStream();
-    appendCommand(Grbl::Command::G0_RapidPositioning);
-    serializePosition(position);
-    return sendWaitingForOkResponse(RESPONSE_TIMEOUT);
+    m_commandTimeout = timeout;
 }
 
-bool GrblInterface::linearInterpolationPositioning(float feedRate, const std::vector<PositionPair> &position)
+Grbl::Ticket GrblInterface::sendLine(const char *line)
 {
-    resetStringStream();
-    appendCommand(Grbl::Command::G1_LinearInterpolation);
-    appendValue(FEED_RATE_INDICATOR, feedRate);
-    serializePosition(position);
-    return sendWaitingForOkResponse(RESPONSE_TIMEOUT);
+    resetLine();
+    m_line.append(line);
+    return enqueueLine() ? m_lastTicket : Grbl::INVALID_TICKET;
 }
 
-bool GrblInterface::linearPositioningInMachineCoordinate(const std::vector<PositionPair> &position)
+Grbl::Ticket GrblInterface::lastTicket()
 {
-    resetStringStream();
-    appendCommand(Grbl::Command::G53_MoveInAbsoluteCoordinates);
-    serializePosition(position);
-    return sendWaitingForOkResponse(RESPONSE_TIMEOUT);
+    return m_lastTicket;
 }
 
-bool GrblInterface::arcInterpolationPositioning(Grbl::ArcMovement direction,
-                                                const std::vector<PositionPair> &endPosition,
-                                                float radius,
-                                                float feedRate)
+Grbl::Ticket GrblInterface::lastCompletedTicket()
 {
-    resetStringStream();
-    switch (direction)
-    {
-    case Grbl::ArcMovement::Clockwise:
+    return m_lastCompletedTicket;
+}
+
+Grbl::CommandStatus GrblInterface::commandStatus(Grbl::Ticket ticket)
+{
+    if (ticket == Grbl::INVALID_TICKET || ticket > m_lastTicket)
     {
-        appendCommand(Grbl::Command::G2_ClockwiseCircularInterpolation);
-        break;
+        return Grbl::CommandStatus::Unknown;
     }
-    case Grbl::ArcMovement::CounterClockwise:
+
+    if (ticket > m_lastCompletedTicket)
     {
-        appendCommand(Grbl::Command::G3_CounterclockwiseCircularInterpolation);
-        break;
+        if (!m_linesInFlight.empty() && ticket <= m_linesInFlight.back().ticket)
+        {
+            return Grbl::CommandStatus::Sent;
+        }
+
+        return Grbl::CommandStatus::Queued;
     }
+
+    const auto &completed = m_completedCommands[ticket % m_completedCommands.size()];
+
+    // Overwritten by a later ticket, the outcome is no longer known.
+    if (completed.ticket != ticket)
+    {
+        return Grbl::CommandStatus::Unknown;
     }
 
-    serializePosition(endPosition);
-    appendValue(RADIUS_INDICATOR, radius);
-    appendValue(FEED_RATE_INDICATOR, feedRate);
-    return sendWaitingForOkResponse(RESPONSE_TIMEOUT);
+    return completed.status;
 }
 
-bool GrblInterface::arcInterpolationPositioning(Grbl::ArcMovement direction,
-                                                const std::vector<PositionPair> &endPosition,
-                                                Point centerPoint,
-                                                float feedRate)
+bool GrblInterface::waitForCommand(Grbl::Ticket ticket, uint32_t timeout)
 {
-    resetStringStream();
-    switch (direction)
-    {
-    case Grbl::ArcMovement::Clockwise:
-    {
-        appendCommand(Grbl::Command::G2_ClockwiseCircularInterpolation);
-        break;
-    }
-    case Grbl::ArcMovement::CounterClockwise:
+    const auto startedAt = Grbl::Platform::millis();
+    auto status = commandStatus(ticket);
+
+    while (status == Grbl::CommandStatus::Queued || status == Grbl::CommandStatus::Sent)
     {
-        appendCommand(Grbl::Command::G3_CounterclockwiseCircularInterpolation);
-        break;
-    }
+        if (Grbl::Platform::millis() - startedAt >= timeout)
+        {
+            return false;
+        }
+
+        updateWhileBlocking();
+        status = commandStatus(ticket);
     }
 
-    serializePosition(endPosition);
-    appendValue('I', centerPoint.first);
-    appendValue('J', centerPoint.second);
-    appendValue(FEED_RATE_INDICATOR, feedRate);
-    return sendWaitingForOkResponse(RESPONSE_TIMEOUT);
+    return status == Grbl::CommandStatus::Ok;
 }
 
-bool GrblInterface::dwell(uint16_t durationSeconds)
+size_t GrblInterface::commandsQueued()
 {
-    resetStringStream();
-    appendCommand(Grbl::Command::G4_Dwell);
-    appendValue('P', durationSeconds);
-    return sendWaitingForOkResponse(RESPONSE_TIMEOUT);
+    return m_queuedLines.size();
 }
 
-bool GrblInterface::setCoordinateSystemOrigin(Grbl::CoordinateOffset coordinateOffset,
-                                              Grbl::CoordinateSystem coordinateSystem,
-                                              const std::vector<PositionPair> &position)
+#if !defined(GRBL_INTERFACE_NO_READER_TASK)
+bool GrblInterface::startReaderTask(int core)
 {
-    resetStringStream();
+    m_received.length = 0;
+    m_received.truncated = false;
+    return m_reader.start(*m_stream, core);
+}
 
-    switch (coordinateOffset)
-    {
-    case Grbl::CoordinateOffset::Absolute:
-    {
-        appendCommand(Grbl::Command::G10_L2_SetWorkCoordinateOffsets);
-        break;
-    }
-    case Grbl::CoordinateOffset::Relative:
+void GrblInterface::stopReaderTask()
+{
+    m_reader.stop();
+}
+
+bool GrblInterface::readerTaskRunning()
+{
+    return m_reader.running();
+}
+
+Grbl::SerialReaderStatistics GrblInterface::getReaderStatistics()
+{
+    return m_reader.statistics();
+}
+#endif
+
+bool GrblInterface::waitForStreamToDrain(uint32_t timeout)
+{
+    const auto startedAt = Grbl::Platform::millis();
+
+    while (!m_queuedLines.empty() || !m_linesInFlight.empty())
     {
-        appendCommand(Grbl::Command::G10_L20_SetWorkCoordinateOffsets);
-        break;
-    }
+        if (Grbl::Platform::millis() - startedAt >= timeout)
+        {
+            return false;
+        }
+
+        updateWhileBlocking();
     }
 
-    appendValue(COORDINATE_SYSTEM_INDICATOR, (static_cast<int>(coordinateSystem) + 1));
-    serializePosition(position);
-    return sendWaitingForOkResponse(RESPONSE_TIMEOUT);
+    return true;
 }
 
-bool GrblInterface::setPlane(Grbl::Plane plane)
+size_t GrblInterface::linesInFlight()
 {
-    switch (plane)
-    {
-    case Grbl::Plane::XY:
+    return m_linesInFlight.size();
+}
+
+size_t GrblInterface::bytesInFlight()
+{
+    return m_bytesInFlight;
+}
+
+StreamingStatistics GrblInterface::getStreamingStatistics()
+{
+    auto statistics = m_streamingStatistics;
+    statistics.linesInFlight = m_linesInFlight.size();
+    statistics.bytesInFlight = m_bytesInFlight;
+
+    const auto elapsed = Grbl::Platform::millis() - m_streamingStartedAt;
+
+    if (elapsed > 0)
     {
-        return sendCommand(Grbl::Command::G17_PlaneSelectionXY);
+        statistics.linesPerSecond = statistics.linesAcknowledged * 1000.0f / elapsed;
     }
-    case Grbl::Plane::ZX:
+
+    return statistics;
+}
+
+void GrblInterface::resetStreamingStatistics()
+{
+    m_streamingStatistics = {};
+    m_streamingStartedAt = Grbl::Platform::millis();
+}
+
+#if !defined(GRBL_INTERFACE_NO_STATS)
+GrblInterface::Stats GrblInterface::getStats()
+{
+    auto stats = m_stats;
+    stats.elapsedMs = Grbl::Platform::millis() - m_statsStartedAt;
+
+    if (stats.elapsedMs > 0)
     {
-        return sendCommand(Grbl::Command::G18_PlaneSelectionZX);
+        stats.txBytesPerSecond = stats.bytesSent * 1000.0f / stats.elapsedMs;
+        stats.rxBytesPerSecond = stats.bytesReceived * 1000.0f / stats.elapsedMs;
+        stats.linesReceivedPerSecond = stats.linesReceived * 1000.0f / stats.elapsedMs;
     }
-    case Grbl::Plane::YZ:
+
+    if (stats.statusReports > 0)
     {
-        return sendCommand(Grbl::Command::G19_PlaneSelectionYZ);
+        stats.statusReportAgeMs = (Grbl::Platform::micros() - m_lastStatusReportAt) / 1000;
     }
+
+    return stats;
+}
+
+void GrblInterface::resetStats()
+{
+    m_stats = {};
+    m_statsStartedAt = Grbl::Platform::millis();
+    m_lastStatusReportInterval = 0;
+}
+#endif
+
+void GrblInterface::setCompactEmission(bool enabled, float tolerance)
+{
+    m_compactEmission = enabled;
+    m_compactTolerance = tolerance;
+}
+
+bool GrblInterface::compactEmissionEnabled()
+{
+    return m_compactEmission;
+}
+
+void GrblInterface::setModalStateTracking(bool enabled)
+{
+    m_modalStateTracking = enabled;
+    m_modalState.invalidate();
+}
+
+bool GrblInterface::modalStateTrackingEnabled()
+{
+    return m_modalStateTracking;
+}
+
+bool GrblInterface::requestParserState()
+{
+    // The "[GC:...]" answer arrives before the "ok", while the command is still being waited for.
+    m_parserStateTicket = m_lastTicket + 1;
+    return sendCommand(Grbl::Command::ViewGcodeParserState);
+}
+
+const Grbl::ModalState &GrblInterface::modalState()
+{
+    return m_modalState;
+}
+
+Grbl::PathHandle GrblInterface::sendPath(const PathSegment *segments, size_t count, float feedRate, bool stopOnError)
+{
+    return startPath(segments, nullptr, count, feedRate, stopOnError);
+}
+
+Grbl::PathHandle GrblInterface::sendPolyline(const Point *points, size_t count, float feedRate, bool stopOnError)
+{
+    return startPath(nullptr, points, count, feedRate, stopOnError);
+}
+
+void GrblInterface::cancelPath(Grbl::PathHandle path)
+{
+    if (path != m_pathHandle || m_pathProgress.state != Grbl::PathState::Running)
+    {
+        return;
+    }
+
+    // Segments Grbl already has are left to run; only a reset takes them back. Those still queued here are
+    // withdrawn.
+    m_pathStopped = true;
+    m_pathCancelled = true;
+
+    for (size_t i = 0; i < m_queuedLines.size(); i++)
+    {
+        for (size_t j = 0; j < m_pendingSegments.size(); j++)
+        {
+            if (m_queuedLines[i].ticket == m_pendingSegments[j].ticket)
+            {
+                m_queuedLines[i].withdrawnAs = Grbl::CommandStatus::Cancelled;
+                break;
+            }
+        }
+    }
+
+    dispatchQueuedLines();
+    finishPath();
+}
+
+PathProgress GrblInterface::getPathProgress(Grbl::PathHandle path)
+{
+    if (path == Grbl::INVALID_PATH || path != m_pathHandle)
+    {
+        PathProgress unknown = {};
+        unknown.state = Grbl::PathState::Unknown;
+        return unknown;
+    }
+
+    return m_pathProgress;
+}
+
+bool GrblInterface::waitForPath(Grbl::PathHandle path, uint32_t timeout)
+{
+    const auto startedAt = Grbl::Platform::millis();
+
+    while (getPathProgress(path).state == Grbl::PathState::Running)
+    {
+        if (Grbl::Platform::millis() - startedAt >= timeout)
+        {
+            return false;
+        }
+
+        updateWhileBlocking();
+    }
+
+    return getPathProgress(path).state == Grbl::PathState::Completed;
+}
+
+// G-codes
+bool GrblInterface::setUnitOfMeasurement(const Grbl::UnitOfMeasurement unitOfMeasurement)
+{
+    switch (unitOfMeasurement)
+    {
+    case Grbl::UnitOfMeasurement::Inches:
+    {
+        return sendModalCommand(Grbl::Command::G20_UnitsInches);
+    }
+    case Grbl::UnitOfMeasurement::Millimeters:
+    {
+        return sendModalCommand(Grbl::Command::G21_UnitsMillimeters);
+    }
+    }
+
+    return false;
+}
+
+bool GrblInterface::setDistanceMode(Grbl::DistanceMode distanceMode)
+{
+    switch (distanceMode)
+    {
+    case Grbl::DistanceMode::Absolute:
+    {
+        return sendModalCommand(Grbl::Command::G90_DistanceModeAbsolute);
+    }
+    case Grbl::DistanceMode::Incremental:
+    {
+        return sendModalCommand(Grbl::Command::G91_DistanceModeIncremental);
+    }
+    }
+
+    return false;
+}
+
+bool GrblInterface::setCoordinateOffset(const PositionList &position)
+{
+    resetLine();
+    appendCommand(Grbl::Command::G92_CoordinateOffset);
+
+    if (!serializePosition(position))
+    {
+        return false;
+    }
+
+    return sendWaitingForOkResponse(RESPONSE_TIMEOUT);
+}
+
+bool GrblInterface::clearCoordinateOffset()
+{
+    return sendCommand(Grbl::Command::G92_1_ClearCoordinateSystemOffsets);
+}
+
+bool GrblInterface::linearRapidPositioning(const PositionList &position)
+{
+    resetLine();
+    appendModalCommand(Grbl::Command::G0_RapidPositioning);
+
+    if (!serializePosition(position))
+    {
+        return false;
+    }
+
+    return sendWaitingForOkResponse(RESPONSE_TIMEOUT);
+}
+
+bool GrblInterface::linearInterpolationPositioning(float feedRate, const PositionList &position)
+{
+    resetLine();
+    appendModalCommand(Grbl::Command::G1_LinearInterpolation);
+    appendFeedRate(feedRate);
+
+    if (!serializePosition(position))
+    {
+        return false;
+    }
+
+    return sendWaitingForOkResponse(RESPONSE_TIMEOUT);
+}
+
+bool GrblInterface::linearPositioningInMachineCoordinate(const PositionList &position)
+{
+    resetLine();
+    appendCommand(Grbl::Command::G53_MoveInAbsoluteCoordinates);
+
+    if (!serializePosition(position))
+    {
+        return false;
+    }
+
+    return sendWaitingForOkResponse(RESPONSE_TIMEOUT);
+}
+
+#if !defined(GRBL_INTERFACE_NO_ARCS)
+bool GrblInterface::arcInterpolationPositioning(Grbl::ArcMovement direction,
+                                                const PositionList &endPosition,
+                                                float radius,
+                                                float feedRate)
+{
+    resetLine();
+    switch (direction)
+    {
+    case Grbl::ArcMovement::Clockwise:
+    {
+        appendModalCommand(Grbl::Command::G2_ClockwiseCircularInterpolation);
+        break;
+    }
+    case Grbl::ArcMovement::CounterClockwise:
+    {
+        appendModalCommand(Grbl::Command::G3_CounterclockwiseCircularInterpolation);
+        break;
+    }
+    }
+
+    if (!serializePosition(endPosition))
+    {
+        return false;
+    }
+
+    appendValue(RADIUS_INDICATOR, radius);
+    appendFeedRate(feedRate);
+    return sendWaitingForOkResponse(RESPONSE_TIMEOUT);
+}
+
+bool GrblInterface::arcInterpolationPositioning(Grbl::ArcMovement direction,
+                                                const PositionList &endPosition,
+                                                Point centerPoint,
+                                                float feedRate)
+{
+    resetLine();
+    switch (direction)
+    {
+    case Grbl::ArcMovement::Clockwise:
+    {
+        appendModalCommand(Grbl::Command::G2_ClockwiseCircularInterpolation);
+        break;
+    }
+    case Grbl::ArcMovement::CounterClockwise:
+    {
+        appendModalCommand(Grbl::Command::G3_CounterclockwiseCircularInterpolation);
+        break;
+    }
+    }
+
+    if (!serializePosition(endPosition))
+    {
+        return false;
+    }
+
+    appendValue('I', centerPoint.first);
+    appendValue('J', centerPoint.second);
+    appendFeedRate(feedRate);
+    return sendWaitingForOkResponse(RESPONSE_TIMEOUT);
+}
+#endif
+
+bool GrblInterface::dwell(uint16_t durationSeconds)
+{
+    resetLine();
+    appendCommand(Grbl::Command::G4_Dwell);
+    appendValue('P', durationSeconds);
+    return sendWaitingForOkResponse(RESPONSE_TIMEOUT);
+}
+
+bool GrblInterface::setCoordinateSystemOrigin(Grbl::CoordinateOffset coordinateOffset,
+                                              Grbl::CoordinateSystem coordinateSystem,
+                                              const PositionList &position)
+{
+    resetLine();
+
+    switch (coordinateOffset)
+    {
+    case Grbl::CoordinateOffset::Absolute:
+    {
+        appendCommand(Grbl::Command::G10_L2_SetWorkCoordinateOffsets);
+        break;
+    }
+    case Grbl::CoordinateOffset::Relative:
+    {
+        appendCommand(Grbl::Command::G10_L20_SetWorkCoordinateOffsets);
+        break;
+    }
+    }
+
+    appendValue(COORDINATE_SYSTEM_INDICATOR, (static_cast<int>(coordinateSystem) + 1));
+
+    if (!serializePosition(position))
+    {
+        return false;
+    }
+
+    return sendWaitingForOkResponse(RESPONSE_TIMEOUT);
+}
+
+bool GrblInterface::setPlane(Grbl::Plane plane)
+{
+    switch (plane)
+    {
+    case Grbl::Plane::XY:
+    {
+        return sendModalCommand(Grbl::Command::G17_PlaneSelectionXY);
+    }
+    case Grbl::Plane::ZX:
+    {
+        return sendModalCommand(Grbl::Command::G18_PlaneSelectionZX);
+    }
+    case Grbl::Plane::YZ:
+    {
+        return sendModalCommand(Grbl::Command::G19_PlaneSelectionYZ);
+    }
+    }
+
+    return false;
+}
+
+// M-codes
+bool GrblInterface::spindleOn(RotationDirection direction)
+{
+    switch (direction)
+    {
+    case RotationDirection::Clockwise:
+    {
+        return sendModalCommand(Grbl::Command::M3_SpindleControlCW);
+    }
+    case RotationDirection::CounterClockwise:
+    {
+        return sendModalCommand(Grbl::Command::M4_SpindleControlCCW);
+    }
+    }
+
+    return false;
+}
+
+bool GrblInterface::spindleOff()
+{
+    return sendModalCommand(Grbl::Command::M5_SpindleStop);
+}
+
+// $ commands
+bool GrblInterface::reboot()
+{
+    return sendCommand(Grbl::Command::RebootProcessor);
+}
+
+bool GrblInterface::softReset()
+{
+    sendRealtimeCommand(Grbl::RealtimeCommand::SoftReset);
+
+    // Grbl discards everything it had buffered. Lines must not be streamed again until its welcome
+    // message confirms the reset has completed, or they would be dropped as well.
+    cancelLinesInFlight();
+
+    QueuedLine queued;
+
+    while (m_queuedLines.pop(queued))
+    {
+        completeCommand(queued.ticket, Grbl::CommandStatus::Cancelled, Grbl::Error::None);
+    }
+
+    m_resetPending = true;
+    return true;
+}
+
+bool GrblInterface::pause()
+{
+    sendRealtimeCommand(Grbl::RealtimeCommand::FeedHold);
+    return true;
+}
+
+bool GrblInterface::resume()
+{
+    sendRealtimeCommand(Grbl::RealtimeCommand::CycleStart);
+    return true;
+}
+
+bool GrblInterface::runHomingCycle()
+{
+    return sendCommand(Grbl::Command::RunHomingCycle, false);
+}
+
+bool GrblInterface::runHomingCycle(const Grbl::Axis axis)
+{
+    if (Grbl::axisIndex(axis) < 0)
+    {
+        return false;
+    }
+
+    resetLine();
+    m_line.append(Grbl::getCommand(Grbl::Command::RunHomingCycle));
+    m_line.append(getAxis(axis));
+    return submitLine(RESPONSE_TIMEOUT, false);
+}
+
+bool GrblInterface::clearAlarm()
+{
+    return sendCommand(Grbl::Command::ClearAlarmLock);
+}
+
+#if !defined(GRBL_INTERFACE_NO_JOGGING)
+bool GrblInterface::jog(float feedRate, const PositionList &position)
+{
+    resetLine();
+    appendCommand(Grbl::Command::RunJoggingMotion);
+    appendValue(FEED_RATE_INDICATOR, feedRate);
+
+    if (!serializePosition(position))
+    {
+        return false;
+    }
+
+    return sendWaitingForOkResponse(RESPONSE_TIMEOUT);
+}
+#endif
+
+void GrblInterface::sendRealtimeCommand(const Grbl::RealtimeCommand command)
+{
+    // Realtime commands are single bytes picked off the stream by Grbl; they take no RX buffer space.
+    m_stream->write(static_cast<uint8_t>(command));
+#if !defined(GRBL_INTERFACE_NO_STATS)
+    m_stats.bytesSent++;
+#endif
+}
+
+#if !defined(GRBL_INTERFACE_NO_JOGGING)
+void GrblInterface::cancelJog()
+{
+    sendRealtimeCommand(Grbl::RealtimeCommand::JogCancel);
+
+    const auto *jogCommand = Grbl::getCommand(Grbl::Command::RunJoggingMotion);
+
+    for (size_t i = 0; i < m_queuedLines.size(); i++)
+    {
+        if (strncmp(m_queuedLines[i].line.c_str(), jogCommand, strlen(jogCommand)) == 0)
+        {
+            m_queuedLines[i].withdrawnAs = Grbl::CommandStatus::Cancelled;
+        }
+    }
+
+    // Jog motion already sent stops short of its targets.
+    m_positionEstimator.forgetMoves();
+
+    dispatchQueuedLines();
+}
+#endif
+
+void GrblInterface::openSafetyDoor()
+{
+    sendRealtimeCommand(Grbl::RealtimeCommand::SafetyDoor);
+}
+
+void GrblInterface::adjustFeedOverride(const Grbl::OverrideAdjustment adjustment)
+{
+    switch (adjustment)
+    {
+    case Grbl::OverrideAdjustment::Reset:
+    {
+        return sendRealtimeCommand(Grbl::RealtimeCommand::FeedOverrideReset);
+    }
+    case Grbl::OverrideAdjustment::CoarseIncrease:
+    {
+        return sendRealtimeCommand(Grbl::RealtimeCommand::FeedOverrideCoarseIncrease);
+    }
+    case Grbl::OverrideAdjustment::CoarseDecrease:
+    {
+        return sendRealtimeCommand(Grbl::RealtimeCommand::FeedOverrideCoarseDecrease);
+    }
+    case Grbl::OverrideAdjustment::FineIncrease:
+    {
+        return sendRealtimeCommand(Grbl::RealtimeCommand::FeedOverrideFineIncrease);
+    }
+    case Grbl::OverrideAdjustment::FineDecrease:
+    {
+        return sendRealtimeCommand(Grbl::RealtimeCommand::FeedOverrideFineDecrease);
+    }
+    }
+}
+
+void GrblInterface::adjustSpindleOverride(const Grbl::OverrideAdjustment adjustment)
+{
+    switch (adjustment)
+    {
+    case Grbl::OverrideAdjustment::Reset:
+    {
+        return sendRealtimeCommand(Grbl::RealtimeCommand::SpindleOverrideReset);
+    }
+    case Grbl::OverrideAdjustment::CoarseIncrease:
+    {
+        return sendRealtimeCommand(Grbl::RealtimeCommand::SpindleOverrideCoarseIncrease);
+    }
+    case Grbl::OverrideAdjustment::CoarseDecrease:
+    {
+        return sendRealtimeCommand(Grbl::RealtimeCommand::SpindleOverrideCoarseDecrease);
+    }
+    case Grbl::OverrideAdjustment::FineIncrease:
+    {
+        return sendRealtimeCommand(Grbl::RealtimeCommand::SpindleOverrideFineIncrease);
+    }
+    case Grbl::OverrideAdjustment::FineDecrease:
+    {
+        return sendRealtimeCommand(Grbl::RealtimeCommand::SpindleOverrideFineDecrease);
+    }
+    }
+}
+
+void GrblInterface::setRapidOverride(const Grbl::RapidOverride rapidOverride)
+{
+    switch (rapidOverride)
+    {
+    case Grbl::RapidOverride::Full:
+    {
+        return sendRealtimeCommand(Grbl::RealtimeCommand::RapidOverrideReset);
+    }
+    case Grbl::RapidOverride::Medium:
+    {
+        return sendRealtimeCommand(Grbl::RealtimeCommand::RapidOverrideMedium);
+    }
+    case Grbl::RapidOverride::Low:
+    {
+        return sendRealtimeCommand(Grbl::RealtimeCommand::RapidOverrideLow);
+    }
+    }
+}
+
+void GrblInterface::toggleSpindleStop()
+{
+    sendRealtimeCommand(Grbl::RealtimeCommand::ToggleSpindleStop);
+}
+
+void GrblInterface::toggleFloodCoolant()
+{
+    sendRealtimeCommand(Grbl::RealtimeCommand::ToggleFloodCoolant);
+}
+
+void GrblInterface::toggleMistCoolant()
+{
+    sendRealtimeCommand(Grbl::RealtimeCommand::ToggleMistCoolant);
+}
+
+float GrblInterface::getCurrentFeedRate()
+{
+    return m_currentFeedRate;
+}
+
+float GrblInterface::getCurrentSpindleSpeed()
+{
+    return m_currentSpindleSpeed;
+}
+
+uint8_t GrblInterface::currentSubState()
+{
+    return m_subState;
+}
+
+int16_t GrblInterface::plannerBlocksAvailable()
+{
+    return m_plannerBlocksAvailable;
+}
+
+int16_t GrblInterface::rxBytesAvailable()
+{
+    return m_rxBytesAvailable;
+}
+
+uint32_t GrblInterface::currentLineNumber()
+{
+    return m_lineNumber;
+}
+
+uint8_t GrblInterface::feedOverride()
+{
+    return m_feedOverride;
+}
+
+uint8_t GrblInterface::rapidOverride()
+{
+    return m_rapidOverride;
+}
+
+uint8_t GrblInterface::spindleOverride()
+{
+    return m_spindleOverride;
+}
+
+uint8_t GrblInterface::accessoryMask()
+{
+    return m_accessories;
+}
+
+uint8_t GrblInterface::controlPinMask()
+{
+    return m_controlPins;
+}
+
+StatusSnapshot GrblInterface::getStatusSnapshot() const
+{
+    return m_statusSnapshot.read();
+}
+
+const Coordinate &GrblInterface::getWorkCoordinate()
+{
+    return m_workCoordinate;
+}
+
+float GrblInterface::getWorkCoordinate(const Grbl::Axis axis)
+{
+    const auto index = Grbl::axisIndex(axis);
+    return index < 0 ? 0 : m_workCoordinate[index];
+}
+
+const Coordinate &GrblInterface::getMachineCoordinate()
+{
+    return m_machineCoordinate;
+}
+
+float GrblInterface::getMachineCoordinate(const Grbl::Axis axis)
+{
+    const auto index = Grbl::axisIndex(axis);
+    return index < 0 ? 0 : m_machineCoordinate[index];
+}
+
+#if !defined(GRBL_INTERFACE_NO_WORK_COORDINATE_OFFSET)
+const Coordinate &GrblInterface::getWorkCoordinateOffset()
+{
+    return m_workCoordinateOffset;
+}
+
+float GrblInterface::getWorkCoordinateOffset(const Grbl::Axis axis)
+{
+    const auto index = Grbl::axisIndex(axis);
+    return index < 0 ? 0 : m_workCoordinateOffset[index];
+}
+#endif
+
+void GrblInterface::setEstimatorAcceleration(float maxAcceleration)
+{
+    m_positionEstimator.setMaxAcceleration(maxAcceleration);
+}
+
+Grbl::PositionEstimate GrblInterface::estimatedPosition(uint32_t now)
+{
+    auto estimate = m_positionEstimator.estimate(now);
+    const auto &reported = m_positionEstimator.reportedPosition();
+
+    // The estimator follows the position Grbl reports, the other one moves along with it.
+    for (auto i = 0; i < Grbl::MAX_NUMBER_OF_AXES; i++)
+    {
+        const auto displacement = estimate.machinePosition[i] - reported[i];
+        estimate.machinePosition[i] = m_machineCoordinate[i] + displacement;
+        estimate.workPosition[i] = m_workCoordinate[i] + displacement;
+    }
+
+    return estimate;
+}
+
+bool GrblInterface::machineIsAt(const PositionList &position)
+{
+    return std::all_of(position.begin(), position.end(), [this](const PositionPair &pos)
+                       { return Utils::equals(pos.second, getMachineCoordinate(pos.first)); });
+}
+
+Grbl::MachineState GrblInterface::currentMachineState()
+{
+    update();
+    return m_machineState;
+}
+
+const char *GrblInterface::getMachineState(Grbl::MachineState machineState)
+{
+    if (machineState == Grbl::MachineState::Unknown)
+    {
+        return "N/A";
+    }
+
+    return Grbl::machineStates[static_cast<int>(machineState)];
+}
+
+Grbl::MachineState GrblInterface::getMachineState(const char *state)
+{
+    return findMachineState(state, strlen(state));
+}
+
+char GrblInterface::getAxis(Grbl::Axis axis)
+{
+    const auto index = Grbl::axisIndex(axis);
+    return index < 0 ? '\0' : Grbl::axes[index];
+}
+
+Grbl::Axis GrblInterface::getAxis(char axis)
+{
+    const auto index = Grbl::axisIndex(axis);
+    return index < 0 ? Grbl::Axis::Unknown : static_cast<Grbl::Axis>(index);
+}
+
+const char *GrblInterface::getCoordinateMode(Grbl::CoordinateMode coordinateMode)
+{
+    if (coordinateMode == Grbl::CoordinateMode::Unknown)
+    {
+        return "N/A";
+    }
+
+    return Grbl::coordinateModes[static_cast<int>(coordinateMode)];
+}
+
+Grbl::CoordinateMode GrblInterface::getCoordinateMode(const char *coordinateMode)
+{
+    for (size_t i = 0; i < Grbl::coordinateModes.size(); i++)
+    {
+        if (strcmp(coordinateMode, Grbl::coordinateModes[i]) == 0)
+        {
+            return static_cast<Grbl::CoordinateMode>(i);
+        }
+    }
+
+    return Grbl::CoordinateMode::Unknown;
+}
+
+Grbl::Alarm GrblInterface::currentAlarm()
+{
+    return m_currentAlarm;
+}
+
+Grbl::Error GrblInterface::currentError()
+{
+    return m_currentError;
+}
+
+Grbl::SubscriptionHandle GrblInterface::subscribe(uint16_t changeMask, StatusListener listener)
+{
+    if (changeMask == 0 || !listener)
+    {
+        return Grbl::INVALID_SUBSCRIPTION;
+    }
+
+    for (size_t i = 0; i < m_subscriptions.size(); i++)
+    {
+        if (m_subscriptions[i].changeMask == 0)
+        {
+            m_subscriptions[i].changeMask = changeMask;
+            m_subscriptions[i].listener = std::move(listener);
+            return static_cast<Grbl::SubscriptionHandle>(i + 1);
+        }
+    }
+
+    return Grbl::INVALID_SUBSCRIPTION;
+}
+
+void GrblInterface::unsubscribe(Grbl::SubscriptionHandle handle)
+{
+    if (handle == Grbl::INVALID_SUBSCRIPTION || handle > m_subscriptions.size())
+    {
+        return;
+    }
+
+    // The listener is kept until the slot is reused, as it may be the one running.
+    m_subscriptions[handle - 1].changeMask = 0;
+}
+
+void GrblInterface::setPositionChangeThreshold(float threshold)
+{
+    m_positionChangeThreshold = threshold;
+}
+
+// --------------------------------------------------------------------------------------------------
+// Private methods
+// --------------------------------------------------------------------------------------------------
+
+void GrblInterface::pollStatusReport()
+{
+    if (!m_automaticStatusReports || statusReportPending())
+    {
+        return;
+    }
+
+    if (Grbl::Platform::millis() - m_statusReportRequestedAt >= statusReportInterval())
+    {
+        (void)getStatusReport();
+    }
+}
+
+void GrblInterface::updateWhileBlocking()
+{
+    // While automatic reports are off, whoever schedules the requests is held up by the blocking call. Once
+    // a report is overdue, request one here, or a busy controller would look like a lost one.
+    if (!m_automaticStatusReports && !statusReportPending() &&
+        Grbl::Platform::millis() - m_statusReportRequestedAt >=
+            statusReportInterval() + STATUS_REPORT_RESPONSE_TIMEOUT_MS)
+    {
+        (void)getStatusReport();
+    }
+
+    update();
+}
+
+void GrblInterface::processLine(const char *line, size_t length)
+{
+    GRBL_LOG(line);
+    auto cursor = line;
+    m_lastLineReceivedAt = Grbl::Platform::millis();
+#if !defined(GRBL_INTERFACE_NO_STATS)
+    const auto parseStartedAt = Grbl::Platform::micros();
+    m_stats.linesReceived++;
+#endif
+
+    // Lines are split on '\r', so the '\n' of Grbl's "\r\n" terminator leads the next line.
+    while (*cursor == '\n' || *cursor == ' ')
+    {
+        cursor++;
+    }
+
+    switch (*cursor)
+    {
+    case Response::STATUS_REPORT_START:
+    {
+        processStatusReport(cursor + 1, std::string_view(cursor, line + length - cursor));
+        break;
+    }
+    case 'o':
+    {
+        if (Grbl::Parser::consume(cursor, Response::OK))
+        {
+            acknowledgeLine(Grbl::Error::None);
+        }
+
+        break;
+    }
+    case 'e':
+    {
+        uint32_t errorCode;
+
+        if (Grbl::Parser::consume(cursor, Response::ERROR_CODE) && Grbl::Parser::parseUnsigned(cursor, errorCode))
+        {
+            m_currentError = static_cast<Grbl::Error>(errorCode);
+            acknowledgeLine(m_currentError);
+            const auto previous = m_statusSnapshot.read();
+            notifyStatusChanges(publishStatusSnapshot(previous.coordinateMode, previous.receivedAt),
+                                static_cast<uint16_t>(Grbl::StatusChange::Error));
+        }
+
+        break;
+    }
+    case 'A':
+    {
+        uint32_t alarmCode;
+
+        if (Grbl::Parser::consume(cursor, Response::ALARM_CODE) && Grbl::Parser::parseUnsigned(cursor, alarmCode))
+        {
+            m_currentAlarm = static_cast<Grbl::Alarm>(alarmCode);
+#if !defined(GRBL_INTERFACE_NO_STATS)
+            m_stats.alarms++;
+#endif
+            const auto previous = m_statusSnapshot.read();
+            notifyStatusChanges(publishStatusSnapshot(previous.coordinateMode, previous.receivedAt),
+                                static_cast<uint16_t>(Grbl::StatusChange::Alarm));
+        }
+
+        break;
+    }
+    case 'G':
+    {
+        // The welcome message follows a reset, which discards everything Grbl had buffered.
+        if (Grbl::Parser::consume(cursor, Response::WELCOME_MESSAGE))
+        {
+            cancelLinesInFlight();
+            m_resetPending = false;
+            m_modalState.invalidate();
+            m_positionEstimator.reset();
+        }
+
+        break;
+    }
+    case '[':
+    {
+        // Only taken over while nothing sent after the $G could have changed the state in between.
+        if (Grbl::Parser::consume(cursor, Response::PARSER_STATE) &&
+            m_modalStateTracking &&
+            m_parserStateTicket == m_lastTicket &&
+            m_parserStateTicket > m_lastCompletedTicket)
+        {
+            m_modalState.applyParserState(cursor);
+        }
+
+        break; // Other feedback messages such as [MSG:...] are not consumed yet.
+    }
+    case '$': // Settings listing.
+    default:
+    {
+        break;
+    }
+    }
+
+#if !defined(GRBL_INTERFACE_NO_STATS)
+    m_stats.parseTime.add(Grbl::Platform::micros() - parseStartedAt);
+#endif
+}
+
+#if !defined(GRBL_INTERFACE_NO_READER_TASK)
+void GrblInterface::processReceivedLines()
+{
+    for (auto line = m_reader.front(); line != nullptr; line = m_reader.front())
+    {
+#if !defined(GRBL_INTERFACE_NO_STATS)
+        m_stats.bytesReceived += line->length + 1;
+        m_stats.linesDropped += line->truncated;
+#endif
+
+        // A truncated status report or message would be misread, so it is dropped altogether.
+        if (!line->truncated)
+        {
+            processLine(line->text, line->length);
+        }
+
+        m_reader.pop();
+        dispatchQueuedLines();
+    }
+}
+#endif
+
+void GrblInterface::processStatusReport(const char *cursor, std::string_view report)
+{
+    const auto requestedAt = m_statusReportPending ? m_statusReportRequestedAtMicros : Grbl::Platform::micros();
+    m_statusReportPending = false;
+#if !defined(GRBL_INTERFACE_NO_STATS)
+    recordStatusReport();
+#endif
+
+    if (statusReportReceived)
+    {
+        statusReportReceived(report);
+    }
+
+    const auto stateName = cursor;
+
+    while (*cursor != '\0' &&
+           *cursor != Response::SUB_STATE_SEPARATOR &&
+           *cursor != Response::FIELD_SEPARATOR &&
+           *cursor != Response::STATUS_REPORT_END)
+    {
+        cursor++;
+    }
+
+    const auto machineState = findMachineState(stateName, cursor - stateName);
+    auto coordinateMode = Grbl::CoordinateMode::Unknown;
+    uint32_t subState = 0;
+
+    if (*cursor == Response::SUB_STATE_SEPARATOR)
+    {
+        cursor++;
+        (void)Grbl::Parser::parseUnsigned(cursor, subState);
+    }
+
+    Grbl::Parser::skipField(cursor);
+    m_subState = static_cast<uint8_t>(subState);
+
+    // Fields missing from a report are not active, except for the overrides and accessories, which
+    // Grbl only repeats every few reports.
+    m_limitSwitches = 0;
+    m_controlPins = 0;
+    m_plannerBlocksAvailable = -1;
+    m_rxBytesAvailable = -1;
+    m_lineNumber = 0;
+    auto overridesReported = false;
+    auto accessoriesReported = false;
+
+    while (*cursor == Response::FIELD_SEPARATOR)
+    {
+        cursor++;
+
+        switch (*cursor)
+        {
+        case 'M':
+        {
+            if (Grbl::Parser::consume(cursor, Response::MACHINE_POSITION))
+            {
+                coordinateMode = Grbl::CoordinateMode::Machine;
+                extractPosition(cursor, m_machineCoordinate);
+            }
+
+            break;
+        }
+        case 'W':
+        {
+            if (Grbl::Parser::consume(cursor, Response::WORK_POSITION))
+            {
+                coordinateMode = Grbl::CoordinateMode::Work;
+                extractPosition(cursor, m_workCoordinate);
+            }
+#if !defined(GRBL_INTERFACE_NO_WORK_COORDINATE_OFFSET)
+            else if (Grbl::Parser::consume(cursor, Response::WORK_COORDINATE_OFFSET))
+            {
+                extractPosition(cursor, m_workCoordinateOffset);
+            }
+#endif
+
+            break;
+        }
+        case 'F':
+        {
+            if (Grbl::Parser::consume(cursor, Response::FEED_AND_SPEED) &&
+                Grbl::Parser::parseFloat(cursor, m_currentFeedRate) &&
+                *cursor == Response::VALUE_SEPARATOR)
+            {
+                cursor++;
+                (void)Grbl::Parser::parseFloat(cursor, m_currentSpindleSpeed);
+            }
+            else if (Grbl::Parser::consume(cursor, Response::FEED))
+            {
+                (void)Grbl::Parser::parseFloat(cursor, m_currentFeedRate);
+            }
+
+            break;
+        }
+        case 'P':
+        {
+            if (Grbl::Parser::consume(cursor, Response::PINS))
+            {
+                for (; *cursor >= 'A' && *cursor <= 'Z'; cursor++)
+                {
+                    m_controlPins |= findControlPin(*cursor);
+                    const auto index = Grbl::axisIndex(*cursor);
+
+                    if (index >= 0)
+                    {
+                        m_limitSwitches |= 1 << index;
+                    }
+                }
+            }
+
+            break;
+        }
+        case 'B':
+        {
+            uint32_t plannerBlocks;
+            uint32_t rxBytes;
+
+            if (Grbl::Parser::consume(cursor, Response::BUFFER_STATE) &&
+                Grbl::Parser::parseUnsigned(cursor, plannerBlocks) &&
+                Grbl::Parser::consume(cursor, ",") &&
+                Grbl::Parser::parseUnsigned(cursor, rxBytes))
+            {
+                m_plannerBlocksAvailable = static_cast<int16_t>(plannerBlocks);
+                m_rxBytesAvailable = static_cast<int16_t>(rxBytes);
+            }
+
+            break;
+        }
+        case 'L':
+        {
+            if (Grbl::Parser::consume(cursor, Response::LINE_NUMBER))
+            {
+                (void)Grbl::Parser::parseUnsigned(cursor, m_lineNumber);
+            }
+
+            break;
+        }
+        case 'O':
+        {
+            uint32_t feed;
+            uint32_t rapid;
+            uint32_t spindle;
+
+            if (Grbl::Parser::consume(cursor, Response::OVERRIDES) &&
+                Grbl::Parser::parseUnsigned(cursor, feed) &&
+                Grbl::Parser::consume(cursor, ",") &&
+                Grbl::Parser::parseUnsigned(cursor, rapid) &&
+                Grbl::Parser::consume(cursor, ",") &&
+                Grbl::Parser::parseUnsigned(cursor, spindle))
+            {
+                m_feedOverride = static_cast<uint8_t>(feed);
+                m_rapidOverride = static_cast<uint8_t>(rapid);
+                m_spindleOverride = static_cast<uint8_t>(spindle);
+                overridesReported = true;
+            }
+
+            break;
+        }
+        case 'A':
+        {
+            if (Grbl::Parser::consume(cursor, Response::ACCESSORIES))
+            {
+                m_accessories = 0;
+                accessoriesReported = true;
+
+                for (; *cursor >= 'A' && *cursor <= 'Z'; cursor++)
+                {
+                    m_accessories |= findAccessory(*cursor);
+                }
+            }
+
+            break;
+        }
+        }
+
+        Grbl::Parser::skipField(cursor);
+    }
+
+    // A: is left out while everything is off.
+    if (overridesReported && !accessoriesReported)
+    {
+        m_accessories = 0;
+    }
+
+    updatePlannerDepth();
+
+    if (machineState == Grbl::MachineState::Unknown)
+    {
+        return;
+    }
+
+    m_machineState = machineState;
+
+    if (coordinateMode == Grbl::CoordinateMode::Unknown)
+    {
+        return;
+    }
+
+    // Grbl reports either MPos or WPos, the other one is derived from the last known WCO.
+#if !defined(GRBL_INTERFACE_NO_WORK_COORDINATE_OFFSET)
+    for (auto i = 0; i < Grbl::MAX_NUMBER_OF_AXES; i++)
+    {
+        if (coordinateMode == Grbl::CoordinateMode::Machine)
+        {
+            m_workCoordinate[i] = toWorkCoordinate(m_machineCoordinate[i], m_workCoordinateOffset[i]);
+        }
+        else
+        {
+            m_machineCoordinate[i] = toMachineCoordinate(m_workCoordinate[i], m_workCoordinateOffset[i]);
+        }
+    }
+#else
+    // Without the WCO the other one mirrors the reported position, as if the offset were zero.
+    if (coordinateMode == Grbl::CoordinateMode::Machine)
+    {
+        m_workCoordinate = m_machineCoordinate;
+    }
+    else
+    {
+        m_machineCoordinate = m_workCoordinate;
+    }
+#endif
+
+    updatePositionEstimate(machineState, coordinateMode, requestedAt);
+    const auto snapshot = publishStatusSnapshot(coordinateMode, m_lastLineReceivedAt);
+
+    if (onPositionUpdate)
+    {
+        onPositionUpdate(machineState, coordinateMode);
+    }
+
+    notifyStatusChanges(snapshot);
+}
+
+void GrblInterface::resetLine()
+{
+    m_line.clear();
+}
+
+void GrblInterface::appendCommand(const Grbl::Command command, char postpend)
+{
+    m_line.append(Grbl::getCommand(command));
+    appendSeparator(postpend);
+}
+
+void GrblInterface::appendValue(char indicator, float value, char postpend)
+{
+    m_line.append(indicator);
+
+    if (m_compactEmission)
+    {
+        m_line.appendShortestFloat(value, m_compactTolerance);
+    }
+    else
+    {
+        m_line.appendFloat(value, Grbl::FLOAT_PRECISION);
+    }
+
+    appendSeparator(postpend);
+}
+
+void GrblInterface::appendValue(char indicator, int value, char postpend)
+{
+    m_line.append(indicator);
+    m_line.appendInteger(value);
+    appendSeparator(postpend);
+}
+
+void GrblInterface::appendSeparator(char separator)
+{
+    // Grbl ignores spaces between words, every word starts with its letter anyway.
+    if (m_compactEmission && separator == ' ')
+    {
+        return;
+    }
+
+    m_line.append(separator);
+}
+
+bool GrblInterface::modalStateAcknowledged()
+{
+    // Words are only left out against modes Grbl has acknowledged. A line that changes them may still be
+    // rejected, and lines built without the words would then run in the old modes.
+    return m_modalStateTracking && m_modalChangeTicket <= m_lastCompletedTicket;
+}
+
+void GrblInterface::appendModalCommand(const Grbl::Command command)
+{
+    if (modalStateAcknowledged() && m_modalState.isActive(command))
+    {
+        return;
+    }
+
+    appendCommand(command);
+}
+
+void GrblInterface::appendFeedRate(float feedRate)
+{
+    if (modalStateAcknowledged() && m_modalState.isFeedRate(feedRate))
+    {
+        return;
+    }
+
+    appendValue(FEED_RATE_INDICATOR, feedRate);
+}
+
+bool GrblInterface::serializePosition(const PositionList &position)
+{
+    if (position.overflowed())
+    {
+        return false;
+    }
+
+    for (const auto &pos : position)
+    {
+        const auto axis = getAxis(pos.first);
+
+        // Leaving the axis out would move the others without it, and Grbl would reject it anyway.
+        if (axis == '\0')
+        {
+            return false;
+        }
+
+        appendValue(axis, pos.second);
+    }
+
+    return true;
+}
+
+bool GrblInterface::sendCommand(const Grbl::Command command, bool waitForResponse)
+{
+    resetLine();
+    m_line.append(Grbl::getCommand(command));
+    return submitLine(RESPONSE_TIMEOUT, waitForResponse);
+}
+
+bool GrblInterface::sendModalCommand(const Grbl::Command command)
+{
+    if (modalStateAcknowledged() && m_modalState.isActive(command))
+    {
+        return true;
+    }
+
+    return sendCommand(command);
+}
+
+bool GrblInterface::sendWaitingForOkResponse(uint16_t timeout)
+{
+    return submitLine(timeout, true);
+}
+
+bool GrblInterface::submitLine(uint16_t timeout, bool waitForResponse)
+{
+    // Every word was left out because Grbl already has it active.
+    if (m_line.length() == 0)
+    {
+        return true;
+    }
+
+    if (!enqueueLine())
+    {
+        return false;
+    }
+
+    if (m_asynchronousMode)
+    {
+        return true;
+    }
+
+    // While streaming, a line is done with as soon as Grbl has room for it. Grbl withholds
+    // acknowledgements while its planner is full, so only give up once the controller has been
+    // completely silent for the whole timeout.
+    const auto ticket = m_lastTicket;
+    const auto waitForOk = waitForResponse && !m_streamingMode;
+    const auto startedAt = Grbl::Platform::millis();
+    // Polled status reports are what tells a busy controller from a lost one, so silence only counts once
+    // the next report is overdue.
+    const auto silenceTimeout =
+        std::max(static_cast<uint32_t>(timeout), statusReportInterval() + STATUS_REPORT_RESPONSE_TIMEOUT_MS);
+
+    while (true)
+    {
+        const auto status = commandStatus(ticket);
+
+        if (status == Grbl::CommandStatus::Ok || (status == Grbl::CommandStatus::Sent && !waitForOk))
+        {
+            return true;
+        }
+
+        if (status != Grbl::CommandStatus::Queued && status != Grbl::CommandStatus::Sent)
+        {
+            return false;
+        }
+
+        const auto now = Grbl::Platform::millis();
+
+        if (now - startedAt >= timeout && now - m_lastLineReceivedAt >= silenceTimeout)
+        {
+            break;
+        }
+
+        updateWhileBlocking();
+    }
+
+    // A line the caller gave up on must not reach Grbl later on.
+    for (size_t i = 0; i < m_queuedLines.size(); i++)
+    {
+        if (m_queuedLines[i].ticket == ticket)
+        {
+            m_queuedLines[i].withdrawnAs = Grbl::CommandStatus::Timeout;
+        }
+    }
+
+    return false;
+}
+
+bool GrblInterface::enqueueLine()
+{
+    // Grbl would reject an overlong line with error:11 after it already used up RX buffer space.
+    if (m_line.overflowed() || m_line.length() + 1 > m_rxBufferSize || m_queuedLines.full())
+    {
+        return false;
+    }
+
+    if (m_modalStateTracking && m_modalState.applyLine(m_line.c_str()))
+    {
+        m_modalChangeTicket = m_lastTicket + 1;
+    }
+
+    (void)m_queuedLines.push({++m_lastTicket, m_line, Grbl::CommandStatus::Queued});
+    dispatchQueuedLines();
+    return true;
+}
+
+void GrblInterface::dispatchQueuedLines()
+{
+    while (!m_resetPending && !m_queuedLines.empty())
+    {
+        const auto &queued = m_queuedLines.front();
+        const auto length = queued.line.length() + 1; // Including the line terminator.
+
+        if (queued.withdrawnAs != Grbl::CommandStatus::Queued)
+        {
+            // Completions are reported in ticket order, so wait for the lines ahead of it.
+            if (!m_linesInFlight.empty())
+            {
+                return;
+            }
+        }
+        else
+        {
+            // Without streaming Grbl gets one line at a time and has to answer it before the next.
+            if (m_linesInFlight.full() ||
+                (!m_streamingMode && !m_linesInFlight.empty()) ||
+                m_bytesInFlight + length > m_rxBufferSize ||
+                plannerDepthReached())
+            {
+                return;
+            }
+
+            m_streamingStatistics.linesSent++;
+            m_streamingStatistics.bytesSent += length;
+            m_bytesInFlight += length;
+            InFlightLine line{};
+            line.ticket = queued.ticket;
+            line.length = static_cast<uint16_t>(length);
+            line.sentAt = Grbl::Platform::millis();
+#if !defined(GRBL_INTERFACE_NO_STATS)
+            line.sentAtMicros = Grbl::Platform::micros();
+#endif
+            (void)m_linesInFlight.push(line);
+            transmit(queued.line);
+        }
+
+        QueuedLine dispatched;
+        (void)m_queuedLines.pop(dispatched);
+
+        if (dispatched.withdrawnAs != Grbl::CommandStatus::Queued)
+        {
+            completeCommand(dispatched.ticket, dispatched.withdrawnAs, Grbl::Error::None);
+        }
     }
 }
 
-// M-codes
-bool GrblInterface::spindleOn(RotationDirection direction)
+bool GrblInterface::plannerDepthReached()
 {
-    switch (direction)
-    {
-    case RotationDirection::Clockwise:
+    // Without Bf: in the status reports there is nothing to go by, and until the machine ran between two
+    // reports the blocks run cannot be told, so only byte counting applies.
+    if (!m_plannerFlowControl || m_plannerCapacity < 0 || m_plannerBlockLength <= 0)
     {
-        return sendCommand(Grbl::Command::M3_SpindleControlCW);
+        return false;
     }
-    case RotationDirection::CounterClockwise:
+
+    // Lines in flight have yet to cross the link and Grbl's RX buffer, so a few are kept on top of a full
+    // planner. Below an explicit target, byte counting alone applies until the planner is refilled, so the
+    // flow control never feeds Grbl slower than that. The automatic target is the whole planner, which runs a
+    // block short whenever one completes, so there the lines on top are a hard cap instead.
+    const auto depth = plannerDepthEstimate();
+    const auto plannerDepth = depth - static_cast<int>(m_linesInFlight.size());
+    const auto refilling = m_plannerTargetDepth != Grbl::PLANNER_TARGET_DEPTH_AUTO &&
+                           plannerDepth < plannerTargetDepth();
+
+    if (refilling || depth < plannerTargetDepth() + m_plannerLinesAhead)
     {
-        return sendCommand(Grbl::Command::M4_SpindleControlCCW);
+        return false;
     }
-    }
-}
 
-bool GrblInterface::spindleOff()
-{
-    return sendCommand(Grbl::Command::M5_SpindleStop);
+    m_plannerHeldBack = true;
+    return true;
 }
 
-// $ commands
-bool GrblInterface::reboot()
+int GrblInterface::plannerTargetDepth()
 {
-    return sendCommand(Grbl::Command::RebootProcessor);
+    return m_plannerTargetDepth == Grbl::PLANNER_TARGET_DEPTH_AUTO ? m_plannerCapacity : m_plannerTargetDepth;
 }
 
-bool GrblInterface::softReset()
+int GrblInterface::plannerLinesAheadLimit()
 {
-    return sendCommand(Grbl::Command::SoftReset);
-}
+    if (m_plannerTargetDepth != Grbl::PLANNER_TARGET_DEPTH_AUTO)
+    {
+        return Grbl::MAX_LINES_IN_FLIGHT;
+    }
 
-bool GrblInterface::pause()
-{
-    return sendCommand(Grbl::Command::Pause);
-}
+    if (m_linesInFlight.empty())
+    {
+        return m_plannerLinesAhead;
+    }
 
-bool GrblInterface::resume()
-{
-    return sendCommand(Grbl::Command::Resume);
+    // Fewer than the lines of this length the RX buffer holds, so the moves queued ahead of the machine stay
+    // below those of character counting.
+    const auto lineLength = m_bytesInFlight / m_linesInFlight.size();
+    return std::max<int>(PLANNER_FLOW_CONTROL_LINES_AHEAD, static_cast<int>(m_rxBufferSize / lineLength) - 1);
 }
 
-bool GrblInterface::runHomingCycle()
+int GrblInterface::plannerBlocksRunSinceReport()
 {
-    return sendCommand(Grbl::Command::RunHomingCycle, false);
-}
+    if (m_plannerBlockLength <= 0)
+    {
+        return 0;
+    }
 
-bool GrblInterface::runHomingCycle(const Grbl::Axis axis)
-{
-    resetStringStream();
-    m_stringStream << Grbl::getCommand(Grbl::Command::RunHomingCycle) << getAxis(axis);
-    send();
-    return true;
+    // Rounded, as the report left Grbl a little before it arrived. No more than were queued.
+    const auto elapsed = static_cast<float>(Grbl::Platform::micros() - m_plannerReportAt);
+    const auto distance = m_currentFeedRate * elapsed / MICROS_PER_MINUTE;
+    const auto blocksRun = static_cast<int>(distance / m_plannerBlockLength + 0.5f);
+    return std::min(blocksRun, m_plannerBlocksQueued + m_linesAcknowledgedSinceReport);
 }
 
-bool GrblInterface::clearAlarm()
+void GrblInterface::updatePlannerDepth()
 {
-    return sendCommand(Grbl::Command::ClearAlarmLock);
-}
+    if (m_plannerBlocksAvailable < 0)
+    {
+        return;
+    }
 
-bool GrblInterface::jog(float feedRate, const std::vector<PositionPair> &position)
-{
-    resetStringStream();
-    appendCommand(Grbl::Command::RunJoggingMotion);
-    appendValue(FEED_RATE_INDICATOR, feedRate);
-    serializePosition(position);
-    return sendWaitingForOkResponse(RESPONSE_TIMEOUT);
-}
+    const auto now = Grbl::Platform::micros();
+    const auto capacity = std::max<int16_t>({m_plannerCapacity, Grbl::PLANNER_BLOCKS, m_plannerBlocksAvailable});
+    const auto blocksQueued = capacity - m_plannerBlocksAvailable;
 
-float GrblInterface::getCurrentFeedRate()
-{
-    return m_currentFeedRate;
-}
+    // The block length is learned from the distance run at the mean of the two feed rates reported and the
+    // blocks that went out of the planner meanwhile. Blocks longer than that distance leave a lower bound.
+    if (m_plannerCapacity >= 0)
+    {
+        const auto blocksRun = m_plannerBlocksQueued + m_linesAcknowledgedSinceReport - blocksQueued;
+        const auto distance = (m_plannerReportFeedRate + m_currentFeedRate) / 2 *
+                              static_cast<float>(now - m_plannerReportAt) / MICROS_PER_MINUTE;
 
-float GrblInterface::getCurrentSpindleSpeed()
-{
-    return m_currentSpindleSpeed;
+        if (blocksRun > 0 && distance > 0)
+        {
+            m_plannerBlockLength = distance / blocksRun;
+        }
+        else if (blocksRun == 0)
+        {
+            m_plannerBlockLength = std::max(m_plannerBlockLength, distance);
+        }
+    }
+
+    // The planner ran below the target although lines were held back, so they were held too early: the
+    // blocks missing are kept in flight on top from now on. At worst that ends at byte counting alone, or
+    // for the automatic target just below it.
+    if (m_plannerHeldBack && blocksQueued < plannerTargetDepth())
+    {
+        m_plannerLinesAhead = static_cast<uint8_t>(
+            std::min(m_plannerLinesAhead + plannerTargetDepth() - blocksQueued, plannerLinesAheadLimit()));
+    }
+
+    m_plannerCapacity = capacity;
+    m_plannerBlocksQueued = blocksQueued;
+    m_linesAcknowledgedSinceReport = 0;
+    m_plannerReportAt = now;
+    m_plannerReportFeedRate = m_currentFeedRate;
+    m_plannerHeldBack = false;
 }
 
-Coordinate &GrblInterface::getWorkCoordinate()
+void GrblInterface::updatePositionEstimate(Grbl::MachineState machineState, Grbl::CoordinateMode coordinateMode,
+                                           uint32_t requestedAt)
 {
-    return m_workCoordinate;
+#if !defined(GRBL_INTERFACE_NO_WORK_COORDINATE_OFFSET)
+    (void)coordinateMode;
+    const auto &position = m_machineCoordinate;
+#else
+    const auto &position = coordinateMode == Grbl::CoordinateMode::Machine ? m_machineCoordinate : m_workCoordinate;
+#endif
+    const auto moving = machineState == Grbl::MachineState::Run ||
+                        machineState == Grbl::MachineState::Jog ||
+                        machineState == Grbl::MachineState::Home;
+    const auto settled = machineState == Grbl::MachineState::Idle &&
+                         m_linesInFlight.empty() &&
+                         m_plannerBlocksQueued == 0;
+
+    m_positionEstimator.setFeedOverride(m_feedOverride);
+    m_positionEstimator.applyStatusReport(position, m_currentFeedRate, moving, settled, requestedAt,
+                                          Grbl::Platform::micros());
 }
 
-float GrblInterface::getWorkCoordinate(const Grbl::Axis axis)
+void GrblInterface::transmit(const Grbl::LineBuffer &line)
 {
-    if (axis == Grbl::Axis::Unknown)
+    if (onGCodeAboutToBeSent)
     {
-        return 0;
+        onGCodeAboutToBeSent(std::string_view(line.c_str(), line.length()));
     }
 
-    return m_workCoordinate[static_cast<int>(axis)];
+#if !defined(GRBL_INTERFACE_NO_WORK_COORDINATE_OFFSET)
+    m_positionEstimator.applyLine(line.c_str(), &m_workCoordinateOffset);
+#else
+    m_positionEstimator.applyLine(line.c_str(), nullptr);
+#endif
+    GRBL_LOG(line.c_str());
+    m_stream->write(reinterpret_cast<const uint8_t *>(line.c_str()), line.length());
+    m_stream->write(LINE_TERMINATOR);
+#if !defined(GRBL_INTERFACE_NO_STATS)
+    m_stats.bytesSent += line.length() + 1;
+    m_stats.linesSent++;
+#endif
 }
 
-Coordinate &GrblInterface::getMachineCoordinate()
+void GrblInterface::checkCommandTimeout()
 {
-    for (auto i = 0; i < Grbl::MAX_NUMBER_OF_AXES; i++)
+    if (m_linesInFlight.empty())
     {
-        m_machineCoordinate[i] = toMachineCoordinate(m_workCoordinate[i], m_workCoordinateOffset[i]);
+        return;
     }
 
-    return m_machineCoordinate;
-}
+    // Status reports keep arriving while Grbl is busy, so a silent controller is a lost one.
+    const auto now = Grbl::Platform::millis();
+    const auto &oldest = m_linesInFlight.front();
 
-float GrblInterface::getMachineCoordinate(const Grbl::Axis axis)
-{
-    if (axis == Grbl::Axis::Unknown)
+    if (now - oldest.sentAt < m_commandTimeout || now - m_lastLineReceivedAt < m_commandTimeout)
     {
-        return 0;
+        return;
     }
 
-    const auto i = static_cast<int>(axis);
-    return toMachineCoordinate(m_workCoordinate[i], m_workCoordinateOffset[i]);
-}
-
-Coordinate &GrblInterface::getWorkCoordinateOffset()
-{
-    return m_workCoordinateOffset;
+    InFlightLine line;
+    (void)m_linesInFlight.pop(line);
+    m_bytesInFlight -= line.length;
+    completeCommand(line.ticket, Grbl::CommandStatus::Timeout, Grbl::Error::None);
 }
 
-float GrblInterface::getWorkCoordinateOffset(const Grbl::Axis axis)
+void GrblInterface::acknowledgeLine(Grbl::Error error)
 {
-    return m_workCoordinateOffset[static_cast<int>(axis)];
-}
+    InFlightLine line;
 
-bool GrblInterface::machineIsAt(const std::vector<PositionPair> &position)
-{
-    return std::all_of(position.begin(), position.end(), [this](const PositionPair &pos)
-                       { return Utils::equals(pos.second, getMachineCoordinate(pos.first)); });
-}
+    if (!m_linesInFlight.pop(line))
+    {
+        return;
+    }
 
-Grbl::MachineState GrblInterface::currentMachineState()
-{
-    update();
-    return m_machineState;
-}
+    m_bytesInFlight -= line.length;
+    m_streamingStatistics.linesAcknowledged++;
+    m_linesAcknowledgedSinceReport++;
+#if !defined(GRBL_INTERFACE_NO_STATS)
+    m_stats.roundTripTime.add(Grbl::Platform::micros() - line.sentAtMicros);
+#endif
 
-char *GrblInterface::getMachineState(Grbl::MachineState machineState)
-{
-    if (machineState == Grbl::MachineState::Unknown)
+    if (error != Grbl::Error::None)
     {
-        return "N/A";
+        m_streamingStatistics.errors++;
+#if !defined(GRBL_INTERFACE_NO_STATS)
+        m_stats.errors++;
+#endif
     }
 
-    return Grbl::machineStates[static_cast<int>(machineState)];
+    completeCommand(line.ticket, error == Grbl::Error::None ? Grbl::CommandStatus::Ok : Grbl::CommandStatus::Error, error);
 }
 
-Grbl::MachineState GrblInterface::getMachineState(char *state)
+void GrblInterface::completeCommand(Grbl::Ticket ticket, Grbl::CommandStatus status, Grbl::Error error)
 {
-    for (auto i = 0; i < Grbl::machineStates.size(); i++)
+    m_lastCompletedTicket = ticket;
+#if !defined(GRBL_INTERFACE_NO_STATS)
+    m_stats.timeouts += status == Grbl::CommandStatus::Timeout;
+#endif
+
+    if (status != Grbl::CommandStatus::Ok)
     {
-        if (strcmp(state, Grbl::machineStates[i]) == 0)
-        {
-            return static_cast<Grbl::MachineState>(i);
-        }
+        // The line may not have taken effect, or only partly.
+        m_modalState.invalidate();
+        m_positionEstimator.forgetMoves();
     }
 
-    return Grbl::MachineState::Unknown;
-}
+    m_completedCommands[ticket % m_completedCommands.size()] = {ticket, status, error};
 
-char GrblInterface::getAxis(Grbl::Axis axis)
-{
-    if (axis == Grbl::Axis::Unknown)
+    completePathSegment(ticket, status, error);
+
+    if (onCommandCompleted)
     {
-        return '\0';
+        onCommandCompleted(ticket, status, error);
     }
-
-    return Grbl::axes[static_cast<int>(axis)];
 }
 
-Grbl::Axis GrblInterface::getAxis(char axis)
+void GrblInterface::cancelLinesInFlight()
 {
-    for (auto i = 0; i < Grbl::axes.size(); i++)
+    InFlightLine line;
+
+    while (m_linesInFlight.pop(line))
     {
-        if (axis == Grbl::axes[i])
-        {
-            return static_cast<Grbl::Axis>(i);
-        }
+        completeCommand(line.ticket, Grbl::CommandStatus::Cancelled, Grbl::Error::None);
     }
 
-    return Grbl::Axis::Unknown;
+    m_bytesInFlight = 0;
+    m_plannerBlocksQueued = 0; // A reset empties the planner as well.
+    m_linesAcknowledgedSinceReport = 0;
 }
 
-char *GrblInterface::getCoordinateMode(Grbl::CoordinateMode coordinateMode)
+Grbl::PathHandle GrblInterface::startPath(const PathSegment *segments, const Point *points, size_t count,
+                                          float feedRate, bool stopOnError)
 {
-    if (coordinateMode == Grbl::CoordinateMode::Unknown)
+    if (m_pathProgress.state == Grbl::PathState::Running || count == 0 || (segments == nullptr && points == nullptr))
     {
-        return "N/A";
+        return Grbl::INVALID_PATH;
     }
 
-    return Grbl::coordinateModes[static_cast<int>(coordinateMode)];
+    m_pathSegments = segments;
+    m_pathPoints = points;
+    m_pathFeedRate = feedRate;
+    m_pathStopOnError = stopOnError;
+    m_pathStopped = false;
+    m_pathCancelled = false;
+    m_pathProgress = {};
+    m_pathProgress.state = Grbl::PathState::Running;
+    m_pathProgress.segments = count;
+    m_pendingSegments.clear();
+    m_pathHandle++;
+
+    feedPath();
+    return m_pathHandle;
 }
 
-Grbl::CoordinateMode GrblInterface::getCoordinateMode(char *coordinateMode)
+void GrblInterface::feedPath()
 {
-    for (auto i = 0; i < Grbl::coordinateModes.size(); i++)
+    while (m_pathProgress.state == Grbl::PathState::Running &&
+           !m_pathStopped &&
+           m_pathProgress.segmentsSent < m_pathProgress.segments &&
+           !m_queuedLines.full() &&
+           !m_pendingSegments.full())
     {
-        if (strcmp(coordinateMode, Grbl::coordinateModes[i]) == 0)
+        const auto index = m_pathProgress.segmentsSent;
+        resetLine();
+        appendPathSegment(index);
+
+        // Only an overlong line gets here, which Grbl would reject as well.
+        if (!enqueueLine())
         {
-            return static_cast<Grbl::CoordinateMode>(i);
+            m_pathStopped = true;
+            failPathSegment(index, Grbl::CommandStatus::Error, Grbl::Error::None);
+            finishPath();
+            return;
         }
-    }
-
-    return Grbl::CoordinateMode::Unknown;
-}
 
-Grbl::Alarm GrblInterface::currentAlarm()
-{
-    return m_currentAlarm;
+        (void)m_pendingSegments.push({m_lastTicket, index});
+        m_pathProgress.segmentsSent++;
+    }
 }
 
-Grbl::Error GrblInterface::currentError()
+void GrblInterface::appendPathSegment(size_t index)
 {
-    return m_currentError;
-}
-
-// --------------------------------------------------------------------------------------------------
-// Private methods
-// --------------------------------------------------------------------------------------------------
+    if (m_pathPoints != nullptr)
+    {
+        appendModalCommand(Grbl::Command::G1_LinearInterpolation);
+        appendFeedRate(m_pathFeedRate);
+        appendValue(getAxis(Grbl::Axis::X), m_pathPoints[index].first);
+        appendValue(getAxis(Grbl::Axis::Y), m_pathPoints[index].second);
+        return;
+    }
 
-void GrblInterface::processBuffer()
-{
-    static MatchState ms;
-    char buffer[m_buffer.length() + 1];
-    char tempBuffer[m_buffer.length() + 1];
-    strcpy(buffer, m_buffer.c_str());
-    ms.Target(buffer);
+    const auto &segment = m_pathSegments[index];
 
-    if (ms.Match((char *)RegEx::FEED_AND_SPEED) > 0)
+    switch (segment.type)
     {
-        ms.GetCapture(tempBuffer, ResponseIndex::STATUS_REPORT_FEED_RATE);
-        m_currentFeedRate = atof(tempBuffer);
-        ms.GetCapture(tempBuffer, ResponseIndex::STATUS_REPORT_SPINDLE_SPEED);
-        m_currentSpindleSpeed = atof(tempBuffer);
+    case Grbl::SegmentType::Line:
+    {
+        appendModalCommand(Grbl::Command::G1_LinearInterpolation);
+        break;
     }
-
-    if (ms.Match((char *)RegEx::WORK_COORDINATE_OFFSET) > 0)
+#if !defined(GRBL_INTERFACE_NO_ARCS)
+    case Grbl::SegmentType::ClockwiseArc:
     {
-        ms.GetCapture(tempBuffer, ResponseIndex::STATUS_REPORT_WORK_COORDINATE_OFFSET);
-        extractPosition(tempBuffer, &m_workCoordinateOffset);
+        appendModalCommand(Grbl::Command::G2_ClockwiseCircularInterpolation);
+        break;
     }
-
-    if (ms.Match((char *)RegEx::STATUS_REPORT) > 0)
+    case Grbl::SegmentType::CounterClockwiseArc:
     {
-        if (statusReportReceived)
-        {
-            statusReportReceived(m_buffer);
-        }
+        appendModalCommand(Grbl::Command::G3_CounterclockwiseCircularInterpolation);
+        break;
+    }
+#endif
+    }
 
-        ms.GetCapture(tempBuffer, ResponseIndex::STATUS_REPORT_MACHINE_STATE);
-        auto machineState = getMachineState(tempBuffer);
+    appendFeedRate(m_pathFeedRate);
+    appendValue(getAxis(Grbl::Axis::X), segment.end.first);
+    appendValue(getAxis(Grbl::Axis::Y), segment.end.second);
 
-        if (machineState == Grbl::MachineState::Unknown)
-        {
-            return;
-        }
+#if !defined(GRBL_INTERFACE_NO_ARCS)
+    if (segment.type != Grbl::SegmentType::Line)
+    {
+        appendValue('I', segment.center.first);
+        appendValue('J', segment.center.second);
+    }
+#endif
+}
 
-        m_machineState = machineState;
-        ms.GetCapture(tempBuffer, ResponseIndex::STATUS_REPORT_POSITION_MODE);
-        auto coordinateMode = getCoordinateMode(tempBuffer);
+void GrblInterface::completePathSegment(Grbl::Ticket ticket, Grbl::CommandStatus status, Grbl::Error error)
+{
+    if (m_pendingSegments.empty() || m_pendingSegments.front().ticket != ticket)
+    {
+        return;
+    }
 
-        if (coordinateMode == Grbl::CoordinateMode::Unknown)
-        {
-            return;
-        }
+    PendingSegment segment;
+    (void)m_pendingSegments.pop(segment);
+    m_pathProgress.segmentsCompleted++;
 
-        ms.GetCapture(tempBuffer, ResponseIndex::STATUS_REPORT_POSITION);
-        extractPosition(tempBuffer, &m_workCoordinate);
+    if (status != Grbl::CommandStatus::Ok)
+    {
+        failPathSegment(segment.index, status, error);
+    }
 
-        if (coordinateMode == Grbl::CoordinateMode::Machine)
-        {
-            for (auto i = 0; i < Grbl::MAX_NUMBER_OF_AXES; i++)
-            {
-                m_workCoordinate[i] = toWorkCoordinate(m_workCoordinate[i], m_workCoordinateOffset[i]);
-            }
-        }
+    finishPath();
+}
 
-        if (onPositionUpdate)
+void GrblInterface::failPathSegment(size_t index, Grbl::CommandStatus status, Grbl::Error error)
+{
+    if (status == Grbl::CommandStatus::Cancelled)
+    {
+        m_pathStopped = true;
+        m_pathCancelled = true;
+    }
+    else
+    {
+        if (m_pathProgress.errors++ == 0)
         {
-            onPositionUpdate(machineState, coordinateMode);
+            m_pathProgress.firstFailedSegment = index;
+            m_pathProgress.firstError = error;
         }
 
-        m_limitSwitchesTriggered.clear();
-
-        if (ms.Match((char *)RegEx::LIMIT_SWITCH) > 0)
-        {
-            ms.GetCapture(tempBuffer, ResponseIndex::STATUS_REPORT_LIMIT_SWITCH);
-
-            for (auto i = 0; i < Grbl::MAX_NUMBER_OF_AXES; i++)
-            {
-                for (const auto c : tempBuffer)
-                {
-                    if (c == Grbl::axes[i])
-                    {
-                        m_limitSwitchesTriggered.push_back(static_cast<Grbl::Axis>(i));
-                    }
-                }
-            }
-        }
+        m_pathStopped = m_pathStopped || m_pathStopOnError;
     }
 
-    if (ms.Match((char *)RegEx::OK_RESPONSE) > 0 && onOkResponseReceived)
+    if (onPathSegmentFailed)
     {
-        onOkResponseReceived(true);
+        onPathSegmentFailed(index, status, error);
     }
+}
 
-    if (ms.Match((char *)RegEx::ALARM_CODE) > 0)
+void GrblInterface::finishPath()
+{
+    if (m_pathProgress.state != Grbl::PathState::Running || !m_pendingSegments.empty())
     {
-        ms.GetCapture(tempBuffer, 0);
-
-        try
-        {
-            const auto alarmCode = std::stoi(tempBuffer);
-            m_currentAlarm = static_cast<Grbl::Alarm>(alarmCode);
-        }
-        catch (std::invalid_argument &e)
-        {
-            return;
-        }
+        return;
     }
 
-    if (ms.Match((char *)RegEx::ERROR_CODE) > 0)
+    if (!m_pathStopped && m_pathProgress.segmentsSent < m_pathProgress.segments)
     {
-        ms.GetCapture(tempBuffer, 0);
+        return;
+    }
 
-        try
-        {
-            const auto errorCode = std::stoi(tempBuffer);
-            m_currentError = static_cast<Grbl::Error>(errorCode);
-        }
-        catch (std::invalid_argument &e)
-        {
-            return;
-        }
+    if (m_pathProgress.errors > 0)
+    {
+        m_pathProgress.state = Grbl::PathState::Failed;
+    }
+    else if (m_pathCancelled)
+    {
+        m_pathProgress.state = Grbl::PathState::Cancelled;
+    }
+    else
+    {
+        m_pathProgress.state = Grbl::PathState::Completed;
     }
 
-    m_buffer.clear();
+    m_pathSegments = nullptr;
+    m_pathPoints = nullptr;
 }
 
-void GrblInterface::resetStringStream()
+#if !defined(GRBL_INTERFACE_NO_STATS)
+void GrblInterface::recordStatusReport()
 {
-    std::stringstream ss;
-    m_stringStream.swap(ss);
-    m_stringStream.setf(std::ios::fixed);
-    m_stringStream.precision(Grbl::FLOAT_PRECISION);
-}
+    const auto now = Grbl::Platform::micros();
 
-void GrblInterface::appendCommand(const Grbl::Command command, char postpend)
-{
-    m_stringStream << Grbl::getCommand(command) << postpend;
-}
+    if (m_stats.statusReports > 0)
+    {
+        const auto interval = now - m_lastStatusReportAt;
+        m_stats.statusReportInterval.add(interval);
 
-void GrblInterface::appendValue(char indicator, float value, char postpend)
-{
-    m_stringStream << indicator << value << postpend;
+        if (m_lastStatusReportInterval > 0)
+        {
+            const auto change = std::abs(static_cast<float>(interval) - static_cast<float>(m_lastStatusReportInterval));
+            m_stats.statusReportJitter += (change - m_stats.statusReportJitter) / JITTER_SMOOTHING;
+        }
+
+        m_lastStatusReportInterval = interval;
+    }
+
+    m_lastStatusReportAt = now;
+    m_stats.statusReports++;
 }
+#endif
 
-void GrblInterface::appendValue(char indicator, int value, char postpend)
+void GrblInterface::extractPosition(const char *&cursor, Coordinate &position)
 {
-    m_stringStream << indicator << value << postpend;
+    Grbl::Parser::parseValues(cursor, position.data(), position.size());
 }
 
-void GrblInterface::serializePosition(const std::vector<PositionPair> &position)
+StatusSnapshot GrblInterface::publishStatusSnapshot(Grbl::CoordinateMode coordinateMode, uint32_t receivedAt)
 {
-    std::for_each(position.begin(), position.end(), [this](const PositionPair &pos)
-                  { m_stringStream << getAxis(pos.first) << pos.second << ' '; });
+    StatusSnapshot snapshot;
+    snapshot.machineState = m_machineState;
+    snapshot.coordinateMode = coordinateMode;
+    snapshot.workPosition = m_workCoordinate;
+    snapshot.machinePosition = m_machineCoordinate;
+#if !defined(GRBL_INTERFACE_NO_WORK_COORDINATE_OFFSET)
+    snapshot.workCoordinateOffset = m_workCoordinateOffset;
+#endif
+    snapshot.subState = m_subState;
+    snapshot.feedRate = m_currentFeedRate;
+    snapshot.spindleSpeed = m_currentSpindleSpeed;
+    snapshot.limitSwitches = m_limitSwitches;
+    snapshot.controlPins = m_controlPins;
+    snapshot.plannerBlocksAvailable = m_plannerBlocksAvailable;
+    snapshot.rxBytesAvailable = m_rxBytesAvailable;
+    snapshot.lineNumber = m_lineNumber;
+    snapshot.feedOverride = m_feedOverride;
+    snapshot.rapidOverride = m_rapidOverride;
+    snapshot.spindleOverride = m_spindleOverride;
+    snapshot.accessories = m_accessories;
+    snapshot.alarm = m_currentAlarm;
+    snapshot.error = m_currentError;
+    snapshot.receivedAt = receivedAt;
+
+    m_statusSnapshot.write(snapshot);
+    return snapshot;
 }
 
-void GrblInterface::send()
+void GrblInterface::notifyStatusChanges(const StatusSnapshot &snapshot, uint16_t events)
 {
-    if (onGCodeAboutToBeSent)
+    const auto changes = static_cast<uint16_t>(statusChanges(snapshot) | events);
+
+    if (changes == 0)
     {
-        onGCodeAboutToBeSent(m_stringStream.str());
+        return;
     }
 
-    m_stream->println(m_stringStream.str().c_str());
-}
-
-bool GrblInterface::sendCommand(const Grbl::Command command, bool waitForResponse)
-{
-    resetStringStream();
-    m_stringStream << Grbl::getCommand(command);
+    const auto previous = m_notifiedSnapshot;
+    m_notifiedSnapshot = snapshot;
 
-    if (waitForResponse)
+    // Positions below the threshold accumulate until they add up to a change.
+    if ((changes & static_cast<uint16_t>(Grbl::StatusChange::Position)) == 0)
     {
-        return sendWaitingForOkResponse(RESPONSE_TIMEOUT);
+        m_notifiedSnapshot.machinePosition = previous.machinePosition;
+        m_notifiedSnapshot.workPosition = previous.workPosition;
     }
 
-    send();
-    return true;
+    for (const auto &subscription : m_subscriptions)
+    {
+        if ((subscription.changeMask & changes) != 0)
+        {
+            subscription.listener(changes, previous, snapshot);
+        }
+    }
 }
 
-bool GrblInterface::sendWaitingForOkResponse(uint16_t timeout)
+uint16_t GrblInterface::statusChanges(const StatusSnapshot &snapshot) const
 {
-    uint32_t timeoutAt = millis() + timeout;
-    std::stringstream ss;
-    bool okResponseReceived = false;
+    const auto &notified = m_notifiedSnapshot;
+    uint16_t changes = 0;
 
-    onOkResponseReceived = [&okResponseReceived](bool result)
+    if (snapshot.machineState != notified.machineState || snapshot.subState != notified.subState)
     {
-        okResponseReceived = result;
-    };
-
-    send();
+        changes |= static_cast<uint16_t>(Grbl::StatusChange::State);
+    }
 
-    while (millis() < timeoutAt)
+    for (auto i = 0; i < Grbl::MAX_NUMBER_OF_AXES; i++)
     {
-        update(); // Process current buffer
-
-        if (okResponseReceived)
+        if (std::fabs(snapshot.machinePosition[i] - notified.machinePosition[i]) > m_positionChangeThreshold ||
+            std::fabs(snapshot.workPosition[i] - notified.workPosition[i]) > m_positionChangeThreshold)
         {
-            return true;
+            changes |= static_cast<uint16_t>(Grbl::StatusChange::Position);
+            break;
         }
     }
 
-    return false;
-}
+#if !defined(GRBL_INTERFACE_NO_WORK_COORDINATE_OFFSET)
+    if (snapshot.workCoordinateOffset != notified.workCoordinateOffset)
+    {
+        changes |= static_cast<uint16_t>(Grbl::StatusChange::WorkCoordinateOffset);
+    }
+#endif
 
-void GrblInterface::extractPosition(const char *positionString, Coordinate *positionArray)
-{
-    std::string pos(positionString);
-    std::string position;
-    std::stringstream ss(pos);
-    const auto numberOfAxes = std::count(pos.begin(), pos.end(), VALUE_SEPARATOR) + 1;
+    if (snapshot.feedRate != notified.feedRate || snapshot.spindleSpeed != notified.spindleSpeed)
+    {
+        changes |= static_cast<uint16_t>(Grbl::StatusChange::FeedAndSpeed);
+    }
 
-    if (numberOfAxes > Grbl::MAX_NUMBER_OF_AXES)
+    if (snapshot.limitSwitches != notified.limitSwitches || snapshot.controlPins != notified.controlPins)
     {
-        return;
+        changes |= static_cast<uint16_t>(Grbl::StatusChange::Pins);
     }
 
-    for (auto i = 0; i < numberOfAxes; i++)
+    if (snapshot.feedOverride != notified.feedOverride || snapshot.rapidOverride != notified.rapidOverride ||
+        snapshot.spindleOverride != notified.spindleOverride)
     {
-        std::getline(ss, position, VALUE_SEPARATOR);
+        changes |= static_cast<uint16_t>(Grbl::StatusChange::Overrides);
+    }
 
-        if (!position.empty())
-        {
-            try
-            {
-                (*positionArray)[i] = std::stof(position);
-            }
-            catch (std::invalid_argument &e)
-            {
-                return;
-            }
-        }
+    if (snapshot.accessories != notified.accessories)
+    {
+        changes |= static_cast<uint16_t>(Grbl::StatusChange::Accessories);
     }
+
+    if (snapshot.lineNumber != notified.lineNumber)
+    {
+        changes |= static_cast<uint16_t>(Grbl::StatusChange::LineNumber);
+    }
+
+    return changes;
 }
 
+#if !defined(GRBL_INTERFACE_NO_WORK_COORDINATE_OFFSET)
 float GrblInterface::toWorkCoordinate(float machineCoordinate, float offset)
 {
     // WPos = MPos - WCO
@@ -740,3 +2614,4 @@ float GrblInterface::toMachineCoordinate(float workCoordinate, float offset)
     // MPos = WPos + WCO
     return workCoordinate + offset;
 }
+#endif
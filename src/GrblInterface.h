@@ -1,13 +1,22 @@
 #pragma once
 
-#include "Arduino.h"
+#include "GrblPlatform.h"
 #include "GrblConstants.h"
 #include "GrblCommands.h"
+#include "Histogram.h"
+#include "LineBuffer.h"
+#include "ModalState.h"
+#include "PositionEstimator.h"
+#include "RingBuffer.h"
+#include "SeqLock.h"
+#include "SerialReader.h"
 
-#include <sstream>
+#include <functional>
+#include <initializer_list>
+#include <string_view>
 #include <vector>
 
-#if not defined(ESP32)
+#if defined(ARDUINO) && !defined(ESP32)
 #error "This library only support ESP32"
 #endif
 
@@ -15,47 +24,251 @@ using PositionPair = std::pair<Grbl::Axis, float>;
 using Coordinate = std::array<float, Grbl::MAX_NUMBER_OF_AXES>;
 using Point = std::pair<float, float>;
 
+// Positions of one command, at most one per axis. Kept in place rather than on the heap, so e.g.
+// linearRapidPositioning({{Grbl::Axis::X, 10}}) never allocates; vectors are still accepted.
+class PositionList
+{
+public:
+    PositionList(std::initializer_list<PositionPair> positions);
+    PositionList(const std::vector<PositionPair> &positions);
+    PositionList(const PositionPair *positions, size_t count);
+
+    [[nodiscard]] const PositionPair *begin() const;
+    [[nodiscard]] const PositionPair *end() const;
+    [[nodiscard]] size_t size() const;
+    [[nodiscard]] bool overflowed() const; // More positions were given than there are axes.
+
+private:
+    std::array<PositionPair, Grbl::MAX_NUMBER_OF_AXES> m_positions;
+    size_t m_count;
+    bool m_overflowed;
+};
+
 enum class RotationDirection
 {
     Clockwise,
     CounterClockwise
 };
 
+struct StreamingStatistics
+{
+    uint32_t linesSent;
+    uint32_t linesAcknowledged;
+    uint32_t errors;
+    uint32_t bytesSent;
+    size_t linesInFlight;
+    size_t bytesInFlight;
+    float linesPerSecond;
+};
+
+// One move of a path in the XY plane, from the end of the previous segment.
+struct PathSegment
+{
+    Grbl::SegmentType type;
+    Point end;
+#if !defined(GRBL_INTERFACE_NO_ARCS)
+    Point center; // Arc center relative to the segment's start point (I, J), unused for lines.
+#endif
+};
+
+struct PathProgress
+{
+    Grbl::PathState state;
+    size_t segments;
+    size_t segmentsSent;
+    size_t segmentsCompleted;
+    uint32_t errors;
+    size_t firstFailedSegment; // Only valid while errors > 0.
+    Grbl::Error firstError;
+};
+
+// Everything one status report told about the machine, published as a whole.
+struct StatusSnapshot
+{
+    Grbl::MachineState machineState;
+    Grbl::CoordinateMode coordinateMode; // Which position Grbl reported, the other one is derived (see
+                                         // GRBL_INTERFACE_NO_WORK_COORDINATE_OFFSET).
+    Coordinate workPosition;
+    Coordinate machinePosition;
+#if !defined(GRBL_INTERFACE_NO_WORK_COORDINATE_OFFSET)
+    Coordinate workCoordinateOffset;
+#endif
+    uint8_t subState; // E.g. 1 for "Hold:1", 0 for states without one.
+    float feedRate;
+    float spindleSpeed;
+    uint8_t limitSwitches; // Bit n is set while the limit switch of Grbl::Axis n is triggered.
+    uint8_t controlPins;   // Grbl::ControlPin bits.
+    int16_t plannerBlocksAvailable; // -1 while Grbl does not report Bf:.
+    int16_t rxBytesAvailable;       // -1 while Grbl does not report Bf:.
+    uint32_t lineNumber;            // 0 while no numbered line is executing.
+    uint8_t feedOverride;           // Percent.
+    uint8_t rapidOverride;
+    uint8_t spindleOverride;
+    uint8_t accessories; // Grbl::Accessory bits.
+    Grbl::Alarm alarm;   // The last "ALARM:" received, Grbl::Alarm::None before the first one.
+    Grbl::Error error;   // The last "error:" received, Grbl::Error::None before the first one.
+    uint32_t receivedAt;   // Grbl::Platform::millis() when the status report arrived, 0 until the first one.
+};
+
 class GrblInterface
 {
 public:
+#if !defined(GRBL_INTERFACE_NO_STATS)
+    // Link metrics since construction or resetStats(). Times are in microseconds, rates are averages
+    // over the whole period.
+    struct Stats
+    {
+        uint32_t elapsedMs;
+        uint32_t bytesSent; // Lines including their terminator, and realtime commands.
+        uint32_t bytesReceived;
+        float txBytesPerSecond;
+        float rxBytesPerSecond;
+        uint32_t linesSent;
+        uint32_t linesReceived;
+        uint32_t linesDropped; // Too long to be kept, see Grbl::RECEIVED_LINE_SIZE.
+        float linesReceivedPerSecond;
+        Grbl::Histogram roundTripTime; // From writing a line until its "ok" or "error:" arrived.
+        Grbl::Histogram parseTime;     // Per received line.
+        uint32_t statusReports;
+        Grbl::Histogram statusReportInterval; // Between consecutive status reports.
+        float statusReportJitter;             // Change of the interval from report to report, smoothed as in RFC 3550.
+        uint32_t statusReportAgeMs;           // Since the last status report, 0 before the first one.
+        uint32_t timeouts;
+        uint32_t errors;
+        uint32_t alarms;
+    };
+#endif
+
+    GrblInterface(Grbl::ByteStream &stream);
+#if defined(ARDUINO)
     GrblInterface(Stream &stream);
+#endif
 
     void update(uint16_t timeout = Grbl::DEFAULT_TIMEOUT_MS);
     void clearBuffer();
-    bool getStatusReport(bool waitForOkResponse = true);
+    // Requests a status report, which update() processes once it arrives. Grbl never answers it with "ok".
+    bool getStatusReport();
+
+    // update() polls status reports at the motion interval while the machine moves or lines are in flight,
+    // and at the idle interval in Idle and Alarm. Only one request is outstanding at a time.
+    void setStatusReportIntervals(uint16_t motionInterval, uint16_t idleInterval);
+    // Disables the polling in update(), for callers that schedule the requests themselves. Blocking calls
+    // still request a report once the caller's is overdue, as they hold the caller up.
+    void setAutomaticStatusReports(bool enabled);
+    [[nodiscard]] uint32_t statusReportInterval();
+    [[nodiscard]] bool statusReportPending();
+    // Bit n is set while the limit switch of Grbl::Axis n is triggered.
+    [[nodiscard]] uint8_t limitSwitchMask();
+    // Same as limitSwitchMask(), but allocates.
     std::vector<Grbl::Axis> limitSwitchesTriggered();
 
+    // Character-counting streaming. While enabled, commands return as soon as their line fits into
+    // Grbl's RX buffer instead of waiting for its "ok". The RX buffer size (Grbl::RX_BUFFER_SIZE until set)
+    // and the streaming statistics are kept across mode changes, as JogController and JobRunner switch
+    // modes on their own.
+    void setStreamingMode(bool enabled, uint16_t rxBufferSize = Grbl::RX_BUFFER_SIZE_UNCHANGED);
+    [[nodiscard]] bool streamingModeEnabled();
+
+    // Planner flow control. While enabled and Grbl reports Bf:, lines are held back once the planner blocks
+    // queued at the last status report, plus the lines acknowledged and sent since, minus the blocks run
+    // since at the reported feed rate, reach targetDepth plus a few lines in flight. That keeps the planner
+    // full for Grbl to plan ahead, but the RX buffer nearly empty, so a feed hold or an abort does not have
+    // to wait for the lines in it. While the planner runs below targetDepth, byte counting alone applies.
+    // A planner larger than Grbl::PLANNER_BLOCKS is learned from the blocks reported available;
+    // Grbl::PLANNER_TARGET_DEPTH_AUTO follows it and never falls back to byte counting: it keeps fewer lines
+    // in flight than Grbl's RX buffer would hold, so fewer moves are queued than with character counting.
+    void setPlannerFlowControl(bool enabled, uint8_t targetDepth = Grbl::PLANNER_TARGET_DEPTH_AUTO);
+    [[nodiscard]] bool plannerFlowControlEnabled();
+    // Planner blocks plus lines in flight the flow control counts with, -1 until Grbl reported Bf:.
+    [[nodiscard]] int plannerDepthEstimate();
+
+    // Asynchronous mode. While enabled, commands only queue their line and return right away; the queue is
+    // worked off by update() and the outcome is reported through onCommandCompleted or commandStatus().
+    void setAsynchronousMode(bool enabled);
+    [[nodiscard]] bool asynchronousModeEnabled();
+    void setCommandTimeout(uint32_t timeout);
+    [[nodiscard]] Grbl::Ticket sendLine(const char *line);
+    [[nodiscard]] Grbl::Ticket lastTicket();
+    [[nodiscard]] Grbl::Ticket lastCompletedTicket();
+    // Unknown for tickets completed more than Grbl::COMMAND_HISTORY_SIZE tickets ago.
+    [[nodiscard]] Grbl::CommandStatus commandStatus(Grbl::Ticket ticket);
+    [[nodiscard]] bool waitForCommand(Grbl::Ticket ticket, uint32_t timeout);
+    [[nodiscard]] size_t commandsQueued();
+
+#if !defined(GRBL_INTERFACE_NO_READER_TASK)
+    // Threaded reception. A reader task drains the stream into a queue of complete lines that update()
+    // parses afterwards. While it runs, the stream must not be read from anywhere else.
+    [[nodiscard]] bool startReaderTask(int core = Grbl::READER_TASK_CORE);
+    void stopReaderTask();
+    [[nodiscard]] bool readerTaskRunning();
+    [[nodiscard]] Grbl::SerialReaderStatistics getReaderStatistics();
+#endif
+    [[nodiscard]] bool waitForStreamToDrain(uint32_t timeout);
+    [[nodiscard]] size_t linesInFlight();
+    [[nodiscard]] size_t bytesInFlight();
+    [[nodiscard]] StreamingStatistics getStreamingStatistics();
+    void resetStreamingStatistics();
+#if !defined(GRBL_INTERFACE_NO_STATS)
+    [[nodiscard]] Stats getStats();
+    void resetStats();
+#endif
+
+    // Compact emission. While enabled, numbers are written with the fewest decimals that stay within tolerance
+    // and without trailing zeros, and words are no longer separated by spaces, e.g. "G1X10Y.5F500" instead
+    // of "G1 F500.000 X10.000 Y0.500 ". In incremental distance mode the rounding errors add up over moves.
+    void setCompactEmission(bool enabled, float tolerance = Grbl::DEFAULT_COMPACT_TOLERANCE);
+    [[nodiscard]] bool compactEmissionEnabled();
+
+    // Modal-state tracking. While enabled, the modal words of every accepted line are remembered, and
+    // commands leave out motion modes, feed rates and whole modal commands Grbl already has active. Anything
+    // uncertain (an error, a timeout, a reset) forgets the state, so the next commands send every word again.
+    // While a line that changes the state is not acknowledged yet, nothing is left out, as Grbl may still
+    // reject it. Feed rates are only left out while G94 is known to be active, and are sent again after G20/G21.
+    // requestParserState() takes the exact state over from Grbl with $G.
+    void setModalStateTracking(bool enabled);
+    [[nodiscard]] bool modalStateTrackingEnabled();
+    [[nodiscard]] bool requestParserState();
+    [[nodiscard]] const Grbl::ModalState &modalState();
+
+    // Path submission. A path is a contiguous array of segments with one feed rate. It is queued back-to-back
+    // by update() as room frees up, without waiting for the individual "ok"s, so the array must stay valid
+    // until the path has finished. One path runs at a time; failed segments are reported through
+    // onPathSegmentFailed and getPathProgress().
+    [[nodiscard]] Grbl::PathHandle sendPath(const PathSegment *segments, size_t count, float feedRate,
+                                            bool stopOnError = true);
+    [[nodiscard]] Grbl::PathHandle sendPolyline(const Point *points, size_t count, float feedRate,
+                                                bool stopOnError = true);
+    void cancelPath(Grbl::PathHandle path);
+    [[nodiscard]] PathProgress getPathProgress(Grbl::PathHandle path);
+    [[nodiscard]] bool waitForPath(Grbl::PathHandle path, uint32_t timeout);
+
     // G-codes
     [[nodiscard]] bool setUnitOfMeasurement(Grbl::UnitOfMeasurement unitOfMeasurement);
     [[nodiscard]] bool setDistanceMode(Grbl::DistanceMode distanceMode);
 
-    [[nodiscard]] bool setCoordinateOffset(const std::vector<PositionPair> &position);
+    [[nodiscard]] bool setCoordinateOffset(const PositionList &position);
     [[nodiscard]] bool clearCoordinateOffset();
 
-    [[nodiscard]] bool linearRapidPositioning(const std::vector<PositionPair> &position);
-    [[nodiscard]] bool linearInterpolationPositioning(float feedRate, const std::vector<PositionPair> &position);
-    [[nodiscard]] bool linearPositioningInMachineCoordinate(const std::vector<PositionPair> &position);
+    [[nodiscard]] bool linearRapidPositioning(const PositionList &position);
+    [[nodiscard]] bool linearInterpolationPositioning(float feedRate, const PositionList &position);
+    [[nodiscard]] bool linearPositioningInMachineCoordinate(const PositionList &position);
 
+#if !defined(GRBL_INTERFACE_NO_ARCS)
     [[nodiscard]] bool arcInterpolationPositioning(Grbl::ArcMovement direction,
-                                                   const std::vector<PositionPair> &endPosition,
+                                                   const PositionList &endPosition,
                                                    float radius,
                                                    float feedRate);
     [[nodiscard]] bool arcInterpolationPositioning(Grbl::ArcMovement direction,
-                                                   const std::vector<PositionPair> &endPosition,
+                                                   const PositionList &endPosition,
                                                    Point centerPoint,
                                                    float feedRate);
+#endif
 
     [[nodiscard]] bool dwell(uint16_t durationSeconds);
 
     [[nodiscard]] bool setCoordinateSystemOrigin(Grbl::CoordinateOffset coordinateOffset,
                                                  Grbl::CoordinateSystem coordinateSystem,
-                                                 const std::vector<PositionPair> &position);
+                                                 const PositionList &position);
 
     [[nodiscard]] bool setPlane(Grbl::Plane plane);
 
@@ -71,67 +284,277 @@ public:
     [[nodiscard]] bool runHomingCycle();
     [[nodiscard]] bool runHomingCycle(Grbl::Axis axis);
     [[nodiscard]] bool clearAlarm();
-    [[nodiscard]] bool jog(float feedRate, const std::vector<PositionPair> &position);
+#if !defined(GRBL_INTERFACE_NO_JOGGING)
+    [[nodiscard]] bool jog(float feedRate, const PositionList &position);
+#endif
+
+    // Realtime commands, written immediately and never queued behind streamed lines.
+    void sendRealtimeCommand(Grbl::RealtimeCommand command);
+#if !defined(GRBL_INTERFACE_NO_JOGGING)
+    // Also withdraws the jog lines still queued, so they cannot start the motion again.
+    void cancelJog();
+#endif
+    void openSafetyDoor();
+    void adjustFeedOverride(Grbl::OverrideAdjustment adjustment);
+    void adjustSpindleOverride(Grbl::OverrideAdjustment adjustment);
+    void setRapidOverride(Grbl::RapidOverride rapidOverride);
+    void toggleSpindleStop();
+    void toggleFloodCoolant();
+    void toggleMistCoolant();
 
     [[nodiscard]] float getCurrentFeedRate();
     [[nodiscard]] float getCurrentSpindleSpeed();
+    [[nodiscard]] uint8_t currentSubState();
+    // Free planner blocks and RX buffer bytes from the Bf: field, -1 while Grbl does not report it ($10).
+    [[nodiscard]] int16_t plannerBlocksAvailable();
+    [[nodiscard]] int16_t rxBytesAvailable();
+    // Line number (Ln:) of the block executing, 0 while there is none.
+    [[nodiscard]] uint32_t currentLineNumber();
+    // Overrides in percent. Grbl only reports them every few reports, so they lag behind by up to a few
+    // status report intervals.
+    [[nodiscard]] uint8_t feedOverride();
+    [[nodiscard]] uint8_t rapidOverride();
+    [[nodiscard]] uint8_t spindleOverride();
+    // Grbl::Accessory bits, reported along with the overrides.
+    [[nodiscard]] uint8_t accessoryMask();
+    // Grbl::ControlPin bits set while the pin is triggered.
+    [[nodiscard]] uint8_t controlPinMask();
+
+    // The getters below are meant for the task calling update(). Other tasks read getStatusSnapshot(),
+    // which never returns a half-updated report.
+    [[nodiscard]] StatusSnapshot getStatusSnapshot() const;
 
-    [[nodiscard]] Coordinate &getWorkCoordinate();
+    [[nodiscard]] const Coordinate &getWorkCoordinate();
     [[nodiscard]] float getWorkCoordinate(Grbl::Axis axis);
 
-    [[nodiscard]] Coordinate &getMachineCoordinate();
+    [[nodiscard]] const Coordinate &getMachineCoordinate();
     [[nodiscard]] float getMachineCoordinate(Grbl::Axis axis);
 
-    [[nodiscard]] Coordinate &getWorkCoordinateOffset();
+#if !defined(GRBL_INTERFACE_NO_WORK_COORDINATE_OFFSET)
+    [[nodiscard]] const Coordinate &getWorkCoordinateOffset();
     [[nodiscard]] float getWorkCoordinateOffset(Grbl::Axis axis);
+#endif
+
+    // Position between status reports, e.g. for a DRO, extrapolated by Grbl::PositionEstimator from the last
+    // report and the moves sent since. The uncertainty assumes no axis accelerates faster than
+    // maxAcceleration. Without work coordinate offsets only incremental moves can be placed.
+    void setEstimatorAcceleration(float maxAcceleration);
+    [[nodiscard]] Grbl::PositionEstimate estimatedPosition(uint32_t now = Grbl::Platform::micros());
 
-    [[nodiscard]] bool machineIsAt(const std::vector<PositionPair> &position);
+    [[nodiscard]] bool machineIsAt(const PositionList &position);
 
     [[nodiscard]] Grbl::MachineState currentMachineState();
-    [[nodiscard]] char *getMachineState(Grbl::MachineState machineState);
-    [[nodiscard]] Grbl::MachineState getMachineState(char *state);
+    [[nodiscard]] const char *getMachineState(Grbl::MachineState machineState);
+    [[nodiscard]] Grbl::MachineState getMachineState(const char *state);
 
     [[nodiscard]] char getAxis(Grbl::Axis axis);
     [[nodiscard]] Grbl::Axis getAxis(char axis);
 
-    [[nodiscard]] char *getCoordinateMode(Grbl::CoordinateMode coordinateMode);
-    [[nodiscard]] Grbl::CoordinateMode getCoordinateMode(char *coordinateMode);
+    [[nodiscard]] const char *getCoordinateMode(Grbl::CoordinateMode coordinateMode);
+    [[nodiscard]] Grbl::CoordinateMode getCoordinateMode(const char *coordinateMode);
 
     [[nodiscard]] Grbl::Alarm currentAlarm();
     [[nodiscard]] Grbl::Error currentError();
 
+    // Change-driven status updates. After each status report, "ALARM:" and "error:", the snapshot is compared
+    // with the one of the last notification, and only listeners subscribed to a Grbl::StatusChange group
+    // that changed run, with the changed bits and both snapshots. Position only counts as changed once an
+    // axis moved further than the threshold from the position last notified, so previous holds that position.
+    // Listeners run on the task calling update() and may unsubscribe, but not subscribe, from within.
+    using StatusListener =
+        std::function<void(uint16_t changes, const StatusSnapshot &previous, const StatusSnapshot &current)>;
+
+    // Returns Grbl::INVALID_SUBSCRIPTION once Grbl::MAX_STATUS_SUBSCRIPTIONS listeners are subscribed.
+    [[nodiscard]] Grbl::SubscriptionHandle subscribe(uint16_t changeMask, StatusListener listener);
+    void unsubscribe(Grbl::SubscriptionHandle handle);
+    void setPositionChangeThreshold(float threshold);
+
     // Others
+    // Runs on every status report, changed or not. See subscribe() for listeners of changes only.
     std::function<void(Grbl::MachineState, Grbl::CoordinateMode)> onPositionUpdate;
-    std::function<void(std::string)> onGCodeAboutToBeSent;
-    std::function<void(std::string)> statusReportReceived;
+    std::function<void(std::string_view)> onGCodeAboutToBeSent;
+    std::function<void(std::string_view)> statusReportReceived;
+    std::function<void(Grbl::Ticket ticket, Grbl::CommandStatus status, Grbl::Error error)> onCommandCompleted;
+    std::function<void(size_t segment, Grbl::CommandStatus status, Grbl::Error error)> onPathSegmentFailed;
 
 private:
-    Stream *m_stream;
-    std::string m_buffer;
+#if defined(ARDUINO)
+    Grbl::ArduinoStream m_arduinoStream;
+#endif
+    Grbl::ByteStream *m_stream;
+#if !defined(GRBL_INTERFACE_NO_READER_TASK)
+    Grbl::SerialReader m_reader; // Its queue of received lines takes about 8 kB.
+#endif
+    Grbl::ReceivedLine m_received; // Line being assembled while update() polls the stream.
     Grbl::MachineState m_machineState;
     Coordinate m_workCoordinate;
+#if !defined(GRBL_INTERFACE_NO_WORK_COORDINATE_OFFSET)
     Coordinate m_workCoordinateOffset;
+#endif
     Coordinate m_machineCoordinate;
-    std::stringstream m_stringStream;
+    Grbl::LineBuffer m_line;
     float m_currentFeedRate;
     float m_currentSpindleSpeed;
     Grbl::Alarm m_currentAlarm;
     Grbl::Error m_currentError;
-    std::vector<Grbl::Axis> m_limitSwitchesTriggered;
+    uint8_t m_limitSwitches;
+    uint8_t m_controlPins;
+    uint8_t m_subState;
+    int16_t m_plannerBlocksAvailable;
+    int16_t m_rxBytesAvailable;
+    uint32_t m_lineNumber;
+    uint8_t m_feedOverride;
+    uint8_t m_rapidOverride;
+    uint8_t m_spindleOverride;
+    uint8_t m_accessories;
+    Grbl::SeqLock<StatusSnapshot> m_statusSnapshot;
+    uint32_t m_lastLineReceivedAt;
+    uint16_t m_motionStatusReportInterval;
+    uint16_t m_idleStatusReportInterval;
+    uint32_t m_statusReportRequestedAt;
+    uint32_t m_statusReportRequestedAtMicros;
+    bool m_statusReportPending;
+    bool m_automaticStatusReports;
+    bool m_compactEmission;
+    float m_compactTolerance;
+    Grbl::ModalState m_modalState;
+    bool m_modalStateTracking;
+    Grbl::Ticket m_modalChangeTicket; // Last line that changed the modal state.
+    Grbl::Ticket m_parserStateTicket;
+    Grbl::PositionEstimator m_positionEstimator;
+
+    struct StatusSubscription
+    {
+        uint16_t changeMask; // 0 while the slot is free.
+        StatusListener listener;
+    };
+
+    std::array<StatusSubscription, Grbl::MAX_STATUS_SUBSCRIPTIONS> m_subscriptions;
+    StatusSnapshot m_notifiedSnapshot; // Positions as of the last Grbl::StatusChange::Position.
+    float m_positionChangeThreshold;
+
+    struct QueuedLine
+    {
+        Grbl::Ticket ticket;
+        Grbl::LineBuffer line;
+        Grbl::CommandStatus withdrawnAs; // Timeout or Cancelled once withdrawn before it was sent, else Queued.
+    };
+
+    struct InFlightLine
+    {
+        Grbl::Ticket ticket;
+        uint16_t length;
+        uint32_t sentAt;
+#if !defined(GRBL_INTERFACE_NO_STATS)
+        uint32_t sentAtMicros;
+#endif
+    };
 
-    void processBuffer();
-    void resetStringStream();
+    struct CompletedCommand
+    {
+        Grbl::Ticket ticket;
+        Grbl::CommandStatus status;
+        Grbl::Error error;
+    };
+
+    struct PendingSegment
+    {
+        Grbl::Ticket ticket;
+        size_t index;
+    };
+
+    bool m_streamingMode;
+    bool m_plannerFlowControl;
+    uint8_t m_plannerTargetDepth;
+    int16_t m_plannerCapacity;          // -1 until Grbl reported Bf:.
+    uint16_t m_plannerBlocksQueued;     // At the last status report.
+    uint16_t m_linesAcknowledgedSinceReport;
+    uint32_t m_plannerReportAt;         // Grbl::Platform::micros() of the last status report.
+    float m_plannerReportFeedRate;      // mm/min, in the last status report.
+    float m_plannerBlockLength;         // mm run per block between the last two reports, 0 until known.
+    uint8_t m_plannerLinesAhead;        // Lines in flight allowed on top of the target depth.
+    bool m_plannerHeldBack;             // Lines were held back since the last status report.
+    bool m_asynchronousMode;
+    bool m_resetPending;
+    uint16_t m_rxBufferSize;
+    uint32_t m_commandTimeout;
+    Grbl::Ticket m_lastTicket;
+    Grbl::Ticket m_lastCompletedTicket;
+    Grbl::RingBuffer<QueuedLine, Grbl::COMMAND_QUEUE_SIZE> m_queuedLines;
+    Grbl::RingBuffer<InFlightLine, Grbl::MAX_LINES_IN_FLIGHT> m_linesInFlight;
+    std::array<CompletedCommand, Grbl::COMMAND_HISTORY_SIZE> m_completedCommands; // Indexed by ticket.
+    size_t m_bytesInFlight;
+    uint32_t m_streamingStartedAt;
+    StreamingStatistics m_streamingStatistics;
+#if !defined(GRBL_INTERFACE_NO_STATS)
+    Stats m_stats;
+    uint32_t m_statsStartedAt;
+    uint32_t m_lastStatusReportAt; // Grbl::Platform::micros()
+    uint32_t m_lastStatusReportInterval;
+#endif
+    const PathSegment *m_pathSegments;
+    const Point *m_pathPoints;
+    float m_pathFeedRate;
+    bool m_pathStopOnError;
+    bool m_pathStopped;   // No further segments are queued.
+    bool m_pathCancelled;
+    Grbl::PathHandle m_pathHandle;
+    PathProgress m_pathProgress;
+    Grbl::RingBuffer<PendingSegment, Grbl::MAX_PATH_SEGMENTS_PENDING> m_pendingSegments;
+
+    void pollStatusReport();
+    void updateWhileBlocking();
+    void processLine(const char *line, size_t length);
+#if !defined(GRBL_INTERFACE_NO_READER_TASK)
+    void processReceivedLines();
+#endif
+    void processStatusReport(const char *cursor, std::string_view report);
+    void resetLine();
     void appendCommand(Grbl::Command command, char postpend = ' ');
     void appendValue(char indicator, float value, char postpend = ' ');
     void appendValue(char indicator, int value, char postpend = ' ');
-    void serializePosition(const std::vector<PositionPair> &position);
-    void send();
+    void appendSeparator(char separator);
+    [[nodiscard]] bool modalStateAcknowledged();
+    void appendModalCommand(Grbl::Command command);
+    void appendFeedRate(float feedRate);
+    [[nodiscard]] bool serializePosition(const PositionList &position);
     [[nodiscard]] bool sendCommand(Grbl::Command command, bool waitForResponse = true);
+    [[nodiscard]] bool sendModalCommand(Grbl::Command command);
     [[nodiscard]] bool sendWaitingForOkResponse(uint16_t timeout);
+    [[nodiscard]] bool submitLine(uint16_t timeout, bool waitForResponse);
+    [[nodiscard]] bool enqueueLine();
+    void dispatchQueuedLines();
+    [[nodiscard]] bool plannerDepthReached();
+    [[nodiscard]] int plannerBlocksRunSinceReport();
+    [[nodiscard]] int plannerTargetDepth();
+    [[nodiscard]] int plannerLinesAheadLimit();
+    void updatePlannerDepth();
+    void updatePositionEstimate(Grbl::MachineState machineState, Grbl::CoordinateMode coordinateMode,
+                                uint32_t requestedAt);
+    void transmit(const Grbl::LineBuffer &line);
+    void checkCommandTimeout();
+    void acknowledgeLine(Grbl::Error error);
+    void completeCommand(Grbl::Ticket ticket, Grbl::CommandStatus status, Grbl::Error error);
+    void cancelLinesInFlight();
+    [[nodiscard]] Grbl::PathHandle startPath(const PathSegment *segments, const Point *points, size_t count,
+                                             float feedRate, bool stopOnError);
+    void feedPath();
+    void appendPathSegment(size_t index);
+    void completePathSegment(Grbl::Ticket ticket, Grbl::CommandStatus status, Grbl::Error error);
+    void failPathSegment(size_t index, Grbl::CommandStatus status, Grbl::Error error);
+    void finishPath();
 
-    std::function<void(bool)> onOkResponseReceived;
+#if !defined(GRBL_INTERFACE_NO_STATS)
+    void recordStatusReport();
+#endif
 
-    void extractPosition(const char *positionString, Coordinate *positionArray);
+    void extractPosition(const char *&cursor, Coordinate &position);
+    // receivedAt stays at the last status report when an error or alarm is republished.
+    StatusSnapshot publishStatusSnapshot(Grbl::CoordinateMode coordinateMode, uint32_t receivedAt);
+    void notifyStatusChanges(const StatusSnapshot &snapshot, uint16_t events = 0);
+    [[nodiscard]] uint16_t statusChanges(const StatusSnapshot &snapshot) const;
+#if !defined(GRBL_INTERFACE_NO_WORK_COORDINATE_OFFSET)
     [[nodiscard]] float toWorkCoordinate(float machineCoordinate, float offset);
     [[nodiscard]] float toMachineCoordinate(float workCoordinate, float offset);
+#endif
 };
\ No newline at end of file
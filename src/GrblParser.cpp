@@ -0,0 +1,135 @@
+#include "GrblParser.h"
+
+#include <array>
+
+namespace
+{
+    constexpr auto VALUE_SEPARATOR = ',';
+    constexpr auto FIELD_SEPARATOR = '|';
+    constexpr auto STATUS_REPORT_END = '>';
+    constexpr auto MAX_FRACTION_DIGITS = 8;
+
+    constexpr std::array<float, MAX_FRACTION_DIGITS + 1> powersOfTen = {1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f};
+}
+
+bool Grbl::Parser::isDigit(const char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+bool Grbl::Parser::parseFloat(const char *&cursor, float &value)
+{
+    auto c = cursor;
+    const auto negative = *c == '-';
+
+    if (negative || *c == '+')
+    {
+        c++;
+    }
+
+    auto hasDigits = false;
+    float integerPart = 0;
+
+    while (isDigit(*c))
+    {
+        integerPart = integerPart * 10 + (*c - '0');
+        hasDigits = true;
+        c++;
+    }
+
+    uint32_t fractionPart = 0;
+    auto fractionDigits = 0;
+
+    if (*c == '.')
+    {
+        c++;
+
+        while (isDigit(*c))
+        {
+            // Digits beyond float resolution are consumed but ignored.
+            if (fractionDigits < MAX_FRACTION_DIGITS)
+            {
+                fractionPart = fractionPart * 10 + (*c - '0');
+                fractionDigits++;
+            }
+
+            hasDigits = true;
+            c++;
+        }
+    }
+
+    if (!hasDigits)
+    {
+        return false;
+    }
+
+    const auto result = integerPart + static_cast<float>(fractionPart) / powersOfTen[fractionDigits];
+    value = negative ? -result : result;
+    cursor = c;
+    return true;
+}
+
+bool Grbl::Parser::parseUnsigned(const char *&cursor, uint32_t &value)
+{
+    if (!isDigit(*cursor))
+    {
+        return false;
+    }
+
+    uint32_t result = 0;
+
+    while (isDigit(*cursor))
+    {
+        result = result * 10 + (*cursor - '0');
+        cursor++;
+    }
+
+    value = result;
+    return true;
+}
+
+size_t Grbl::Parser::parseValues(const char *&cursor, float *values, size_t maxValues)
+{
+    size_t count = 0;
+
+    while (count < maxValues && parseFloat(cursor, values[count]))
+    {
+        count++;
+
+        if (*cursor != VALUE_SEPARATOR)
+        {
+            break;
+        }
+
+        cursor++;
+    }
+
+    return count;
+}
+
+bool Grbl::Parser::consume(const char *&cursor, const char *literal)
+{
+    auto c = cursor;
+
+    while (*literal != '\0')
+    {
+        if (*c != *literal)
+        {
+            return false;
+        }
+
+        c++;
+        literal++;
+    }
+
+    cursor = c;
+    return true;
+}
+
+void Grbl::Parser::skipField(const char *&cursor)
+{
+    while (*cursor != '\0' && *cursor != FIELD_SEPARATOR && *cursor != STATUS_REPORT_END)
+    {
+        cursor++;
+    }
+}
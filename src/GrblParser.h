@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Grbl
+{
+    // Allocation-free tokenizer helpers used to walk Grbl responses in a single pass.
+    // All functions operate on null-terminated strings and advance the cursor past what they consumed.
+    namespace Parser
+    {
+        [[nodiscard]] bool isDigit(char c);
+
+        // Parses a decimal number such as "-12.345". Exponents are not supported as Grbl never emits them.
+        [[nodiscard]] bool parseFloat(const char *&cursor, float &value);
+        [[nodiscard]] bool parseUnsigned(const char *&cursor, uint32_t &value);
+
+        // Parses up to maxValues comma separated numbers, returning how many were written to values.
+        size_t parseValues(const char *&cursor, float *values, size_t maxValues);
+
+        // Advances the cursor past literal if the text at cursor starts with it.
+        [[nodiscard]] bool consume(const char *&cursor, const char *literal);
+
+        // Advances the cursor to the next status report field separator or terminator.
+        void skipField(const char *&cursor);
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace Grbl
+{
+    // Byte stream connecting the interface to a Grbl controller, e.g. a UART or a pseudo terminal.
+    class ByteStream
+    {
+    public:
+        virtual ~ByteStream() = default;
+
+        [[nodiscard]] virtual int available() = 0;
+        [[nodiscard]] virtual int read() = 0;
+        virtual size_t write(const uint8_t *data, size_t length) = 0;
+
+        size_t write(uint8_t byte)
+        {
+            return write(&byte, 1);
+        }
+
+        size_t write(const char *text)
+        {
+            return write(reinterpret_cast<const uint8_t *>(text), strlen(text));
+        }
+    };
+
+    // Sequential data source, e.g. a G-code file.
+    class ByteSource
+    {
+    public:
+        virtual ~ByteSource() = default;
+
+        // Returns 0 once the source is exhausted.
+        [[nodiscard]] virtual size_t read(uint8_t *buffer, size_t length) = 0;
+
+        // Total size in bytes, 0 if unknown.
+        [[nodiscard]] virtual size_t size()
+        {
+            return 0;
+        }
+    };
+
+    // Sequential data sink, e.g. a log file.
+    class ByteSink
+    {
+    public:
+        virtual ~ByteSink() = default;
+
+        virtual size_t write(const uint8_t *data, size_t length) = 0;
+        virtual void flush()
+        {
+        }
+    };
+
+    namespace Platform
+    {
+        // Monotonic clock, wrapping around like Arduino's millis()/micros().
+        [[nodiscard]] uint32_t millis();
+        [[nodiscard]] uint32_t micros();
+
+        // Suspends the calling task or thread, letting others run on its core.
+        void sleep(uint32_t micros);
+
+        void log(const char *message);
+    }
+}
+
+#if defined(GRBL_INTERFACE_LOGGING)
+#define GRBL_LOG(message) Grbl::Platform::log(message)
+#else
+#define GRBL_LOG(message)
+#endif
+
+#if defined(ARDUINO)
+#include "GrblPlatformArduino.h"
+#else
+#include "GrblPlatformPosix.h"
+#endif
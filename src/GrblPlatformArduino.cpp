@@ -0,0 +1,144 @@
+#if defined(ARDUINO)
+
+#include "GrblPlatform.h"
+
+namespace
+{
+    constexpr auto TASK_STACK_SIZE = 4096;
+    constexpr auto TASK_PRIORITY = 2; // Above the Arduino loop task.
+}
+
+Grbl::ArduinoStream::ArduinoStream()
+    : m_stream(nullptr)
+{
+}
+
+Grbl::ArduinoStream::ArduinoStream(::Stream &stream)
+    : m_stream(&stream)
+{
+}
+
+int Grbl::ArduinoStream::available()
+{
+    return m_stream->available();
+}
+
+int Grbl::ArduinoStream::read()
+{
+    return m_stream->read();
+}
+
+size_t Grbl::ArduinoStream::write(const uint8_t *data, size_t length)
+{
+    return m_stream->write(data, length);
+}
+
+Grbl::FileSource::FileSource(fs::File &file)
+    : m_file(&file)
+{
+}
+
+size_t Grbl::FileSource::read(uint8_t *buffer, size_t length)
+{
+    return m_file->read(buffer, length);
+}
+
+size_t Grbl::FileSource::size()
+{
+    return m_file->size();
+}
+
+Grbl::FileSink::FileSink(fs::File &file)
+    : m_file(&file)
+{
+}
+
+size_t Grbl::FileSink::write(const uint8_t *data, size_t length)
+{
+    return m_file->write(data, length);
+}
+
+void Grbl::FileSink::flush()
+{
+    m_file->flush();
+}
+
+bool Grbl::Task::start(Function function, void *argument, const char *name, int core)
+{
+    m_function = function;
+    m_argument = argument;
+    m_finished = false;
+    return xTaskCreatePinnedToCore(run, name, TASK_STACK_SIZE, this, TASK_PRIORITY, &m_handle, core) == pdPASS;
+}
+
+void Grbl::Task::join()
+{
+    if (m_handle == nullptr)
+    {
+        return;
+    }
+
+    while (!m_finished)
+    {
+        vTaskDelay(1);
+    }
+
+    m_handle = nullptr;
+}
+
+void Grbl::Task::run(void *task)
+{
+    const auto self = static_cast<Task *>(task);
+    self->m_function(self->m_argument);
+    self->m_finished = true;
+    vTaskDelete(nullptr);
+}
+
+Grbl::Mutex::Mutex()
+    : m_storage{},
+      m_handle(xSemaphoreCreateMutexStatic(&m_storage))
+{
+}
+
+Grbl::Mutex::~Mutex()
+{
+    vSemaphoreDelete(m_handle);
+}
+
+void Grbl::Mutex::lock()
+{
+    xSemaphoreTake(m_handle, portMAX_DELAY);
+}
+
+void Grbl::Mutex::unlock()
+{
+    xSemaphoreGive(m_handle);
+}
+
+bool Grbl::Mutex::tryLock()
+{
+    return xSemaphoreTake(m_handle, 0) == pdTRUE;
+}
+
+uint32_t Grbl::Platform::millis()
+{
+    return ::millis();
+}
+
+uint32_t Grbl::Platform::micros()
+{
+    return ::micros();
+}
+
+void Grbl::Platform::sleep(uint32_t micros)
+{
+    const auto ticks = pdMS_TO_TICKS(micros / 1000);
+    vTaskDelay(ticks > 0 ? ticks : 1);
+}
+
+void Grbl::Platform::log(const char *message)
+{
+    Serial.println(message);
+}
+
+#endif
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "Arduino.h"
+#include "FS.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#include <atomic>
+
+namespace Grbl
+{
+    class ArduinoStream : public ByteStream
+    {
+    public:
+        ArduinoStream();
+        explicit ArduinoStream(::Stream &stream);
+
+        [[nodiscard]] int available() override;
+        [[nodiscard]] int read() override;
+        size_t write(const uint8_t *data, size_t length) override;
+
+    private:
+        ::Stream *m_stream;
+    };
+
+    // File on LittleFS, SPIFFS or an SD card.
+    class FileSource : public ByteSource
+    {
+    public:
+        explicit FileSource(fs::File &file);
+
+        [[nodiscard]] size_t read(uint8_t *buffer, size_t length) override;
+        [[nodiscard]] size_t size() override;
+
+    private:
+        fs::File *m_file;
+    };
+
+    // File on LittleFS, SPIFFS or an SD card, opened for writing or appending.
+    class FileSink : public ByteSink
+    {
+    public:
+        explicit FileSink(fs::File &file);
+
+        size_t write(const uint8_t *data, size_t length) override;
+        void flush() override;
+
+    private:
+        fs::File *m_file;
+    };
+
+    // FreeRTOS mutex. Unlike a spin lock it lets the holder run when a task of higher priority waits for it on
+    // the same core, and lends it that priority meanwhile.
+    class Mutex
+    {
+    public:
+        Mutex();
+        ~Mutex();
+
+        Mutex(const Mutex &) = delete;
+        Mutex &operator=(const Mutex &) = delete;
+
+        void lock();
+        void unlock();
+        [[nodiscard]] bool tryLock();
+
+    private:
+        StaticSemaphore_t m_storage;
+        SemaphoreHandle_t m_handle;
+    };
+
+    // FreeRTOS task pinned to one of the ESP32 cores.
+    class Task
+    {
+    public:
+        using Function = void (*)(void *argument);
+
+        [[nodiscard]] bool start(Function function, void *argument, const char *name, int core);
+        void join();
+
+    private:
+        TaskHandle_t m_handle = nullptr;
+        Function m_function = nullptr;
+        void *m_argument = nullptr;
+        std::atomic<bool> m_finished{false};
+
+        static void run(void *task);
+    };
+}
@@ -0,0 +1,276 @@
+#if !defined(ARDUINO)
+
+#include "GrblPlatform.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <utility>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace
+{
+    constexpr auto WRITE_TIMEOUT_MS = 1000; // A device that takes no byte for this long is gone.
+
+    [[nodiscard]] speed_t toSpeed(uint32_t baudRate)
+    {
+        switch (baudRate)
+        {
+        case 9600:
+            return B9600;
+        case 19200:
+            return B19200;
+        case 38400:
+            return B38400;
+        case 57600:
+            return B57600;
+        case 230400:
+            return B230400;
+        case 460800:
+            return B460800;
+        case 921600:
+            return B921600;
+        default:
+            return B115200;
+        }
+    }
+
+    std::function<uint64_t()> clockSource;
+
+    [[nodiscard]] uint64_t monotonicMicros()
+    {
+        if (clockSource)
+        {
+            return clockSource();
+        }
+
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return static_cast<uint64_t>(now.tv_sec) * 1000000 + now.tv_nsec / 1000;
+    }
+}
+
+Grbl::PosixStream::PosixStream(int inputFd, int outputFd)
+    : m_inputFd(inputFd),
+      m_outputFd(outputFd),
+      m_ownsFd(false)
+{
+}
+
+Grbl::PosixStream::PosixStream(const char *serialDevice, uint32_t baudRate)
+    : m_inputFd(open(serialDevice, O_RDWR | O_NOCTTY | O_NONBLOCK)),
+      m_outputFd(m_inputFd),
+      m_ownsFd(true)
+{
+    termios options;
+
+    if (m_inputFd < 0 || tcgetattr(m_inputFd, &options) != 0)
+    {
+        return;
+    }
+
+    cfmakeraw(&options);
+    cfsetispeed(&options, toSpeed(baudRate));
+    cfsetospeed(&options, toSpeed(baudRate));
+    options.c_cflag |= CLOCAL | CREAD;
+    tcsetattr(m_inputFd, TCSANOW, &options);
+}
+
+Grbl::PosixStream::~PosixStream()
+{
+    if (m_ownsFd && m_inputFd >= 0)
+    {
+        close(m_inputFd);
+    }
+}
+
+bool Grbl::PosixStream::isOpen() const
+{
+    return m_inputFd >= 0 && m_outputFd >= 0;
+}
+
+int Grbl::PosixStream::available()
+{
+    int count = 0;
+
+    if (ioctl(m_inputFd, FIONREAD, &count) != 0)
+    {
+        return 0;
+    }
+
+    return count;
+}
+
+int Grbl::PosixStream::read()
+{
+    uint8_t byte;
+
+    if (::read(m_inputFd, &byte, 1) != 1)
+    {
+        return -1;
+    }
+
+    return byte;
+}
+
+size_t Grbl::PosixStream::write(const uint8_t *data, size_t length)
+{
+    size_t written = 0;
+
+    while (written < length)
+    {
+        const auto result = ::write(m_outputFd, data + written, length - written);
+
+        if (result > 0)
+        {
+            written += result;
+            continue;
+        }
+
+        if (result < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        // The device is opened non-blocking, so a full output buffer has to be waited out rather than
+        // dropping the rest of the line.
+        if (result < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+        {
+            fprintf(stderr, "PosixStream: write failed after %zu of %zu bytes: %s\n", written, length,
+                    strerror(errno));
+            break;
+        }
+
+        pollfd output = {m_outputFd, POLLOUT, 0};
+        int ready;
+
+        do
+        {
+            ready = poll(&output, 1, WRITE_TIMEOUT_MS);
+        } while (ready < 0 && errno == EINTR);
+
+        if (ready <= 0 || (output.revents & (POLLERR | POLLHUP | POLLNVAL)) != 0)
+        {
+            fprintf(stderr, "PosixStream: write failed after %zu of %zu bytes: %s\n", written, length,
+                    ready == 0 ? "timed out" : ready < 0 ? strerror(errno) : "device error");
+            break;
+        }
+    }
+
+    return written;
+}
+
+Grbl::IstreamSource::IstreamSource(std::istream &stream)
+    : m_stream(&stream)
+{
+}
+
+size_t Grbl::IstreamSource::read(uint8_t *buffer, size_t length)
+{
+    m_stream->read(reinterpret_cast<char *>(buffer), length);
+    return m_stream->gcount();
+}
+
+size_t Grbl::IstreamSource::size()
+{
+    const auto position = m_stream->tellg();
+
+    if (position < 0 || !m_stream->seekg(0, std::ios::end))
+    {
+        m_stream->clear();
+        return 0;
+    }
+
+    const auto end = m_stream->tellg();
+    m_stream->seekg(position);
+    return end < 0 ? 0 : static_cast<size_t>(end);
+}
+
+Grbl::OstreamSink::OstreamSink(std::ostream &stream)
+    : m_stream(&stream)
+{
+}
+
+size_t Grbl::OstreamSink::write(const uint8_t *data, size_t length)
+{
+    m_stream->write(reinterpret_cast<const char *>(data), length);
+    return m_stream->good() ? length : 0;
+}
+
+void Grbl::OstreamSink::flush()
+{
+    m_stream->flush();
+}
+
+bool Grbl::Task::start(Function function, void *argument, const char *name, int core)
+{
+    m_thread = std::thread(function, argument);
+    pthread_setname_np(m_thread.native_handle(), name);
+
+    if (core >= 0 && core < static_cast<int>(std::thread::hardware_concurrency()))
+    {
+        cpu_set_t cores;
+        CPU_ZERO(&cores);
+        CPU_SET(core, &cores);
+        pthread_setaffinity_np(m_thread.native_handle(), sizeof(cores), &cores);
+    }
+
+    return true;
+}
+
+void Grbl::Task::join()
+{
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+}
+
+void Grbl::Mutex::lock()
+{
+    m_mutex.lock();
+}
+
+void Grbl::Mutex::unlock()
+{
+    m_mutex.unlock();
+}
+
+bool Grbl::Mutex::tryLock()
+{
+    return m_mutex.try_lock();
+}
+
+uint32_t Grbl::Platform::millis()
+{
+    return static_cast<uint32_t>(monotonicMicros() / 1000);
+}
+
+uint32_t Grbl::Platform::micros()
+{
+    return static_cast<uint32_t>(monotonicMicros());
+}
+
+void Grbl::Platform::setClockSource(std::function<uint64_t()> microsSource)
+{
+    clockSource = std::move(microsSource);
+}
+
+void Grbl::Platform::sleep(uint32_t micros)
+{
+    std::this_thread::sleep_for(std::chrono::microseconds(micros));
+}
+
+void Grbl::Platform::log(const char *message)
+{
+    fprintf(stderr, "%s\n", message);
+}
+
+#endif
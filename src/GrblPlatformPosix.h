@@ -0,0 +1,89 @@
+#pragma once
+
+#include <functional>
+#include <istream>
+#include <mutex>
+#include <ostream>
+#include <thread>
+
+namespace Grbl
+{
+    // File descriptor backed stream: a serial device, a pipe pair or a pseudo terminal.
+    class PosixStream : public ByteStream
+    {
+    public:
+        PosixStream(int inputFd, int outputFd);
+        PosixStream(const char *serialDevice, uint32_t baudRate);
+        ~PosixStream() override;
+
+        [[nodiscard]] bool isOpen() const;
+
+        [[nodiscard]] int available() override;
+        [[nodiscard]] int read() override;
+        size_t write(const uint8_t *data, size_t length) override;
+
+    private:
+        int m_inputFd;
+        int m_outputFd;
+        bool m_ownsFd;
+    };
+
+    // Any std::istream, e.g. a std::ifstream opened on a G-code file.
+    class IstreamSource : public ByteSource
+    {
+    public:
+        explicit IstreamSource(std::istream &stream);
+
+        [[nodiscard]] size_t read(uint8_t *buffer, size_t length) override;
+        [[nodiscard]] size_t size() override;
+
+    private:
+        std::istream *m_stream;
+    };
+
+    // Any std::ostream, e.g. a std::ofstream opened in binary mode.
+    class OstreamSink : public ByteSink
+    {
+    public:
+        explicit OstreamSink(std::ostream &stream);
+
+        size_t write(const uint8_t *data, size_t length) override;
+        void flush() override;
+
+    private:
+        std::ostream *m_stream;
+    };
+
+    // std::thread standing in for a FreeRTOS task, so threaded modes can be exercised on the host.
+    // A negative core leaves the thread to the scheduler.
+    class Task
+    {
+    public:
+        using Function = void (*)(void *argument);
+
+        [[nodiscard]] bool start(Function function, void *argument, const char *name, int core);
+        void join();
+
+    private:
+        std::thread m_thread;
+    };
+
+    // std::mutex standing in for a FreeRTOS mutex.
+    class Mutex
+    {
+    public:
+        void lock();
+        void unlock();
+        [[nodiscard]] bool tryLock();
+
+    private:
+        std::mutex m_mutex;
+    };
+
+    namespace Platform
+    {
+        // Replaces the monotonic clock, e.g. with the virtual time of a simulated controller.
+        // Passing an empty function restores the system clock.
+        void setClockSource(std::function<uint64_t()> microsSource);
+    }
+}
@@ -0,0 +1,71 @@
+#include "Histogram.h"
+
+void Grbl::Histogram::clear()
+{
+    *this = {};
+}
+
+void Grbl::Histogram::add(uint32_t value)
+{
+    size_t index = 0;
+
+    for (auto remaining = value; remaining != 0 && index < HISTOGRAM_BUCKETS - 1; remaining >>= 1)
+    {
+        index++;
+    }
+
+    m_buckets[index]++;
+    m_minimum = m_count == 0 || value < m_minimum ? value : m_minimum;
+    m_maximum = value > m_maximum ? value : m_maximum;
+    m_sum += value;
+    m_count++;
+}
+
+uint32_t Grbl::Histogram::count() const
+{
+    return m_count;
+}
+
+uint32_t Grbl::Histogram::minimum() const
+{
+    return m_minimum;
+}
+
+uint32_t Grbl::Histogram::maximum() const
+{
+    return m_maximum;
+}
+
+uint32_t Grbl::Histogram::mean() const
+{
+    return m_count == 0 ? 0 : static_cast<uint32_t>(m_sum / m_count);
+}
+
+uint32_t Grbl::Histogram::percentile(float fraction) const
+{
+    const auto target = static_cast<uint64_t>(fraction * m_count + 0.5f);
+    uint64_t counted = 0;
+
+    for (size_t i = 0; i < HISTOGRAM_BUCKETS; i++)
+    {
+        counted += m_buckets[i];
+
+        if (counted >= target && counted > 0)
+        {
+            const auto bound = bucketUpperBound(i);
+            return bound < m_maximum ? bound : m_maximum;
+        }
+    }
+
+    return m_maximum;
+}
+
+uint32_t Grbl::Histogram::bucket(size_t index) const
+{
+    return index < HISTOGRAM_BUCKETS ? m_buckets[index] : 0;
+}
+
+uint32_t Grbl::Histogram::bucketUpperBound(size_t index)
+{
+    return index >= HISTOGRAM_BUCKETS - 1 ? UINT32_MAX : (1u << index) - 1;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Grbl
+{
+    constexpr auto HISTOGRAM_BUCKETS = 24; // Resolves up to 2^22, about 4.2 seconds in microseconds.
+
+    // Fixed-size histogram with power-of-two buckets. Bucket 0 counts zeros, bucket n the values from
+    // 2^(n-1) to 2^n - 1, and the last bucket everything above.
+    class Histogram
+    {
+    public:
+        void clear();
+        void add(uint32_t value);
+
+        [[nodiscard]] uint32_t count() const;
+        [[nodiscard]] uint32_t minimum() const;
+        [[nodiscard]] uint32_t maximum() const;
+        [[nodiscard]] uint32_t mean() const;
+        // Upper bound of the bucket holding the given fraction of the values, e.g. 0.99, capped at maximum().
+        [[nodiscard]] uint32_t percentile(float fraction) const;
+        [[nodiscard]] uint32_t bucket(size_t index) const;
+        [[nodiscard]] static uint32_t bucketUpperBound(size_t index);
+
+    private:
+        uint32_t m_buckets[HISTOGRAM_BUCKETS] = {};
+        uint32_t m_count = 0;
+        uint32_t m_minimum = 0;
+        uint32_t m_maximum = 0;
+        uint64_t m_sum = 0;
+    };
+}
@@ -0,0 +1,427 @@
+#include "JobRunner.h"
+
+namespace
+{
+    constexpr auto TASK_NAME = "grbl-job";
+    constexpr auto IDLE_MICROS = 1000;
+}
+
+JobRunner::JobRunner(GrblInterface &grbl)
+    : m_grbl(&grbl),
+      m_source(nullptr),
+      m_state(JobState::Idle),
+      m_stopOnError(true),
+      m_restoreStreamingMode(false),
+      m_restoreAsynchronousMode(false),
+      m_readAheadTaskRunning(false),
+      m_stopReading(false),
+      m_sourceExhausted(false),
+      m_bytesRead(0),
+      m_chunkOffset(0),
+      m_lineReady(false),
+      m_inComment(false),
+      m_inLineComment(false),
+      m_sourceLine(0),
+      m_bytesConsumed(0),
+      m_progress{},
+      m_runningMillis(0),
+      m_resumedAt(0)
+{
+}
+
+JobRunner::~JobRunner()
+{
+    stopReadAheadTask();
+}
+
+bool JobRunner::start(Grbl::ByteSource &source, bool readAheadTask)
+{
+    if (m_state == JobState::Running || m_state == JobState::Paused)
+    {
+        return false;
+    }
+
+    while (m_chunks.front() != nullptr)
+    {
+        m_chunks.pop();
+    }
+
+    m_source = &source;
+    m_stopReading = false;
+    m_sourceExhausted = false;
+    m_bytesRead = 0;
+    m_chunkOffset = 0;
+    m_line.clear();
+    m_lineReady = false;
+    m_inComment = false;
+    m_inLineComment = false;
+    m_sourceLine = 0;
+    m_bytesConsumed = 0;
+    m_pendingLines.clear();
+    m_progress = {};
+    m_progress.totalBytes = source.size();
+    m_runningMillis = 0;
+    m_resumedAt = Grbl::Platform::millis();
+
+    m_restoreStreamingMode = !m_grbl->streamingModeEnabled();
+    m_restoreAsynchronousMode = !m_grbl->asynchronousModeEnabled();
+
+    if (m_restoreStreamingMode)
+    {
+        m_grbl->setStreamingMode(true);
+    }
+
+    m_grbl->setAsynchronousMode(true);
+
+    if (readAheadTask)
+    {
+        m_readAheadTaskRunning = m_readAheadTask.start(runReadAhead, this, TASK_NAME, Grbl::READER_TASK_CORE);
+
+        if (!m_readAheadTaskRunning)
+        {
+            restoreModes();
+            return false;
+        }
+    }
+
+    m_state = JobState::Running;
+    return true;
+}
+
+void JobRunner::pause()
+{
+    if (m_state != JobState::Running)
+    {
+        return;
+    }
+
+    (void)m_grbl->pause();
+    m_runningMillis = runningMillis();
+    m_state = JobState::Paused;
+}
+
+void JobRunner::resume()
+{
+    if (m_state != JobState::Paused)
+    {
+        return;
+    }
+
+    (void)m_grbl->resume();
+    m_resumedAt = Grbl::Platform::millis();
+    m_state = JobState::Running;
+}
+
+void JobRunner::abort()
+{
+    if (m_state != JobState::Running && m_state != JobState::Paused)
+    {
+        return;
+    }
+
+    // Grbl drops its buffers and the interface cancels everything still queued.
+    (void)m_grbl->softReset();
+    m_pendingLines.clear();
+    finish(JobState::Aborted);
+}
+
+void JobRunner::setStopOnError(bool enabled)
+{
+    m_stopOnError = enabled;
+}
+
+void JobRunner::update()
+{
+    m_grbl->update();
+
+    if (m_state != JobState::Running && m_state != JobState::Paused)
+    {
+        return;
+    }
+
+    collectCompletions();
+
+    if (m_state != JobState::Running)
+    {
+        return;
+    }
+
+    sendLines();
+
+    if (!m_readAheadTaskRunning && fillChunk())
+    {
+        sendLines();
+    }
+
+    if (m_state == JobState::Running &&
+        m_sourceExhausted &&
+        m_chunks.empty() &&
+        !m_lineReady &&
+        m_line.length() == 0 &&
+        m_pendingLines.empty())
+    {
+        finish(JobState::Completed);
+    }
+}
+
+JobState JobRunner::state()
+{
+    return m_state;
+}
+
+JobProgress JobRunner::progress()
+{
+    auto progress = m_progress;
+    progress.bytesRead = m_bytesRead;
+
+    const auto elapsed = runningMillis();
+
+    if (elapsed > 0)
+    {
+        progress.linesPerSecond = progress.linesCompleted * 1000.0f / elapsed;
+    }
+
+    // The number of lines is unknown up front, so it is extrapolated from the bytes parsed so far.
+    if (progress.totalBytes > 0 && m_bytesConsumed > 0 && progress.linesPerSecond > 0)
+    {
+        const auto estimatedLines = static_cast<float>(progress.linesSent) * progress.totalBytes / m_bytesConsumed;
+        const auto remainingLines = estimatedLines > progress.linesCompleted ? estimatedLines - progress.linesCompleted : 0;
+        progress.remainingMillis = static_cast<uint32_t>(remainingLines * 1000 / progress.linesPerSecond);
+    }
+
+    return progress;
+}
+
+// --------------------------------------------------------------------------------------------------
+// Private methods
+// --------------------------------------------------------------------------------------------------
+
+void JobRunner::runReadAhead(void *runner)
+{
+    static_cast<JobRunner *>(runner)->readAhead();
+}
+
+void JobRunner::readAhead()
+{
+    while (!m_stopReading && !m_sourceExhausted)
+    {
+        if (!fillChunk())
+        {
+            Grbl::Platform::sleep(IDLE_MICROS);
+        }
+    }
+}
+
+bool JobRunner::fillChunk()
+{
+    if (m_sourceExhausted)
+    {
+        return false;
+    }
+
+    const auto chunk = m_chunks.beginPush();
+
+    if (chunk == nullptr)
+    {
+        return false;
+    }
+
+    chunk->length = m_source->read(chunk->data, sizeof(chunk->data));
+
+    if (chunk->length == 0)
+    {
+        m_sourceExhausted = true;
+        return false;
+    }
+
+    m_bytesRead += chunk->length;
+    m_chunks.endPush();
+    return true;
+}
+
+bool JobRunner::nextLine()
+{
+    for (auto chunk = m_chunks.front(); chunk != nullptr; chunk = m_chunks.front())
+    {
+        while (m_chunkOffset < chunk->length)
+        {
+            const char c = chunk->data[m_chunkOffset++];
+            m_bytesConsumed++;
+
+            if (c == '\n')
+            {
+                m_sourceLine++;
+                m_inComment = false;
+                m_inLineComment = false;
+
+                if (m_line.length() > 0)
+                {
+                    return true;
+                }
+
+                continue;
+            }
+
+            if (m_inLineComment || c == '\r')
+            {
+                continue;
+            }
+
+            if (m_inComment)
+            {
+                m_inComment = c != ')';
+                continue;
+            }
+
+            switch (c)
+            {
+            case '(':
+            {
+                m_inComment = true;
+                break;
+            }
+            case ';':
+            {
+                m_inLineComment = true;
+                break;
+            }
+            case ' ':
+            case '\t':
+            case '%': // Program start and end markers.
+            {
+                break;
+            }
+            default:
+            {
+                m_line.append(c);
+                break;
+            }
+            }
+        }
+
+        m_chunks.pop();
+        m_chunkOffset = 0;
+    }
+
+    // The last line of a program does not need a line terminator.
+    if (m_sourceExhausted && m_chunks.empty() && m_line.length() > 0)
+    {
+        m_sourceLine++;
+        return true;
+    }
+
+    return false;
+}
+
+void JobRunner::sendLines()
+{
+    while (m_grbl->commandsQueued() < Grbl::COMMAND_QUEUE_SIZE && !m_pendingLines.full())
+    {
+        if (!m_lineReady)
+        {
+            m_lineReady = nextLine();
+
+            if (!m_lineReady)
+            {
+                return;
+            }
+        }
+
+        // Grbl would reject the line anyway, and the program cannot continue without it.
+        if (m_line.overflowed())
+        {
+            m_progress.failedLine = m_sourceLine;
+            (void)m_grbl->pause();
+            finish(JobState::Failed);
+            return;
+        }
+
+        const auto ticket = m_grbl->sendLine(m_line.c_str());
+
+        if (ticket == Grbl::INVALID_TICKET)
+        {
+            return;
+        }
+
+        (void)m_pendingLines.push({ticket, m_sourceLine});
+        m_progress.linesSent++;
+        m_line.clear();
+        m_lineReady = false;
+    }
+}
+
+void JobRunner::collectCompletions()
+{
+    const auto completed = m_grbl->lastCompletedTicket();
+    PendingLine line;
+
+    while (!m_pendingLines.empty() && m_pendingLines.front().ticket <= completed)
+    {
+        (void)m_pendingLines.pop(line);
+        m_progress.linesCompleted++;
+
+        if (m_grbl->commandStatus(line.ticket) == Grbl::CommandStatus::Ok)
+        {
+            continue;
+        }
+
+        m_progress.errors++;
+
+        if (m_progress.failedLine == 0)
+        {
+            m_progress.failedLine = line.sourceLine;
+        }
+
+        if (m_stopOnError && m_state != JobState::Failed)
+        {
+            // Grbl keeps executing what it has buffered, so hold the motion until the caller aborts.
+            (void)m_grbl->pause();
+            finish(JobState::Failed);
+        }
+    }
+}
+
+void JobRunner::finish(JobState state)
+{
+    stopReadAheadTask();
+    restoreModes();
+    m_runningMillis = runningMillis();
+    m_state = state;
+}
+
+void JobRunner::stopReadAheadTask()
+{
+    if (!m_readAheadTaskRunning)
+    {
+        return;
+    }
+
+    m_stopReading = true;
+    m_readAheadTask.join();
+    m_readAheadTaskRunning = false;
+}
+
+void JobRunner::restoreModes()
+{
+    if (m_restoreStreamingMode)
+    {
+        m_grbl->setStreamingMode(false);
+        m_restoreStreamingMode = false;
+    }
+
+    if (m_restoreAsynchronousMode)
+    {
+        m_grbl->setAsynchronousMode(false);
+        m_restoreAsynchronousMode = false;
+    }
+}
+
+uint32_t JobRunner::runningMillis()
+{
+    if (m_state != JobState::Running)
+    {
+        return m_runningMillis;
+    }
+
+    return m_runningMillis + (Grbl::Platform::millis() - m_resumedAt);
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "GrblInterface.h"
+#include "SpscRingBuffer.h"
+
+#include <atomic>
+
+namespace Grbl
+{
+    constexpr auto READ_AHEAD_CHUNK_SIZE = 512;
+    constexpr auto READ_AHEAD_CHUNKS = 2; // Double buffered: one chunk is parsed while the next is read.
+    constexpr auto MAX_JOB_LINES_PENDING = COMMAND_QUEUE_SIZE + MAX_LINES_IN_FLIGHT;
+}
+
+enum class JobState
+{
+    Idle,
+    Running,
+    Paused,
+    Completed,
+    Aborted,
+    Failed // A line was rejected by Grbl, or could not be sent.
+};
+
+struct JobProgress
+{
+    uint32_t bytesRead;
+    uint32_t totalBytes; // 0 if the size of the source is unknown.
+    uint32_t linesSent;
+    uint32_t linesCompleted;
+    uint32_t errors;
+    uint32_t failedLine;      // Source line of the first error, 0 if none.
+    float linesPerSecond;     // Measured while running, pauses excluded.
+    uint32_t remainingMillis; // Estimated from the line rate and the bytes left, 0 if unknown.
+};
+
+// Streams a G-code program to Grbl. The source is read ahead in fixed chunks, comments and whitespace are
+// stripped, and lines are queued on the interface in asynchronous streaming mode, so memory use does not
+// depend on the size of the program. Reading either happens in update() between sends or, with
+// readAheadTask, on its own task so a slow file system never holds up the stream. The interface's
+// streaming and asynchronous modes are restored once the job has ended.
+class JobRunner
+{
+public:
+    explicit JobRunner(GrblInterface &grbl);
+    ~JobRunner();
+
+    JobRunner(const JobRunner &) = delete;
+    JobRunner &operator=(const JobRunner &) = delete;
+
+    [[nodiscard]] bool start(Grbl::ByteSource &source, bool readAheadTask = false);
+    void pause();
+    void resume();
+    void abort();
+    void setStopOnError(bool enabled);
+
+    // Services the interface as well, so it replaces GrblInterface::update() while a job runs.
+    void update();
+
+    [[nodiscard]] JobState state();
+    [[nodiscard]] JobProgress progress();
+
+private:
+    struct Chunk
+    {
+        uint16_t length;
+        uint8_t data[Grbl::READ_AHEAD_CHUNK_SIZE];
+    };
+
+    struct PendingLine
+    {
+        Grbl::Ticket ticket;
+        uint32_t sourceLine;
+    };
+
+    GrblInterface *m_grbl;
+    Grbl::ByteSource *m_source;
+    JobState m_state;
+    bool m_stopOnError;
+    bool m_restoreStreamingMode; // The interface was not streaming before start().
+    bool m_restoreAsynchronousMode;
+
+    Grbl::SpscRingBuffer<Chunk, Grbl::READ_AHEAD_CHUNKS> m_chunks;
+    Grbl::Task m_readAheadTask;
+    bool m_readAheadTaskRunning;
+    std::atomic<bool> m_stopReading;
+    std::atomic<bool> m_sourceExhausted;
+    std::atomic<uint32_t> m_bytesRead;
+    size_t m_chunkOffset;
+
+    Grbl::LineBuffer m_line;
+    bool m_lineReady;
+    bool m_inComment;
+    bool m_inLineComment;
+    uint32_t m_sourceLine;
+    uint32_t m_bytesConsumed;
+
+    Grbl::RingBuffer<PendingLine, Grbl::MAX_JOB_LINES_PENDING> m_pendingLines;
+    JobProgress m_progress;
+    uint32_t m_runningMillis;
+    uint32_t m_resumedAt;
+
+    static void runReadAhead(void *runner);
+    void readAhead();
+    [[nodiscard]] bool fillChunk();
+    [[nodiscard]] bool nextLine();
+    void sendLines();
+    void collectCompletions();
+    void finish(JobState state);
+    void stopReadAheadTask();
+    void restoreModes();
+    [[nodiscard]] uint32_t runningMillis();
+};
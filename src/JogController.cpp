@@ -0,0 +1,481 @@
+#include "JogController.h"
+
+#if !defined(GRBL_INTERFACE_NO_JOGGING)
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    constexpr auto MICROS_PER_SECOND = 1000000.0f;
+    constexpr auto SECONDS_PER_MINUTE = 60.0f;
+    constexpr auto DISTANCE_RESOLUTION = 1000.0f; // Grbl works in micrometers.
+
+    [[nodiscard]] float length(const Coordinate &vector)
+    {
+        auto sum = 0.0f;
+
+        for (const auto value : vector)
+        {
+            sum += value * value;
+        }
+
+        return std::sqrt(sum);
+    }
+}
+
+JogController::JogController(GrblInterface &grbl, const JogConfiguration &configuration)
+    : m_grbl(&grbl),
+      m_configuration(configuration),
+      m_state(JogState::Idle),
+      m_statistics{},
+      m_velocity{},
+      m_velocitySet(false),
+      m_pendingDistance{},
+      m_distancePending(false),
+      m_restoreStreamingMode(false),
+      m_restoreAsynchronousMode(false),
+      m_queuedUntil(0),
+      m_lastSegmentAt(0),
+      m_lastPollAt(0),
+      m_inputAt(0),
+      m_awaitingMotion(false),
+      m_reportAtInput(0),
+      m_reportAtSegment(0),
+      m_stopRequestedAt(0),
+      m_reportAtStop(0),
+      m_positionAtStop{}
+{
+    m_configuration.segmentsAhead = std::max<uint8_t>(m_configuration.segmentsAhead, 1);
+}
+
+void JogController::setVelocity(const PositionList &velocity)
+{
+    Coordinate requested{};
+
+    for (const auto &[axis, feedRate] : velocity)
+    {
+        const auto index = Grbl::axisIndex(axis);
+
+        if (index >= 0)
+        {
+            requested[index] = feedRate;
+        }
+    }
+
+    const auto speed = length(requested);
+
+    if (speed < Grbl::MIN_JOG_FEED_RATE)
+    {
+        if (m_velocitySet)
+        {
+            stop();
+        }
+
+        return;
+    }
+
+    const auto scale = std::min(1.0f, m_configuration.maxFeedRate / speed);
+    auto reversed = false;
+
+    for (size_t i = 0; i < requested.size(); i++)
+    {
+        requested[i] *= scale;
+        reversed = reversed || requested[i] * m_velocity[i] < 0;
+    }
+
+    // The segments queued in the old direction would be run first, so they are cancelled.
+    if (reversed && m_state == JogState::Jogging)
+    {
+        stop();
+    }
+
+    m_velocity = requested;
+    m_velocitySet = true;
+    beginInput();
+}
+
+void JogController::addDistance(Grbl::Axis axis, float distance)
+{
+    const auto index = Grbl::axisIndex(axis);
+
+    if (m_velocitySet || distance == 0 || index < 0)
+    {
+        return;
+    }
+
+    m_pendingDistance[index] += distance;
+    m_distancePending = true;
+    beginInput();
+}
+
+void JogController::stop()
+{
+    m_velocity = {};
+    m_velocitySet = false;
+    m_pendingDistance = {};
+    m_distancePending = false;
+    m_awaitingMotion = false;
+
+    if (m_state != JogState::Jogging)
+    {
+        return;
+    }
+
+    m_grbl->cancelJog();
+    m_statistics.cancels++;
+
+    const auto snapshot = m_grbl->getStatusSnapshot();
+    m_reportAtStop = snapshot.receivedAt;
+    m_positionAtStop = snapshot.machinePosition;
+    m_stopRequestedAt = Grbl::Platform::micros();
+    m_queuedUntil = m_stopRequestedAt;
+    m_state = JogState::Stopping;
+}
+
+void JogController::update()
+{
+    m_grbl->update();
+
+    const auto now = Grbl::Platform::micros();
+    collectCompletions();
+    observeReports(now);
+
+    if (m_state != JogState::Stopping)
+    {
+        if (m_velocitySet)
+        {
+            sendVelocitySegment(now);
+        }
+        else if (m_distancePending)
+        {
+            sendHandwheelSegment(now);
+        }
+    }
+
+    pollStatusReport();
+
+    if (m_state == JogState::Idle && !m_awaitingMotion && !m_velocitySet && !m_distancePending)
+    {
+        restoreModes();
+    }
+}
+
+JogState JogController::state()
+{
+    return m_state;
+}
+
+const JogStatistics &JogController::statistics()
+{
+    return m_statistics;
+}
+
+void JogController::resetStatistics()
+{
+    m_statistics = {};
+}
+
+// --------------------------------------------------------------------------------------------------
+// Private methods
+// --------------------------------------------------------------------------------------------------
+
+void JogController::beginInput()
+{
+    if (m_state == JogState::Jogging || m_awaitingMotion)
+    {
+        return;
+    }
+
+    m_inputAt = Grbl::Platform::micros();
+    m_reportAtInput = m_grbl->getStatusSnapshot().receivedAt;
+    m_awaitingMotion = true;
+
+    // Input while stopping finds the modes switched already.
+    if (!m_grbl->streamingModeEnabled())
+    {
+        m_grbl->setStreamingMode(true);
+        m_restoreStreamingMode = true;
+    }
+
+    if (!m_grbl->asynchronousModeEnabled())
+    {
+        m_grbl->setAsynchronousMode(true);
+        m_restoreAsynchronousMode = true;
+    }
+}
+
+void JogController::restoreModes()
+{
+    if (m_restoreStreamingMode)
+    {
+        m_grbl->setStreamingMode(false);
+        m_restoreStreamingMode = false;
+    }
+
+    if (m_restoreAsynchronousMode)
+    {
+        m_grbl->setAsynchronousMode(false);
+        m_restoreAsynchronousMode = false;
+    }
+}
+
+void JogController::sendVelocitySegment(uint32_t now)
+{
+    const auto feedRate = length(m_velocity);
+    const auto speed = feedRate / SECONDS_PER_MINUTE;
+    const auto tick = m_configuration.tickMs / 1000.0f;
+
+    // Grbl plans to a stop at the end of the last segment queued, so the segments queued must at least cover
+    // the distance needed to brake from the feed rate, or it never gets there.
+    const auto segmentLength =
+        std::max(speed * tick, speed * speed / (2 * m_configuration.acceleration * m_configuration.segmentsAhead));
+    const auto duration = static_cast<uint32_t>(segmentLength / speed * MICROS_PER_SECOND);
+
+    while (roomForSegment(now, duration))
+    {
+        Coordinate distance;
+
+        for (size_t i = 0; i < distance.size(); i++)
+        {
+            distance[i] = m_velocity[i] / feedRate * segmentLength;
+        }
+
+        if (!sendSegment(distance, feedRate))
+        {
+            return;
+        }
+
+        queueMotion(now, duration);
+    }
+}
+
+void JogController::sendHandwheelSegment(uint32_t now)
+{
+    const auto tickMicros = m_configuration.tickMs * 1000u;
+
+    // The counts of a whole tick go into one segment.
+    if (m_state == JogState::Jogging && now - m_lastSegmentAt < tickMicros)
+    {
+        return;
+    }
+
+    const auto tick = m_configuration.tickMs / 1000.0f;
+    const auto maxSpeed = m_configuration.maxFeedRate / SECONDS_PER_MINUTE;
+    const auto maxLength = maxSpeed * tick * m_configuration.segmentsAhead;
+    auto distance = length(m_pendingDistance);
+
+    // Turning the wheel faster than the machine can follow must not build up motion that keeps going after
+    // the wheel stopped.
+    if (distance > maxLength)
+    {
+        for (auto &pending : m_pendingDistance)
+        {
+            pending *= maxLength / distance;
+        }
+
+        m_statistics.distanceDropped += distance - maxLength;
+    }
+
+    // Only whole micrometers are sent; the rest stays pending, so no count is lost to rounding.
+    Coordinate segment;
+
+    for (size_t i = 0; i < segment.size(); i++)
+    {
+        segment[i] = std::round(m_pendingDistance[i] * DISTANCE_RESOLUTION) / DISTANCE_RESOLUTION;
+    }
+
+    distance = length(segment);
+
+    if (distance == 0)
+    {
+        m_distancePending = false;
+        return;
+    }
+
+    const auto speed = std::min(maxSpeed, distance / tick);
+    const auto duration = static_cast<uint32_t>(distance / speed * MICROS_PER_SECOND);
+
+    if (!roomForSegment(now, duration))
+    {
+        return;
+    }
+
+    if (!sendSegment(segment, speed * SECONDS_PER_MINUTE))
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < segment.size(); i++)
+    {
+        m_pendingDistance[i] -= segment[i];
+    }
+
+    m_distancePending = length(m_pendingDistance) >= Grbl::MIN_JOG_DISTANCE;
+    queueMotion(now, duration);
+}
+
+bool JogController::sendSegment(const Coordinate &distance, float feedRate)
+{
+    m_line.clear();
+    m_line.append(Grbl::getCommand(Grbl::Command::RunJoggingMotion));
+    m_line.append(Grbl::getCommand(Grbl::Command::G91_DistanceModeIncremental));
+    m_line.append(Grbl::getCommand(Grbl::Command::G21_UnitsMillimeters));
+
+    for (size_t i = 0; i < distance.size(); i++)
+    {
+        if (std::fabs(distance[i]) >= Grbl::MIN_JOG_DISTANCE / 2)
+        {
+            m_line.append(m_grbl->getAxis(static_cast<Grbl::Axis>(i)));
+            m_line.appendShortestFloat(distance[i], Grbl::MIN_JOG_DISTANCE / 2);
+        }
+    }
+
+    m_line.append('F');
+    m_line.appendShortestFloat(feedRate, 1);
+
+    if (m_line.overflowed() || m_pendingSegments.full())
+    {
+        return false;
+    }
+
+    const auto ticket = m_grbl->sendLine(m_line.c_str());
+
+    if (ticket == Grbl::INVALID_TICKET)
+    {
+        return false;
+    }
+
+    (void)m_pendingSegments.push(ticket);
+    m_statistics.segmentsSent++;
+    m_reportAtSegment = m_grbl->getStatusSnapshot().receivedAt;
+    m_state = JogState::Jogging;
+    return true;
+}
+
+bool JogController::roomForSegment(uint32_t now, uint32_t duration)
+{
+    // Lines that wait in the interface or in Grbl's RX buffer are motion queued as well.
+    if (m_grbl->commandsQueued() > 0 || m_grbl->linesInFlight() >= m_configuration.segmentsAhead)
+    {
+        return false;
+    }
+
+    const auto queued = static_cast<int32_t>(m_queuedUntil - now);
+    return queued < static_cast<int32_t>(duration * (m_configuration.segmentsAhead - 1u)) ||
+           queued <= 0;
+}
+
+void JogController::queueMotion(uint32_t now, uint32_t duration)
+{
+    // The machine cannot run ahead of what it was given, so queued motion starts now at the earliest.
+    m_queuedUntil = (static_cast<int32_t>(m_queuedUntil - now) > 0 ? m_queuedUntil : now) + duration;
+    m_lastSegmentAt = now;
+}
+
+void JogController::collectCompletions()
+{
+    const auto completed = m_grbl->lastCompletedTicket();
+    Grbl::Ticket ticket;
+
+    while (!m_pendingSegments.empty() && m_pendingSegments.front() <= completed)
+    {
+        (void)m_pendingSegments.pop(ticket);
+
+        // E.g. error:15 once a soft limit is in the way.
+        if (m_grbl->commandStatus(ticket) == Grbl::CommandStatus::Error)
+        {
+            m_statistics.segmentsRejected++;
+        }
+    }
+}
+
+void JogController::observeReports(uint32_t now)
+{
+    const auto snapshot = m_grbl->getStatusSnapshot();
+    const auto moving = snapshot.machineState == Grbl::MachineState::Jog;
+
+    if (m_awaitingMotion && moving && snapshot.receivedAt != m_reportAtInput)
+    {
+        m_statistics.startLatency.add(now - m_inputAt);
+        m_awaitingMotion = false;
+    }
+
+    switch (m_state)
+    {
+    case JogState::Jogging:
+    {
+        // Handwheel motion ends by itself once the counts are worked off.
+        if (!m_velocitySet && !m_distancePending && m_pendingSegments.empty() && !moving &&
+            snapshot.receivedAt != m_reportAtSegment && static_cast<int32_t>(m_queuedUntil - now) <= 0)
+        {
+            m_state = JogState::Idle;
+        }
+
+        break;
+    }
+    case JogState::Stopping:
+    {
+        if (snapshot.receivedAt == m_reportAtStop)
+        {
+            break;
+        }
+
+        // A segment still in Grbl's RX buffer when the cancel arrived is started afterwards, so it is
+        // cancelled as well until every segment has been answered.
+        if (moving)
+        {
+            if (!m_pendingSegments.empty())
+            {
+                m_grbl->cancelJog();
+            }
+
+            m_reportAtStop = snapshot.receivedAt;
+            break;
+        }
+
+        if (!m_pendingSegments.empty())
+        {
+            break;
+        }
+
+        Coordinate travelled;
+
+        for (size_t i = 0; i < travelled.size(); i++)
+        {
+            travelled[i] = snapshot.machinePosition[i] - m_positionAtStop[i];
+        }
+
+        m_statistics.stopLatency.add(now - m_stopRequestedAt);
+        m_statistics.lastStopDistance = length(travelled);
+        m_statistics.maxStopDistance = std::max(m_statistics.maxStopDistance, m_statistics.lastStopDistance);
+        m_state = JogState::Idle;
+        break;
+    }
+    case JogState::Idle:
+    {
+        break;
+    }
+    }
+}
+
+void JogController::pollStatusReport()
+{
+    if (m_state == JogState::Idle && !m_awaitingMotion)
+    {
+        return;
+    }
+
+    // While motion is about to start or stop, a report is requested as soon as the last one arrived, so the
+    // latencies are measured to within a report; otherwise once per tick.
+    const auto now = Grbl::Platform::millis();
+    const auto transition = m_awaitingMotion || m_state == JogState::Stopping;
+
+    if (!m_grbl->statusReportPending() && (transition || now - m_lastPollAt >= m_configuration.tickMs))
+    {
+        (void)m_grbl->getStatusReport();
+        m_lastPollAt = now;
+    }
+}
+
+#endif
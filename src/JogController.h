@@ -0,0 +1,109 @@
+#pragma once
+
+#include "GrblInterface.h"
+
+#if !defined(GRBL_INTERFACE_NO_JOGGING)
+
+namespace Grbl
+{
+    constexpr auto DEFAULT_JOG_TICK_MS = 20;
+    constexpr auto DEFAULT_JOG_SEGMENTS_AHEAD = 2;
+    constexpr auto MIN_JOG_DISTANCE = 0.001f; // Smaller moves are carried over, Grbl would round them away.
+    constexpr auto MIN_JOG_FEED_RATE = 1.0f;  // mm/min, a joystick deflected less counts as released.
+}
+
+struct JogConfiguration
+{
+    float maxFeedRate = 3000;  // mm/min
+    float acceleration = 500;  // mm/s^2, the lowest of Grbl's $120-$122 for the axes jogged.
+    uint16_t tickMs = Grbl::DEFAULT_JOG_TICK_MS;
+    uint8_t segmentsAhead = Grbl::DEFAULT_JOG_SEGMENTS_AHEAD;
+};
+
+enum class JogState
+{
+    Idle,
+    Jogging,
+    Stopping // Jog cancel sent, waiting for Grbl to report the machine at rest.
+};
+
+struct JogStatistics
+{
+    uint32_t segmentsSent;
+    uint32_t segmentsRejected;
+    uint32_t cancels;
+    // In microseconds, as seen by the status reports, so they include up to one tick of polling.
+    Grbl::Histogram startLatency; // From the first input to a report in Jog.
+    Grbl::Histogram stopLatency;  // From stop() to a report at rest.
+    float lastStopDistance;       // mm from the last position reported before stop() to the one at rest.
+    float maxStopDistance;
+    float distanceDropped; // Handwheel motion beyond what could be queued without lagging behind.
+};
+
+// Turns joystick velocities or handwheel counts into short incremental $J= segments. A segment covers one tick
+// at the requested feed rate, but is never shorter than what Grbl needs to reach that feed rate with only
+// segmentsAhead segments queued (v^2 / (2 a segmentsAhead)). No more than segmentsAhead segments are ahead of
+// the machine at any time, so releasing the input leaves only a short stop, and stop() sends a jog cancel
+// right away. Like JobRunner it switches the interface to asynchronous streaming, and back once the jog is
+// over and no input is left.
+class JogController
+{
+public:
+    explicit JogController(GrblInterface &grbl, const JogConfiguration &configuration = {});
+
+    // Joystick: feed rate per axis in mm/min. The vector is capped at maxFeedRate. All zero releases the jog.
+    void setVelocity(const PositionList &velocity);
+    // Handwheel: distance in mm the encoder moved since the last call. Ignored while a velocity is set.
+    void addDistance(Grbl::Axis axis, float distance);
+    // Release: cancels the queued jog motion at once.
+    void stop();
+
+    // Services the interface as well, so it replaces GrblInterface::update() while jogging. Call it at least
+    // once per tick.
+    void update();
+
+    [[nodiscard]] JogState state();
+    [[nodiscard]] const JogStatistics &statistics();
+    void resetStatistics();
+
+private:
+    GrblInterface *m_grbl;
+    JogConfiguration m_configuration;
+    JogState m_state;
+    JogStatistics m_statistics;
+
+    Coordinate m_velocity; // mm/min
+    bool m_velocitySet;
+    Coordinate m_pendingDistance;
+    bool m_distancePending;
+    Grbl::LineBuffer m_line;
+    Grbl::RingBuffer<Grbl::Ticket, Grbl::COMMAND_QUEUE_SIZE> m_pendingSegments;
+
+    bool m_restoreStreamingMode; // The interface was not streaming before the input.
+    bool m_restoreAsynchronousMode;
+
+    uint32_t m_queuedUntil; // Grbl::Platform::micros() at which the segments sent run out.
+    uint32_t m_lastSegmentAt;
+    uint32_t m_lastPollAt; // Grbl::Platform::millis()
+
+    uint32_t m_inputAt; // Grbl::Platform::micros()
+    bool m_awaitingMotion;
+    uint32_t m_reportAtInput;   // StatusSnapshot::receivedAt of the last report before the input.
+    uint32_t m_reportAtSegment; // Same, before the last segment was sent.
+    uint32_t m_stopRequestedAt;
+    uint32_t m_reportAtStop; // StatusSnapshot::receivedAt of the last report before stop().
+    Coordinate m_positionAtStop;
+
+    void beginInput();
+    void restoreModes();
+    void sendVelocitySegment(uint32_t now);
+    void sendHandwheelSegment(uint32_t now);
+    [[nodiscard]] bool sendSegment(const Coordinate &distance, float feedRate);
+    [[nodiscard]] bool roomForSegment(uint32_t now, uint32_t duration);
+    void queueMotion(uint32_t now, uint32_t duration);
+    void collectCompletions();
+    void observeReports(uint32_t now);
+    void pollStatusReport();
+};
+
+#endif
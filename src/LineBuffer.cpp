@@ -0,0 +1,172 @@
+#include "LineBuffer.h"
+
+#include <array>
+#include <cmath>
+
+namespace
+{
+    constexpr auto MAX_PRECISION = 6;
+    constexpr auto MAX_FLOAT_MAGNITUDE = 18446744073709551616.0; // 2^64, the integer part must fit into uint64_t.
+    constexpr auto MAX_SHORTEST_FLOAT_MAGNITUDE = 9.2e18 / 1e6;  // Scaled by 10^MAX_PRECISION into int64_t.
+
+    constexpr std::array<uint32_t, MAX_PRECISION + 1> powersOfTen = {1, 10, 100, 1000, 10000, 100000, 1000000};
+}
+
+void Grbl::LineBuffer::clear()
+{
+    m_length = 0;
+    m_overflowed = false;
+    m_buffer[0] = '\0';
+}
+
+void Grbl::LineBuffer::append(const char c)
+{
+    if (m_length >= LINE_BUFFER_SIZE - 1)
+    {
+        m_overflowed = true;
+        return;
+    }
+
+    m_buffer[m_length++] = c;
+    m_buffer[m_length] = '\0';
+}
+
+void Grbl::LineBuffer::append(const char *text)
+{
+    while (*text != '\0')
+    {
+        append(*text++);
+    }
+}
+
+void Grbl::LineBuffer::appendInteger(int32_t value)
+{
+    if (value < 0)
+    {
+        append('-');
+    }
+
+    appendDigits(value < 0 ? -static_cast<int64_t>(value) : value, 1);
+}
+
+void Grbl::LineBuffer::appendFloat(float value, uint8_t precision)
+{
+    if (!std::isfinite(value) || std::fabs(value) >= MAX_FLOAT_MAGNITUDE)
+    {
+        m_overflowed = true;
+        return;
+    }
+
+    if (precision > MAX_PRECISION)
+    {
+        precision = MAX_PRECISION;
+    }
+
+    // Split before scaling so large values keep their fraction, then round the fraction once,
+    // so e.g. 0.9996 becomes "1.000" and -0.0001 becomes "0.000".
+    const auto scale = powersOfTen[precision];
+    const auto magnitude = std::fabs(value);
+    auto integerPart = static_cast<uint64_t>(magnitude);
+    auto fractionPart = static_cast<uint32_t>(std::lround((magnitude - integerPart) * scale));
+
+    if (fractionPart >= scale)
+    {
+        integerPart++;
+        fractionPart -= scale;
+    }
+
+    if (value < 0 && (integerPart > 0 || fractionPart > 0))
+    {
+        append('-');
+    }
+
+    appendDigits(integerPart, 1);
+
+    if (precision > 0)
+    {
+        append('.');
+        appendDigits(fractionPart, precision);
+    }
+}
+
+void Grbl::LineBuffer::appendShortestFloat(float value, float tolerance)
+{
+    if (!std::isfinite(value) || std::fabs(value) >= MAX_SHORTEST_FLOAT_MAGNITUDE)
+    {
+        m_overflowed = true;
+        return;
+    }
+
+    const double magnitude = std::fabs(value);
+    auto precision = 0;
+    auto scaled = static_cast<uint64_t>(std::llround(magnitude));
+
+    while (precision < MAX_PRECISION &&
+           std::fabs(static_cast<double>(scaled) / powersOfTen[precision] - magnitude) > tolerance)
+    {
+        precision++;
+        scaled = static_cast<uint64_t>(std::llround(magnitude * powersOfTen[precision]));
+    }
+
+    while (precision > 0 && scaled % 10 == 0)
+    {
+        precision--;
+        scaled /= 10;
+    }
+
+    if (scaled == 0)
+    {
+        append('0');
+        return;
+    }
+
+    if (value < 0)
+    {
+        append('-');
+    }
+
+    const auto scale = powersOfTen[precision];
+
+    if (scaled >= scale)
+    {
+        appendDigits(scaled / scale, 1);
+    }
+
+    if (precision > 0)
+    {
+        append('.');
+        appendDigits(scaled % scale, precision);
+    }
+}
+
+const char *Grbl::LineBuffer::c_str() const
+{
+    return m_buffer;
+}
+
+size_t Grbl::LineBuffer::length() const
+{
+    return m_length;
+}
+
+bool Grbl::LineBuffer::overflowed() const
+{
+    return m_overflowed;
+}
+
+void Grbl::LineBuffer::appendDigits(uint64_t value, uint8_t minimumDigits)
+{
+    char digits[20];
+    auto count = 0;
+
+    do
+    {
+        digits[count++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value > 0 || count < minimumDigits);
+
+    while (count > 0)
+    {
+        append(digits[--count]);
+    }
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Grbl
+{
+    constexpr auto LINE_BUFFER_SIZE = 80; // Grbl's line buffer, including the terminating null.
+
+    // Fixed-capacity G-code line builder. Appending past the capacity marks the line as overflowed
+    // instead of truncating it silently, so it can be rejected before it reaches Grbl. So do floats that are
+    // not finite or too large to be printed.
+    class LineBuffer
+    {
+    public:
+        void clear();
+        void append(char c);
+        void append(const char *text);
+        void appendInteger(int32_t value);
+        void appendFloat(float value, uint8_t precision);
+        // Fewest decimals that stay within tolerance of value, without trailing zeros or a leading "0",
+        // e.g. "10", ".5" or "-1.25".
+        void appendShortestFloat(float value, float tolerance);
+
+        [[nodiscard]] const char *c_str() const;
+        [[nodiscard]] size_t length() const;
+        [[nodiscard]] bool overflowed() const;
+
+    private:
+        char m_buffer[LINE_BUFFER_SIZE] = {};
+        size_t m_length = 0;
+        bool m_overflowed = false;
+
+        void appendDigits(uint64_t value, uint8_t minimumDigits);
+    };
+}
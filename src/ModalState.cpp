@@ -0,0 +1,331 @@
+#include "ModalState.h"
+#include "GrblParser.h"
+
+#include <cctype>
+#include <cmath>
+
+namespace
+{
+    constexpr auto COMMENT_START = '(';
+    constexpr auto COMMENT_END = ')';
+    constexpr auto LINE_COMMENT = ';';
+    constexpr auto SYSTEM_COMMAND = '$';
+    constexpr auto PARSER_STATE_END = ']';
+    constexpr auto FEED_RATE_RESOLUTION = 1000.0f; // Matches Grbl::FLOAT_PRECISION.
+}
+
+Grbl::ModalState::ModalState()
+    : m_active{},
+      m_known(0),
+      m_feedRate(0),
+      m_feedRateKnown(false)
+{
+}
+
+void Grbl::ModalState::invalidate()
+{
+    m_known = 0;
+    m_feedRateKnown = false;
+}
+
+bool Grbl::ModalState::isActive(Command command) const
+{
+    const auto active = [this, command](Group group)
+    {
+        return (m_known & (1 << group)) != 0 && m_active[group] == command;
+    };
+
+    switch (command)
+    {
+    case Command::G0_RapidPositioning:
+    case Command::G1_LinearInterpolation:
+    case Command::G2_ClockwiseCircularInterpolation:
+    case Command::G3_CounterclockwiseCircularInterpolation:
+    case Command::G38_2_Probing:
+    case Command::G38_3_Probing:
+    case Command::G38_4_Probing:
+    case Command::G38_5_Probing:
+    case Command::G80_MotionModeCancel:
+    {
+        return active(Motion);
+    }
+    case Command::G17_PlaneSelectionXY:
+    case Command::G18_PlaneSelectionZX:
+    case Command::G19_PlaneSelectionYZ:
+    {
+        return active(Plane);
+    }
+    case Command::G20_UnitsInches:
+    case Command::G21_UnitsMillimeters:
+    {
+        return active(Units);
+    }
+    case Command::G90_DistanceModeAbsolute:
+    case Command::G91_DistanceModeIncremental:
+    {
+        return active(DistanceMode);
+    }
+    case Command::G54_WorkCoordinateSystem1:
+    case Command::G55_WorkCoordinateSystem2:
+    case Command::G56_WorkCoordinateSystem3:
+    case Command::G57_WorkCoordinateSystem4:
+    case Command::G58_WorkCoordinateSystem5:
+    case Command::G59_WorkCoordinateSystem6:
+    {
+        return active(CoordinateSystem);
+    }
+    case Command::G93_FeedrateModeInverseTime:
+    case Command::G94_FeedrateModeUnitsPerMinute:
+    {
+        return active(FeedRateMode);
+    }
+    case Command::M3_SpindleControlCW:
+    case Command::M4_SpindleControlCCW:
+    case Command::M5_SpindleStop:
+    {
+        return active(Spindle);
+    }
+    case Command::M7_CoolantControlMist:
+    {
+        return active(MistCoolant);
+    }
+    case Command::M8_CoolantControlFlood:
+    {
+        return active(FloodCoolant);
+    }
+    case Command::M9_CoolantControlStop:
+    {
+        return active(MistCoolant) && active(FloodCoolant);
+    }
+    default:
+    {
+        // Non-modal commands always have to be sent.
+        return false;
+    }
+    }
+}
+
+bool Grbl::ModalState::isFeedRate(float feedRate) const
+{
+    // In inverse time mode Grbl wants an F word on every motion line.
+    return m_feedRateKnown && isActive(Command::G94_FeedrateModeUnitsPerMinute) &&
+           lroundf(feedRate * FEED_RATE_RESOLUTION) == lroundf(m_feedRate * FEED_RATE_RESOLUTION);
+}
+
+bool Grbl::ModalState::applyLine(const char *line)
+{
+    // System commands, jogging included, leave the g-code parser state alone.
+    if (*line == SYSTEM_COMMAND)
+    {
+        return false;
+    }
+
+    const auto active = m_active;
+    const auto known = m_known;
+    const auto feedRate = m_feedRate;
+    const auto feedRateKnown = m_feedRateKnown;
+
+    while (*line != '\0' && *line != LINE_COMMENT)
+    {
+        if (*line == COMMENT_START)
+        {
+            while (*line != '\0' && *line != COMMENT_END)
+            {
+                line++;
+            }
+
+            continue;
+        }
+
+        const auto letter = static_cast<char>(toupper(*line++));
+        float value;
+
+        if (letter >= 'A' && letter <= 'Z' && Grbl::Parser::parseFloat(line, value))
+        {
+            apply(letter, value);
+        }
+    }
+
+    return m_active != active || m_known != known || m_feedRateKnown != feedRateKnown ||
+           (m_feedRateKnown && m_feedRate != feedRate);
+}
+
+void Grbl::ModalState::applyParserState(const char *cursor)
+{
+    // Grbl lists every modal group; coolant is reported as "M9" or as whichever of M7 and M8 is on.
+    invalidate();
+    setActive(MistCoolant, Command::M9_CoolantControlStop);
+    setActive(FloodCoolant, Command::M9_CoolantControlStop);
+
+    while (*cursor != '\0' && *cursor != PARSER_STATE_END)
+    {
+        const auto letter = *cursor++;
+        float value;
+
+        if (Grbl::Parser::parseFloat(cursor, value))
+        {
+            apply(letter, value);
+        }
+    }
+}
+
+// --------------------------------------------------------------------------------------------------
+// Private methods
+// --------------------------------------------------------------------------------------------------
+
+void Grbl::ModalState::apply(char letter, float value)
+{
+    const auto code = lroundf(value * 10);
+
+    switch (letter)
+    {
+    case 'F':
+    {
+        m_feedRate = value;
+        m_feedRateKnown = true;
+        break;
+    }
+    case 'G':
+    {
+        switch (code)
+        {
+        case 0:
+        {
+            return setActive(Motion, Command::G0_RapidPositioning);
+        }
+        case 10:
+        {
+            return setActive(Motion, Command::G1_LinearInterpolation);
+        }
+        case 20:
+        {
+            return setActive(Motion, Command::G2_ClockwiseCircularInterpolation);
+        }
+        case 30:
+        {
+            return setActive(Motion, Command::G3_CounterclockwiseCircularInterpolation);
+        }
+        case 382:
+        {
+            return setActive(Motion, Command::G38_2_Probing);
+        }
+        case 383:
+        {
+            return setActive(Motion, Command::G38_3_Probing);
+        }
+        case 384:
+        {
+            return setActive(Motion, Command::G38_4_Probing);
+        }
+        case 385:
+        {
+            return setActive(Motion, Command::G38_5_Probing);
+        }
+        case 800:
+        {
+            return setActive(Motion, Command::G80_MotionModeCancel);
+        }
+        case 170:
+        {
+            return setActive(Plane, Command::G17_PlaneSelectionXY);
+        }
+        case 180:
+        {
+            return setActive(Plane, Command::G18_PlaneSelectionZX);
+        }
+        case 190:
+        {
+            return setActive(Plane, Command::G19_PlaneSelectionYZ);
+        }
+        case 200:
+        {
+            return setActive(Units, Command::G20_UnitsInches);
+        }
+        case 210:
+        {
+            return setActive(Units, Command::G21_UnitsMillimeters);
+        }
+        case 540:
+        case 550:
+        case 560:
+        case 570:
+        case 580:
+        case 590:
+        {
+            const auto system = static_cast<int>(Command::G54_WorkCoordinateSystem1) + (code - 540) / 10;
+            return setActive(CoordinateSystem, static_cast<Command>(system));
+        }
+        case 900:
+        {
+            return setActive(DistanceMode, Command::G90_DistanceModeAbsolute);
+        }
+        case 910:
+        {
+            return setActive(DistanceMode, Command::G91_DistanceModeIncremental);
+        }
+        case 930:
+        {
+            return setActive(FeedRateMode, Command::G93_FeedrateModeInverseTime);
+        }
+        case 940:
+        {
+            return setActive(FeedRateMode, Command::G94_FeedrateModeUnitsPerMinute);
+        }
+        }
+
+        break;
+    }
+    case 'M':
+    {
+        switch (code)
+        {
+        case 20:
+        case 300:
+        {
+            // Program end restores Grbl's defaults for several groups.
+            return invalidate();
+        }
+        case 30:
+        {
+            return setActive(Spindle, Command::M3_SpindleControlCW);
+        }
+        case 40:
+        {
+            return setActive(Spindle, Command::M4_SpindleControlCCW);
+        }
+        case 50:
+        {
+            return setActive(Spindle, Command::M5_SpindleStop);
+        }
+        case 70:
+        {
+            return setActive(MistCoolant, Command::M7_CoolantControlMist);
+        }
+        case 80:
+        {
+            return setActive(FloodCoolant, Command::M8_CoolantControlFlood);
+        }
+        case 90:
+        {
+            setActive(MistCoolant, Command::M9_CoolantControlStop);
+            return setActive(FloodCoolant, Command::M9_CoolantControlStop);
+        }
+        }
+
+        break;
+    }
+    }
+}
+
+void Grbl::ModalState::setActive(Group group, Command command)
+{
+    // Grbl keeps the feed rate in mm/min, so the same F word means another feed once the units or the feed
+    // rate mode change.
+    if ((group == Units || group == FeedRateMode) && !((m_known & (1 << group)) != 0 && m_active[group] == command))
+    {
+        m_feedRateKnown = false;
+    }
+
+    m_active[group] = command;
+    m_known |= 1 << group;
+}
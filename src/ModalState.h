@@ -0,0 +1,54 @@
+#pragma once
+
+#include "GrblCommands.h"
+
+#include <array>
+#include <cstdint>
+
+namespace Grbl
+{
+    // Mirror of Grbl's g-code parser state: one active command per modal group plus the feed rate.
+    // Anything not known for sure is reported as inactive, so callers fall back to sending the words.
+    class ModalState
+    {
+    public:
+        ModalState();
+
+        void invalidate();
+
+        [[nodiscard]] bool isActive(Command command) const;
+        // Only in units per minute mode (G94), as inverse time mode (G93) needs F on every motion line.
+        [[nodiscard]] bool isFeedRate(float feedRate) const;
+
+        // Tracks the modal words of a line that Grbl accepts, e.g. "G1X10F500" or "G21 G90". Returns whether
+        // the state changed, so that lines after it rely on Grbl accepting this one.
+        bool applyLine(const char *line);
+
+        // Takes over the parser state reported by $G, e.g. "[GC:G0 G54 G17 G21 G90 G94 M5 M9 T0 F0 S0]",
+        // starting right after the "[GC:" prefix.
+        void applyParserState(const char *cursor);
+
+    private:
+        enum Group : uint8_t
+        {
+            Motion,
+            Plane,
+            Units,
+            DistanceMode,
+            CoordinateSystem,
+            FeedRateMode,
+            Spindle,
+            MistCoolant,
+            FloodCoolant,
+            GROUP_COUNT
+        };
+
+        std::array<Command, GROUP_COUNT> m_active;
+        uint16_t m_known; // Bit per group.
+        float m_feedRate;
+        bool m_feedRateKnown;
+
+        void apply(char letter, float value);
+        void setActive(Group group, Command command);
+    };
+}
@@ -0,0 +1,539 @@
+#include "PositionEstimator.h"
+#include "GrblCommands.h"
+#include "GrblParser.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    constexpr auto COMMENT_START = '(';
+    constexpr auto COMMENT_END = ')';
+    constexpr auto LINE_COMMENT = ';';
+    constexpr auto SYSTEM_COMMAND = '$';
+    constexpr auto HOMING_COMMAND = 'H';
+    constexpr auto MM_PER_INCH = 25.4f;
+    constexpr auto MICROS_PER_SECOND = 1000000.0f;
+    constexpr auto SECONDS_PER_MINUTE = 60.0f;
+    constexpr auto PERCENT = 100.0f;
+    constexpr auto PATH_TOLERANCE = 0.05f;    // mm, reported positions are whole steps.
+    constexpr auto STRAIGHT_TOLERANCE = 0.1f; // Of the distance travelled between two reports.
+
+    using Position = Grbl::PositionEstimator::Position;
+
+    [[nodiscard]] float distance(const Position &from, const Position &to)
+    {
+        auto sum = 0.0f;
+
+        for (size_t i = 0; i < from.size(); i++)
+        {
+            sum += (to[i] - from[i]) * (to[i] - from[i]);
+        }
+
+        return std::sqrt(sum);
+    }
+
+    [[nodiscard]] float distanceToSegment(const Position &point, const Position &start, const Position &end)
+    {
+        auto lengthSquared = 0.0f;
+        auto projection = 0.0f;
+
+        for (size_t i = 0; i < point.size(); i++)
+        {
+            lengthSquared += (end[i] - start[i]) * (end[i] - start[i]);
+            projection += (point[i] - start[i]) * (end[i] - start[i]);
+        }
+
+        const auto fraction = lengthSquared > 0 ? std::clamp(projection / lengthSquared, 0.0f, 1.0f) : 0.0f;
+        Position closest;
+
+        for (size_t i = 0; i < point.size(); i++)
+        {
+            closest[i] = start[i] + (end[i] - start[i]) * fraction;
+        }
+
+        return distance(point, closest);
+    }
+}
+
+Grbl::PositionEstimator::PositionEstimator()
+    : m_maxAcceleration(DEFAULT_MAX_ACCELERATION),
+      m_feedOverride(static_cast<uint8_t>(PERCENT)),
+      m_reportedPosition{},
+      m_previousPosition{},
+      m_reportedFeedRate(0),
+      m_moving(false),
+      m_directionKnown(false),
+      m_requestedAt(0),
+      m_receivedAt(0),
+      m_onPath(false),
+      m_pathStart{},
+      m_planned{},
+      m_plannedKnown(false),
+      m_movesPending(false),
+      m_motionMode(MotionMode::Rapid),
+      m_incremental(false),
+      m_inches(false),
+      m_inverseTime(false),
+      m_feedRate(0)
+{
+}
+
+void Grbl::PositionEstimator::setMaxAcceleration(float acceleration)
+{
+    m_maxAcceleration = acceleration;
+}
+
+float Grbl::PositionEstimator::maxAcceleration() const
+{
+    return m_maxAcceleration;
+}
+
+void Grbl::PositionEstimator::setFeedOverride(uint8_t feedOverride)
+{
+    m_feedOverride = feedOverride;
+}
+
+void Grbl::PositionEstimator::reset()
+{
+    m_moves.clear();
+    m_onPath = false;
+    m_plannedKnown = false;
+    m_movesPending = false;
+    m_motionMode = MotionMode::Rapid;
+    m_incremental = false;
+    m_inches = false;
+    m_inverseTime = false;
+    m_feedRate = 0;
+}
+
+void Grbl::PositionEstimator::forgetMoves()
+{
+    m_moves.clear();
+    m_onPath = false;
+    m_plannedKnown = false;
+    m_movesPending = true;
+}
+
+void Grbl::PositionEstimator::applyLine(const char *line, const Position *workCoordinateOffset)
+{
+    const auto *jogCommand = getCommand(Command::RunJoggingMotion);
+    const auto jog = strncmp(line, jogCommand, strlen(jogCommand)) == 0;
+
+    if (jog)
+    {
+        line += strlen(jogCommand);
+    }
+    else if (*line == SYSTEM_COMMAND)
+    {
+        // Homing ends wherever the switches are.
+        if (toupper(line[1]) == HOMING_COMMAND)
+        {
+            forgetMoves();
+        }
+
+        return;
+    }
+
+    // Jog lines bring their own modes and feed rate, which Grbl forgets afterwards.
+    auto motionMode = jog ? MotionMode::Linear : m_motionMode;
+    auto incremental = m_incremental;
+    auto inches = m_inches;
+    auto inverseTime = !jog && m_inverseTime;
+    auto feedRate = jog ? 0.0f : m_feedRate;
+    auto feedWord = -1.0f;
+    auto machineCoordinates = false;
+    auto untracked = false;
+    Position words{};
+    uint8_t axisWords = 0; // Bit per axis.
+
+    while (*line != '\0' && *line != LINE_COMMENT)
+    {
+        if (*line == COMMENT_START)
+        {
+            while (*line != '\0' && *line != COMMENT_END)
+            {
+                line++;
+            }
+
+            continue;
+        }
+
+        const auto letter = static_cast<char>(toupper(*line++));
+        float value;
+
+        if (letter < 'A' || letter > 'Z' || !Grbl::Parser::parseFloat(line, value))
+        {
+            continue;
+        }
+
+        switch (letter)
+        {
+        case 'F':
+        {
+            feedWord = value;
+            continue;
+        }
+        case 'M':
+        {
+            // Program end restores G90, among others.
+            const auto code = lroundf(value);
+            incremental = incremental && code != 2 && code != 30;
+            continue;
+        }
+        case 'G':
+        {
+            break;
+        }
+        default:
+        {
+            const auto axis = axisIndex(letter);
+
+            if (axis >= 0)
+            {
+                words[axis] = value;
+                axisWords |= 1 << axis;
+            }
+
+            continue;
+        }
+        }
+
+        switch (lroundf(value * 10))
+        {
+        case 0:
+        {
+            motionMode = MotionMode::Rapid;
+            break;
+        }
+        case 10:
+        {
+            motionMode = MotionMode::Linear;
+            break;
+        }
+        case 20:
+        case 30:
+        {
+            motionMode = MotionMode::Arc;
+            break;
+        }
+        case 382:
+        case 383:
+        case 384:
+        case 385:
+        {
+            motionMode = MotionMode::Untracked;
+            break;
+        }
+        case 800:
+        {
+            motionMode = MotionMode::None;
+            break;
+        }
+        case 200:
+        case 210:
+        {
+            inches = value < 21;
+            break;
+        }
+        case 900:
+        case 910:
+        {
+            incremental = value > 90;
+            break;
+        }
+        case 930:
+        case 940:
+        {
+            inverseTime = value < 94;
+            break;
+        }
+        case 530:
+        {
+            machineCoordinates = true;
+            break;
+        }
+        // Moves to stored positions, and offsets that change before a status report shows them.
+        case 100:
+        case 280:
+        case 281:
+        case 300:
+        case 301:
+        case 431:
+        case 490:
+        case 920:
+        case 921:
+        case 922:
+        case 923:
+        {
+            untracked = true;
+            break;
+        }
+        default:
+        {
+            break;
+        }
+        }
+    }
+
+    const auto scale = inches ? MM_PER_INCH : 1.0f;
+
+    if (feedWord >= 0)
+    {
+        feedRate = feedWord * scale;
+    }
+
+    if (!jog)
+    {
+        m_motionMode = motionMode;
+        m_incremental = incremental;
+        m_inches = inches;
+        m_inverseTime = inverseTime;
+        m_feedRate = feedRate;
+    }
+
+    if (untracked || (axisWords != 0 && motionMode == MotionMode::Untracked))
+    {
+        forgetMoves();
+        return;
+    }
+
+    if (axisWords == 0 || motionMode == MotionMode::None)
+    {
+        return;
+    }
+
+    m_movesPending = true;
+
+    if (!m_plannedKnown)
+    {
+        return;
+    }
+
+    if (workCoordinateOffset == nullptr && (machineCoordinates || !incremental))
+    {
+        forgetMoves();
+        return;
+    }
+
+    auto target = m_planned;
+
+    for (auto i = 0; i < MAX_NUMBER_OF_AXES; i++)
+    {
+        if ((axisWords & (1 << i)) == 0)
+        {
+            continue;
+        }
+
+        const auto value = words[i] * scale;
+
+        if (machineCoordinates)
+        {
+            target[i] = value;
+        }
+        else if (incremental)
+        {
+            target[i] = m_planned[i] + value;
+        }
+        else
+        {
+            target[i] = value + (*workCoordinateOffset)[i];
+        }
+    }
+
+    // Only where an arc ends is followed, not the arc itself.
+    if (motionMode == MotionMode::Arc)
+    {
+        m_moves.clear();
+        m_planned = target;
+        return;
+    }
+
+    // An inverse time F is no speed.
+    pushMove(target, motionMode == MotionMode::Linear && !inverseTime ? feedRate : 0);
+}
+
+void Grbl::PositionEstimator::applyStatusReport(const Position &position, float feedRate, bool moving, bool settled,
+                                                uint32_t requestedAt, uint32_t receivedAt)
+{
+    // On a curve the reports lie closer together than the distance travelled between them.
+    const auto travelled = (m_reportedFeedRate + feedRate) / 2 / SECONDS_PER_MINUTE *
+                           (requestedAt - m_requestedAt) / MICROS_PER_SECOND;
+    const auto length = distance(m_reportedPosition, position);
+    m_directionKnown = m_moving && moving && length > 0 &&
+                       std::fabs(length - travelled) <= STRAIGHT_TOLERANCE * travelled;
+    m_previousPosition = m_reportedPosition;
+    m_reportedPosition = position;
+    m_reportedFeedRate = feedRate;
+    m_moving = moving;
+    m_requestedAt = requestedAt;
+    m_receivedAt = receivedAt;
+
+    if (settled)
+    {
+        m_moves.clear();
+        m_onPath = false;
+        m_planned = position;
+        m_plannedKnown = true;
+        m_movesPending = false;
+        return;
+    }
+
+    matchPath();
+}
+
+Grbl::PositionEstimate Grbl::PositionEstimator::estimate(uint32_t now) const
+{
+    PositionEstimate estimate{};
+    estimate.machinePosition = m_reportedPosition;
+    estimate.age = now - m_requestedAt;
+    estimate.moving = m_moving;
+
+    // The estimate starts from the request, so it runs ahead by as far as the machine moved before Grbl took
+    // the report. Once reports stop arriving it stays put, and only the uncertainty keeps growing.
+    const auto seconds = estimate.age / MICROS_PER_SECOND;
+    const auto extrapolated = std::min(seconds, MAX_EXTRAPOLATION_MS / 1000.0f);
+    const auto speed = m_reportedFeedRate / SECONDS_PER_MINUTE;
+    const auto travel = speed * seconds;
+    const auto transfer = speed * (m_receivedAt - m_requestedAt) / MICROS_PER_SECOND;
+    // Speed and direction change no faster than the acceleration allows.
+    const auto drift = m_maxAcceleration * seconds * seconds / 2;
+
+    if (!m_moving)
+    {
+        // E.g. a feed hold still braking, or a move sent that may have started since.
+        estimate.uncertainty = std::min(travel, speed * speed / (2 * m_maxAcceleration)) + (m_movesPending ? drift : 0);
+        return estimate;
+    }
+
+    if (m_onPath && !m_moves.empty())
+    {
+        followPath(speed * extrapolated, estimate.machinePosition);
+
+        // Behind where Grbl slows down for a corner, ahead where it speeds up to the fastest move left.
+        const auto maxSpeed = this->maxSpeed();
+        const auto behind = std::min(drift, travel);
+        const auto ahead = maxSpeed > 0 ? std::min(drift, std::max(0.0f, maxSpeed - speed) * seconds) : drift;
+        estimate.uncertainty = transfer + std::max(behind, ahead) + speed * (seconds - extrapolated);
+        return estimate;
+    }
+
+    // Without the moves, the direction of the last two reports is all there is, and a corner may turn the
+    // machine any other way.
+    const auto length = distance(m_previousPosition, m_reportedPosition);
+    estimate.uncertainty = travel + drift;
+
+    if (m_directionKnown)
+    {
+        for (size_t i = 0; i < estimate.machinePosition.size(); i++)
+        {
+            estimate.machinePosition[i] += (m_reportedPosition[i] - m_previousPosition[i]) / length * speed * extrapolated;
+        }
+
+        estimate.uncertainty += speed * extrapolated;
+    }
+
+    return estimate;
+}
+
+const Grbl::PositionEstimator::Position &Grbl::PositionEstimator::reportedPosition() const
+{
+    return m_reportedPosition;
+}
+
+// --------------------------------------------------------------------------------------------------
+// Private methods
+// --------------------------------------------------------------------------------------------------
+
+void Grbl::PositionEstimator::pushMove(const Position &target, float feedRate)
+{
+    if (m_moves.empty())
+    {
+        m_pathStart = m_planned;
+    }
+
+    // More moves than Grbl can buffer, so the oldest one has been run.
+    Move dropped;
+
+    if (m_moves.full() && m_moves.pop(dropped))
+    {
+        m_pathStart = dropped.target;
+    }
+
+    (void)m_moves.push({target, feedRate});
+    m_planned = target;
+}
+
+void Grbl::PositionEstimator::matchPath()
+{
+    // The move closest to the report is the one running, the earliest one where the path runs over itself.
+    // The ones before it are done.
+    auto start = m_pathStart;
+    auto closest = PATH_TOLERANCE;
+    auto running = m_moves.size();
+
+    for (size_t i = 0; i < m_moves.size(); i++)
+    {
+        const auto offPath = distanceToSegment(m_reportedPosition, start, m_moves[i].target);
+
+        if (offPath < closest)
+        {
+            closest = offPath;
+            running = i;
+        }
+
+        start = m_moves[i].target;
+    }
+
+    // Off every move, e.g. still on an arc or on a move sent before they were known.
+    m_onPath = running < m_moves.size();
+    Move done;
+
+    for (size_t i = 0; m_onPath && i < running; i++)
+    {
+        (void)m_moves.pop(done);
+        m_pathStart = done.target;
+    }
+}
+
+void Grbl::PositionEstimator::followPath(float distance, Position &position) const
+{
+    for (size_t i = 0; i < m_moves.size(); i++)
+    {
+        const auto &target = m_moves[i].target;
+        const auto length = ::distance(position, target);
+
+        if (distance < length)
+        {
+            for (size_t axis = 0; axis < position.size(); axis++)
+            {
+                position[axis] += (target[axis] - position[axis]) * distance / length;
+            }
+
+            return;
+        }
+
+        distance -= length;
+        position = target;
+    }
+}
+
+float Grbl::PositionEstimator::maxSpeed() const
+{
+    auto feedRate = 0.0f;
+
+    for (size_t i = 0; i < m_moves.size(); i++)
+    {
+        // One uncapped move leaves the speed uncapped.
+        if (m_moves[i].feedRate <= 0)
+        {
+            return 0;
+        }
+
+        feedRate = std::max(feedRate, m_moves[i].feedRate);
+    }
+
+    return feedRate * m_feedOverride / PERCENT / SECONDS_PER_MINUTE;
+}
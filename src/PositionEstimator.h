@@ -0,0 +1,104 @@
+#pragma once
+
+#include "GrblConstants.h"
+#include "RingBuffer.h"
+
+#include <array>
+#include <cstdint>
+
+namespace Grbl
+{
+    constexpr auto DEFAULT_MAX_ACCELERATION = 1000.0f; // mm/s^2, above Grbl's $120-$125 on most machines.
+    constexpr auto MAX_EXTRAPOLATION_MS = 1000;         // Estimates stop moving this long after a report.
+    constexpr auto MAX_TRACKED_MOVES = PLANNER_BLOCKS + MAX_LINES_IN_FLIGHT + 1;
+
+    struct PositionEstimate
+    {
+        std::array<float, MAX_NUMBER_OF_AXES> machinePosition;
+        std::array<float, MAX_NUMBER_OF_AXES> workPosition;
+        float uncertainty; // mm, the machine is no further than this from the estimate.
+        uint32_t age;      // Microseconds since the status report the estimate starts from was requested.
+        bool moving;
+    };
+
+    // Extrapolates the position of the last status report. While the machine runs, it is advanced at the
+    // reported feed rate along the moves sent since, and never past the end of the last one. Where the moves
+    // are not known (arcs, homing, probing, offsets changed) it follows the direction of the last two reports
+    // if the machine ran straight between them, and otherwise stays at the report.
+    // The uncertainty holds as long as the machine accelerates no faster than maxAcceleration.
+    class PositionEstimator
+    {
+    public:
+        using Position = std::array<float, MAX_NUMBER_OF_AXES>;
+
+        PositionEstimator();
+
+        void setMaxAcceleration(float acceleration);
+        [[nodiscard]] float maxAcceleration() const;
+        // Percent, as reported in Ov:. Caps how fast the machine may speed up along with the F words.
+        void setFeedOverride(uint8_t feedOverride);
+
+        // A reset: no move is left and the g-code modes are back to Grbl's defaults.
+        void reset();
+        // The moves sent may not run as sent, e.g. after a jog cancel or an error. They are learned again
+        // once the machine is reported at rest.
+        void forgetMoves();
+
+        // A line handed over to Grbl. Targets in work coordinates are placed with workCoordinateOffset; while it
+        // is nullptr, only incremental moves are followed.
+        void applyLine(const char *line, const Position *workCoordinateOffset);
+        // settled: at rest with nothing queued, so the machine stands at the end of every move sent. Grbl took
+        // the report somewhere between requestedAt and receivedAt.
+        void applyStatusReport(const Position &position, float feedRate, bool moving, bool settled,
+                               uint32_t requestedAt, uint32_t receivedAt);
+
+        // Fills machinePosition only, in the coordinates the reports were given in.
+        [[nodiscard]] PositionEstimate estimate(uint32_t now) const;
+        [[nodiscard]] const Position &reportedPosition() const;
+
+    private:
+        enum class MotionMode : uint8_t
+        {
+            None,
+            Rapid,
+            Linear, // G1 and jogging.
+            Arc,
+            Untracked // Probing.
+        };
+
+        struct Move
+        {
+            Position target;
+            float feedRate; // mm/min, 0 where the speed is not capped, e.g. for rapids.
+        };
+
+        float m_maxAcceleration;
+        uint8_t m_feedOverride;
+
+        Position m_reportedPosition;
+        Position m_previousPosition; // Of the report before, for the direction.
+        float m_reportedFeedRate;    // mm/min
+        bool m_moving;
+        bool m_directionKnown; // Ran straight from the report before.
+        uint32_t m_requestedAt; // Grbl::Platform::micros()
+        uint32_t m_receivedAt;
+        bool m_onPath; // The last report lay on one of the moves.
+
+        RingBuffer<Move, MAX_TRACKED_MOVES> m_moves;
+        Position m_pathStart; // Where the first move starts.
+        Position m_planned;   // End of the last move sent.
+        bool m_plannedKnown;
+        bool m_movesPending; // Motion sent since the machine was last reported at rest.
+
+        MotionMode m_motionMode;
+        bool m_incremental;
+        bool m_inches;
+        bool m_inverseTime;
+        float m_feedRate; // mm/min as programmed, 0 until an F word was sent.
+
+        void pushMove(const Position &target, float feedRate);
+        void matchPath();
+        void followPath(float distance, Position &position) const;
+        [[nodiscard]] float maxSpeed() const;
+    };
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+namespace Grbl
+{
+    // Fixed-capacity FIFO that never allocates.
+    template <typename T, size_t Capacity>
+    class RingBuffer
+    {
+    public:
+        [[nodiscard]] bool push(const T &value)
+        {
+            if (full())
+            {
+                return false;
+            }
+
+            m_items[(m_head + m_size) % Capacity] = value;
+            m_size++;
+            return true;
+        }
+
+        [[nodiscard]] bool pop(T &value)
+        {
+            if (empty())
+            {
+                return false;
+            }
+
+            value = m_items[m_head];
+            m_head = (m_head + 1) % Capacity;
+            m_size--;
+            return true;
+        }
+
+        [[nodiscard]] T &front()
+        {
+            return m_items[m_head];
+        }
+
+        [[nodiscard]] T &back()
+        {
+            return m_items[(m_head + m_size - 1) % Capacity];
+        }
+
+        [[nodiscard]] T &operator[](size_t index)
+        {
+            return m_items[(m_head + index) % Capacity];
+        }
+
+        [[nodiscard]] const T &operator[](size_t index) const
+        {
+            return m_items[(m_head + index) % Capacity];
+        }
+
+        void clear()
+        {
+            m_head = 0;
+            m_size = 0;
+        }
+
+        [[nodiscard]] size_t size() const
+        {
+            return m_size;
+        }
+
+        [[nodiscard]] constexpr size_t capacity() const
+        {
+            return Capacity;
+        }
+
+        [[nodiscard]] bool empty() const
+        {
+            return m_size == 0;
+        }
+
+        [[nodiscard]] bool full() const
+        {
+            return m_size == Capacity;
+        }
+
+    private:
+        std::array<T, Capacity> m_items{};
+        size_t m_head = 0;
+        size_t m_size = 0;
+    };
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "GrblPlatform.h"
+
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+
+namespace Grbl
+{
+    // Sequence lock for one writer and any number of readers on other tasks. The writer never blocks;
+    // a reader copies the value and retries if a write overlapped the copy, so it always ends up with a
+    // consistent value without taking a mutex. The value is stored as atomic words so the concurrent
+    // copy stays well defined.
+    template <typename T>
+    class SeqLock
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "SeqLock values are copied word by word");
+
+    public:
+        void write(const T &value)
+        {
+            std::array<uint32_t, WORDS> words{};
+            memcpy(words.data(), &value, sizeof(T));
+
+            const auto sequence = m_sequence.load(std::memory_order_relaxed);
+            m_sequence.store(sequence + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+
+            for (size_t i = 0; i < WORDS; i++)
+            {
+                m_words[i].store(words[i], std::memory_order_relaxed);
+            }
+
+            m_sequence.store(sequence + 2, std::memory_order_release);
+        }
+
+        [[nodiscard]] T read() const
+        {
+            std::array<uint32_t, WORDS> words{};
+            uint32_t before;
+            uint32_t after;
+            auto attempts = 0;
+
+            do
+            {
+                // A writer preempted on this core by a higher priority reader has to get a chance to finish.
+                if (++attempts > MAX_SPINS)
+                {
+                    Platform::sleep(0);
+                    attempts = 0;
+                }
+
+                before = m_sequence.load(std::memory_order_acquire);
+
+                for (size_t i = 0; i < WORDS; i++)
+                {
+                    words[i] = m_words[i].load(std::memory_order_relaxed);
+                }
+
+                std::atomic_thread_fence(std::memory_order_acquire);
+                after = m_sequence.load(std::memory_order_relaxed);
+            } while ((before & 1) != 0 || before != after);
+
+            T value;
+            memcpy(&value, words.data(), sizeof(T));
+            return value;
+        }
+
+        // Incremented twice per write, so readers can tell whether anything changed since their last copy.
+        [[nodiscard]] uint32_t sequence() const
+        {
+            return m_sequence.load(std::memory_order_acquire);
+        }
+
+    private:
+        static constexpr size_t WORDS = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+        static constexpr auto MAX_SPINS = 64;
+
+        std::array<std::atomic<uint32_t>, WORDS> m_words{};
+        std::atomic<uint32_t> m_sequence{0};
+    };
+}
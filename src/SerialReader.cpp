@@ -0,0 +1,140 @@
+#include "SerialReader.h"
+
+namespace
+{
+    constexpr auto TASK_NAME = "grbl-reader";
+    constexpr auto IDLE_MICROS = 1000; // One FreeRTOS tick; 115200 baud delivers ~12 bytes meanwhile.
+}
+
+Grbl::SerialReader::~SerialReader()
+{
+    stop();
+}
+
+bool Grbl::SerialReader::start(ByteStream &stream, int core)
+{
+    if (m_running)
+    {
+        return true;
+    }
+
+    m_stream = &stream;
+    m_stopRequested = false;
+    m_running = m_task.start(run, this, TASK_NAME, core);
+    return m_running;
+}
+
+void Grbl::SerialReader::stop()
+{
+    if (!m_running)
+    {
+        return;
+    }
+
+    m_stopRequested = true;
+    m_task.join();
+    m_running = false;
+}
+
+bool Grbl::SerialReader::running() const
+{
+    return m_running;
+}
+
+const Grbl::ReceivedLine *Grbl::SerialReader::front()
+{
+    return m_lines.front();
+}
+
+void Grbl::SerialReader::pop()
+{
+    m_lines.pop();
+}
+
+size_t Grbl::SerialReader::linesQueued() const
+{
+    return m_lines.size();
+}
+
+Grbl::SerialReaderStatistics Grbl::SerialReader::statistics() const
+{
+    return {m_linesReceived, m_linesTruncated, m_queueFullStalls};
+}
+
+// --------------------------------------------------------------------------------------------------
+// Private methods
+// --------------------------------------------------------------------------------------------------
+
+void Grbl::SerialReader::run(void *reader)
+{
+    static_cast<SerialReader *>(reader)->readLoop();
+}
+
+void Grbl::SerialReader::readLoop()
+{
+    ReceivedLine *line = nullptr;
+    auto stalled = false;
+
+    while (!m_stopRequested)
+    {
+        if (line == nullptr)
+        {
+            line = m_lines.beginPush();
+
+            if (line == nullptr)
+            {
+                if (!stalled)
+                {
+                    m_queueFullStalls++;
+                    stalled = true;
+                }
+
+                Platform::sleep(IDLE_MICROS);
+                continue;
+            }
+
+            stalled = false;
+            line->length = 0;
+            line->truncated = false;
+        }
+
+        if (!m_stream->available())
+        {
+            Platform::sleep(IDLE_MICROS);
+            continue;
+        }
+
+        while (line != nullptr && m_stream->available())
+        {
+            const char c = m_stream->read();
+
+            // Grbl terminates lines with "\r\n"; the empty line in between is dropped.
+            if (c == '\r' || c == '\n')
+            {
+                if (line->length == 0)
+                {
+                    continue;
+                }
+
+                line->text[line->length] = '\0';
+                m_linesReceived++;
+
+                if (line->truncated)
+                {
+                    m_linesTruncated++;
+                }
+
+                m_lines.endPush();
+                line = nullptr;
+            }
+            else if (line->length < RECEIVED_LINE_SIZE - 1)
+            {
+                line->text[line->length++] = c;
+            }
+            else
+            {
+                line->truncated = true;
+            }
+        }
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "GrblPlatform.h"
+#include "SpscRingBuffer.h"
+
+#include <atomic>
+
+namespace Grbl
+{
+    constexpr auto RECEIVED_LINE_SIZE = 256;      // Longest response kept, including the terminating null.
+    constexpr auto RECEIVED_LINE_QUEUE_SIZE = 32; // Lines buffered between the reader and update(), a power of two.
+    constexpr auto READER_TASK_CORE = 0;          // The Arduino loop runs on core 1 of the ESP32.
+
+    struct ReceivedLine
+    {
+        uint16_t length;
+        bool truncated;
+        char text[RECEIVED_LINE_SIZE];
+    };
+
+    struct SerialReaderStatistics
+    {
+        uint32_t linesReceived;
+        uint32_t linesTruncated;
+        uint32_t queueFullStalls; // Times the reader had to leave bytes in the UART because update() fell behind.
+    };
+
+    // Drains the stream on its own task and splits it into lines, so bytes keep flowing out of the UART
+    // while the application loop is busy. Completed lines are handed over through a lock-free queue.
+    class SerialReader
+    {
+    public:
+        SerialReader() = default;
+        ~SerialReader();
+
+        SerialReader(const SerialReader &) = delete;
+        SerialReader &operator=(const SerialReader &) = delete;
+
+        [[nodiscard]] bool start(ByteStream &stream, int core = READER_TASK_CORE);
+        void stop();
+        [[nodiscard]] bool running() const;
+
+        // Consumer side, only to be used from a single thread.
+        [[nodiscard]] const ReceivedLine *front();
+        void pop();
+        [[nodiscard]] size_t linesQueued() const;
+
+        [[nodiscard]] SerialReaderStatistics statistics() const;
+
+    private:
+        ByteStream *m_stream = nullptr;
+        Task m_task;
+        SpscRingBuffer<ReceivedLine, RECEIVED_LINE_QUEUE_SIZE> m_lines;
+        std::atomic<bool> m_running{false};
+        std::atomic<bool> m_stopRequested{false};
+        std::atomic<uint32_t> m_linesReceived{0};
+        std::atomic<uint32_t> m_linesTruncated{0};
+        std::atomic<uint32_t> m_queueFullStalls{0};
+
+        static void run(void *reader);
+        void readLoop();
+    };
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace Grbl
+{
+    // Lock-free FIFO for exactly one producer and one consumer thread. Slots are written and read in
+    // place, so large items are never copied: the producer fills the slot returned by beginPush() and
+    // publishes it with endPush(), the consumer releases the slot returned by front() with pop().
+    template <typename T, size_t Capacity>
+    class SpscRingBuffer
+    {
+        static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+    public:
+        // Producer side.
+        [[nodiscard]] T *beginPush()
+        {
+            const auto head = m_head.load(std::memory_order_relaxed);
+
+            if (head - m_tail.load(std::memory_order_acquire) == Capacity)
+            {
+                return nullptr;
+            }
+
+            return &m_items[head % Capacity];
+        }
+
+        void endPush()
+        {
+            m_head.store(m_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        // Consumer side.
+        [[nodiscard]] T *front()
+        {
+            const auto tail = m_tail.load(std::memory_order_relaxed);
+
+            if (tail == m_head.load(std::memory_order_acquire))
+            {
+                return nullptr;
+            }
+
+            return &m_items[tail % Capacity];
+        }
+
+        void pop()
+        {
+            m_tail.store(m_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        [[nodiscard]] size_t size() const
+        {
+            return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire);
+        }
+
+        [[nodiscard]] bool empty() const
+        {
+            return size() == 0;
+        }
+
+        [[nodiscard]] constexpr size_t capacity() const
+        {
+            return Capacity;
+        }
+
+    private:
+        std::array<T, Capacity> m_items{};
+        std::atomic<size_t> m_head{0};
+        std::atomic<size_t> m_tail{0};
+    };
+}
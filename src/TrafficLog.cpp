@@ -0,0 +1,501 @@
+#include "TrafficLog.h"
+
+#include "GrblCommands.h"
+
+#include <cstring>
+
+namespace
+{
+    constexpr auto LINE_END = '\n';
+
+    // Realtime commands are written whenever they are due, so they are left out of the comparison.
+    [[nodiscard]] bool isRealtimeCommand(uint8_t byte)
+    {
+        return byte == static_cast<uint8_t>(Grbl::RealtimeCommand::StatusReport) ||
+               byte == static_cast<uint8_t>(Grbl::RealtimeCommand::CycleStart) ||
+               byte == static_cast<uint8_t>(Grbl::RealtimeCommand::FeedHold) ||
+               byte == static_cast<uint8_t>(Grbl::RealtimeCommand::SoftReset) ||
+               byte >= 0x80;
+    }
+
+    void encodeHeader(const Grbl::TrafficRecord &record, uint8_t *header)
+    {
+        header[0] = static_cast<uint8_t>(record.direction);
+        header[1] = record.length;
+
+        for (auto i = 0; i < 4; i++)
+        {
+            header[2 + i] = static_cast<uint8_t>(record.time >> (8 * i));
+        }
+    }
+}
+
+Grbl::TrafficRecorder::TrafficRecorder(uint8_t *buffer, size_t size)
+    : m_buffer(buffer),
+      m_size(size),
+      m_head(0),
+      m_used(0),
+      m_sink(nullptr),
+      m_pending{},
+      m_recordsStored(0),
+      m_recordsOverwritten(0),
+      m_writing{}
+{
+}
+
+Grbl::TrafficRecorder::TrafficRecorder(ByteSink &sink)
+    : TrafficRecorder(nullptr, 0)
+{
+    m_sink = &sink;
+    m_sink->write(TRAFFIC_LOG_MAGIC, sizeof(TRAFFIC_LOG_MAGIC));
+}
+
+void Grbl::TrafficRecorder::record(TrafficDirection direction, const uint8_t *data, size_t length)
+{
+    const auto now = Platform::micros();
+    m_mutex.lock();
+    const auto storedBefore = m_recordsStored;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        // A byte completes at most two records, the one before and its own.
+        reserve(2);
+
+        if (m_pending.length > 0 &&
+            (m_pending.direction != direction || now - m_pending.time >= TRAFFIC_RECORD_SPAN_US))
+        {
+            store();
+        }
+
+        if (m_pending.length == 0)
+        {
+            m_pending.direction = direction;
+            m_pending.time = now;
+        }
+
+        m_pending.data[m_pending.length++] = data[i];
+
+        if (data[i] == LINE_END || m_pending.length == MAX_TRAFFIC_RECORD_LENGTH)
+        {
+            store();
+        }
+    }
+
+    const auto stored = m_recordsStored != storedBefore;
+    m_mutex.unlock();
+
+    if (m_sink != nullptr && stored)
+    {
+        writeCompleted(false);
+    }
+}
+
+void Grbl::TrafficRecorder::flush()
+{
+    m_mutex.lock();
+    reserve(1);
+
+    if (m_pending.length > 0)
+    {
+        store();
+    }
+
+    m_mutex.unlock();
+
+    if (m_sink != nullptr)
+    {
+        writeCompleted(true);
+        m_sinkMutex.lock();
+        m_sink->flush();
+        m_sinkMutex.unlock();
+    }
+}
+
+void Grbl::TrafficRecorder::writeTo(ByteSink &sink)
+{
+    m_mutex.lock();
+    sink.write(TRAFFIC_LOG_MAGIC, sizeof(TRAFFIC_LOG_MAGIC));
+
+    // The ring wraps around at most once, so the log is at most two pieces.
+    const auto tail = (m_head + m_size - m_used) % (m_size == 0 ? 1 : m_size);
+    const auto firstPiece = m_used < m_size - tail ? m_used : m_size - tail;
+
+    if (m_used > 0)
+    {
+        sink.write(m_buffer + tail, firstPiece);
+        sink.write(m_buffer, m_used - firstPiece);
+    }
+
+    m_mutex.unlock();
+}
+
+void Grbl::TrafficRecorder::clear()
+{
+    m_mutex.lock();
+    m_head = 0;
+    m_used = 0;
+    m_pending.length = 0;
+    m_recordsStored = 0;
+    m_recordsOverwritten = 0;
+    m_mutex.unlock();
+}
+
+uint32_t Grbl::TrafficRecorder::recordsStored() const
+{
+    return m_recordsStored;
+}
+
+uint32_t Grbl::TrafficRecorder::recordsOverwritten() const
+{
+    return m_recordsOverwritten;
+}
+
+// --------------------------------------------------------------------------------------------------
+// Private methods
+// --------------------------------------------------------------------------------------------------
+
+void Grbl::TrafficRecorder::reserve(size_t records)
+{
+    // Called with m_mutex held. A full queue is written out first, with the lock released meanwhile.
+    while (m_sink != nullptr && m_completed.size() + records > m_completed.capacity())
+    {
+        m_mutex.unlock();
+        writeCompleted(true);
+        m_mutex.lock();
+    }
+}
+
+void Grbl::TrafficRecorder::writeCompleted(bool wait)
+{
+    if (wait)
+    {
+        m_sinkMutex.lock();
+    }
+    else if (!m_sinkMutex.tryLock())
+    {
+        // The task writing takes these records along.
+        return;
+    }
+
+    while (true)
+    {
+        while (true)
+        {
+            m_mutex.lock();
+            const auto popped = m_completed.pop(m_writing);
+            m_mutex.unlock();
+
+            if (!popped)
+            {
+                break;
+            }
+
+            uint8_t header[TRAFFIC_RECORD_HEADER_SIZE];
+            encodeHeader(m_writing, header);
+            m_sink->write(header, sizeof(header));
+            m_sink->write(m_writing.data, m_writing.length);
+        }
+
+        m_sinkMutex.unlock();
+
+        // Records stored by a task that found the sink busy right before it was released.
+        m_mutex.lock();
+        const auto more = !m_completed.empty();
+        m_mutex.unlock();
+
+        if (!more || !m_sinkMutex.tryLock())
+        {
+            return;
+        }
+    }
+}
+
+void Grbl::TrafficRecorder::store()
+{
+    if (m_sink != nullptr)
+    {
+        // Room was reserved beforehand.
+        (void)m_completed.push(m_pending);
+    }
+    else
+    {
+        uint8_t header[TRAFFIC_RECORD_HEADER_SIZE];
+        encodeHeader(m_pending, header);
+        const auto length = sizeof(header) + m_pending.length;
+
+        if (length > m_size)
+        {
+            m_pending.length = 0;
+            return;
+        }
+
+        while (m_used + length > m_size)
+        {
+            dropOldestRecord();
+        }
+
+        storeInRing(header, sizeof(header));
+        storeInRing(m_pending.data, m_pending.length);
+    }
+
+    m_pending.length = 0;
+    m_recordsStored++;
+}
+
+void Grbl::TrafficRecorder::storeInRing(const uint8_t *data, size_t length)
+{
+    for (size_t i = 0; i < length; i++)
+    {
+        m_buffer[m_head] = data[i];
+        m_head = (m_head + 1) % m_size;
+    }
+
+    m_used += length;
+}
+
+void Grbl::TrafficRecorder::dropOldestRecord()
+{
+    const auto tail = (m_head + m_size - m_used) % m_size;
+    const auto length = m_buffer[(tail + 1) % m_size];
+    m_used -= TRAFFIC_RECORD_HEADER_SIZE + length;
+    m_recordsOverwritten++;
+}
+
+Grbl::RecordingStream::RecordingStream(ByteStream &stream, TrafficRecorder &recorder)
+    : m_stream(&stream),
+      m_recorder(&recorder)
+{
+}
+
+int Grbl::RecordingStream::available()
+{
+    return m_stream->available();
+}
+
+int Grbl::RecordingStream::read()
+{
+    const auto c = m_stream->read();
+
+    if (c >= 0)
+    {
+        const auto byte = static_cast<uint8_t>(c);
+        m_recorder->record(TrafficDirection::Received, &byte, 1);
+    }
+
+    return c;
+}
+
+size_t Grbl::RecordingStream::write(const uint8_t *data, size_t length)
+{
+    const auto written = m_stream->write(data, length);
+    m_recorder->record(TrafficDirection::Sent, data, written);
+    return written;
+}
+
+Grbl::TrafficReplay::TrafficReplay(ByteSource &log, bool realTime)
+    : m_log(&log),
+      m_realTime(realTime),
+      m_valid(false),
+      m_loaded(false),
+      m_exhausted(false),
+      m_record{},
+      m_offset(0),
+      m_firstTime(0),
+      m_time(0),
+      m_startedAt(0),
+      m_recordsPlayed(0),
+      m_mismatches(0),
+      m_expected{},
+      m_expectedHead(0),
+      m_expectedCount(0)
+{
+    uint8_t magic[sizeof(TRAFFIC_LOG_MAGIC)];
+    m_valid = readFully(magic, sizeof(magic)) && memcmp(magic, TRAFFIC_LOG_MAGIC, sizeof(magic)) == 0;
+    m_exhausted = !m_valid;
+}
+
+bool Grbl::TrafficReplay::valid() const
+{
+    return m_valid;
+}
+
+bool Grbl::TrafficReplay::finished()
+{
+    return !m_loaded && (m_exhausted || !load());
+}
+
+uint64_t Grbl::TrafficReplay::micros() const
+{
+    return m_time;
+}
+
+uint32_t Grbl::TrafficReplay::recordsPlayed() const
+{
+    return m_recordsPlayed;
+}
+
+uint32_t Grbl::TrafficReplay::mismatches() const
+{
+    return m_mismatches;
+}
+
+int Grbl::TrafficReplay::available()
+{
+    return advance() ? m_record.length - m_offset : 0;
+}
+
+int Grbl::TrafficReplay::read()
+{
+    if (!advance())
+    {
+        return -1;
+    }
+
+    const auto c = m_record.data[m_offset++];
+
+    if (m_offset == m_record.length)
+    {
+        m_loaded = false;
+        m_recordsPlayed++;
+    }
+
+    return c;
+}
+
+size_t Grbl::TrafficReplay::write(const uint8_t *data, size_t length)
+{
+    for (size_t i = 0; i < length; i++)
+    {
+        if (isRealtimeCommand(data[i]))
+        {
+            continue;
+        }
+
+        if (m_expectedCount == 0)
+        {
+            m_mismatches++;
+            continue;
+        }
+
+        const auto tail = (m_expectedHead + TRAFFIC_REPLAY_EXPECTED_SIZE - m_expectedCount) %
+                          TRAFFIC_REPLAY_EXPECTED_SIZE;
+        m_mismatches += m_expected[tail] != data[i];
+        m_expectedCount--;
+    }
+
+    return length;
+}
+
+// --------------------------------------------------------------------------------------------------
+// Private methods
+// --------------------------------------------------------------------------------------------------
+
+bool Grbl::TrafficReplay::advance()
+{
+    if (!m_loaded && !load())
+    {
+        // Past the end of the log the clock keeps running, so timeouts still expire.
+        m_time += TRAFFIC_RECORD_SPAN_US;
+        return false;
+    }
+
+    if (m_offset == 0)
+    {
+        const auto logTime = static_cast<uint32_t>(m_record.time - m_firstTime);
+
+        if (m_realTime && Platform::micros() - m_startedAt < logTime)
+        {
+            return false;
+        }
+
+        m_time = logTime;
+    }
+
+    if (m_record.direction == TrafficDirection::Received)
+    {
+        return true;
+    }
+
+    for (size_t i = 0; i < m_record.length; i++)
+    {
+        if (isRealtimeCommand(m_record.data[i]))
+        {
+            continue;
+        }
+
+        m_expected[m_expectedHead] = m_record.data[i];
+        m_expectedHead = (m_expectedHead + 1) % TRAFFIC_REPLAY_EXPECTED_SIZE;
+        m_expectedCount += m_expectedCount < TRAFFIC_REPLAY_EXPECTED_SIZE;
+    }
+
+    m_loaded = false;
+    m_recordsPlayed++;
+
+    if (onSent)
+    {
+        onSent(m_record);
+    }
+
+    // The response may follow right away, so the caller gets to issue the command first.
+    return false;
+}
+
+bool Grbl::TrafficReplay::load()
+{
+    uint8_t header[TRAFFIC_RECORD_HEADER_SIZE];
+
+    if (m_exhausted || !readFully(header, sizeof(header)) || header[0] > 1)
+    {
+        m_exhausted = true;
+        return false;
+    }
+
+    m_record.direction = static_cast<TrafficDirection>(header[0]);
+    m_record.length = header[1];
+    m_record.time = 0;
+
+    for (auto i = 0; i < 4; i++)
+    {
+        m_record.time |= static_cast<uint32_t>(header[2 + i]) << (8 * i);
+    }
+
+    if (!readFully(m_record.data, m_record.length))
+    {
+        m_exhausted = true;
+        return false;
+    }
+
+    if (m_record.length == 0)
+    {
+        return load();
+    }
+
+    if (m_recordsPlayed == 0 && m_time == 0)
+    {
+        m_firstTime = m_record.time;
+        m_startedAt = Platform::micros();
+    }
+
+    m_offset = 0;
+    m_loaded = true;
+    return true;
+}
+
+bool Grbl::TrafficReplay::readFully(uint8_t *buffer, size_t length)
+{
+    size_t count = 0;
+
+    while (count < length)
+    {
+        const auto read = m_log->read(buffer + count, length - count);
+
+        if (read == 0)
+        {
+            return false;
+        }
+
+        count += read;
+    }
+
+    return true;
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "GrblPlatform.h"
+#include "RingBuffer.h"
+
+#include <functional>
+
+namespace Grbl
+{
+    // Log format: the magic "GTL1", followed by records of
+    //   uint8 direction (0 received, 1 sent), uint8 length, uint32 Platform::micros() (little endian), payload.
+    // Consecutive bytes in one direction share a record until a line end, a pause or the maximum length.
+    constexpr uint8_t TRAFFIC_LOG_MAGIC[] = {'G', 'T', 'L', '1'};
+    constexpr auto TRAFFIC_RECORD_HEADER_SIZE = 6;
+    constexpr auto MAX_TRAFFIC_RECORD_LENGTH = 255;
+    constexpr auto TRAFFIC_RECORD_SPAN_US = 1000; // Bytes arriving later start a new record.
+    constexpr auto TRAFFIC_REPLAY_EXPECTED_SIZE = 1024; // Sent bytes kept for comparison during a replay.
+    constexpr auto TRAFFIC_SINK_QUEUE_RECORDS = 4;       // Completed records waiting to be written to the sink.
+
+    enum class TrafficDirection : uint8_t
+    {
+        Received,
+        Sent
+    };
+
+    struct TrafficRecord
+    {
+        TrafficDirection direction;
+        uint8_t length;
+        uint32_t time;
+        uint8_t data[MAX_TRAFFIC_RECORD_LENGTH];
+    };
+
+    // Timestamped log of the traffic on a stream. It is either kept in a ring that overwrites the oldest
+    // records, e.g. in a buffer from ps_malloc() so it lives in PSRAM, or written through to a sink such as a
+    // file. May be fed from the reader task and the sending task at the same time. Records are completed under
+    // a lock and written to the sink outside of it, by whichever task finds the sink free, so a slow file
+    // never holds up the task that only records.
+    class TrafficRecorder
+    {
+    public:
+        TrafficRecorder(uint8_t *buffer, size_t size);
+        explicit TrafficRecorder(ByteSink &sink);
+
+        TrafficRecorder(const TrafficRecorder &) = delete;
+        TrafficRecorder &operator=(const TrafficRecorder &) = delete;
+
+        void record(TrafficDirection direction, const uint8_t *data, size_t length);
+        // Stores the record still being assembled and flushes the sink.
+        void flush();
+        // Writes the log kept in the ring to sink, oldest record first.
+        void writeTo(ByteSink &sink);
+        void clear();
+
+        [[nodiscard]] uint32_t recordsStored() const;
+        [[nodiscard]] uint32_t recordsOverwritten() const;
+
+    private:
+        uint8_t *m_buffer;
+        size_t m_size;
+        size_t m_head;
+        size_t m_used;
+        ByteSink *m_sink;
+        TrafficRecord m_pending;
+        uint32_t m_recordsStored;
+        uint32_t m_recordsOverwritten;
+        Mutex m_mutex;     // Guards everything but the sink and m_writing.
+        Mutex m_sinkMutex; // Held while writing to the sink.
+        RingBuffer<TrafficRecord, TRAFFIC_SINK_QUEUE_RECORDS> m_completed;
+        TrafficRecord m_writing;
+
+        void reserve(size_t records);
+        void writeCompleted(bool wait);
+        void store();
+        void storeInRing(const uint8_t *data, size_t length);
+        void dropOldestRecord();
+    };
+
+    // Passes everything through to the wrapped stream and records it on the way.
+    class RecordingStream : public ByteStream
+    {
+    public:
+        RecordingStream(ByteStream &stream, TrafficRecorder &recorder);
+
+        [[nodiscard]] int available() override;
+        [[nodiscard]] int read() override;
+        size_t write(const uint8_t *data, size_t length) override;
+
+    private:
+        ByteStream *m_stream;
+        TrafficRecorder *m_recorder;
+    };
+
+    // Plays a traffic log back as the stream the interface reads from. Received bytes are handed out at their
+    // original pace, or as fast as they are read; micros() is the matching virtual clock for
+    // Platform::setClockSource(). Sent records are reported through onSent once due, so a driver can issue
+    // the original commands again, and what is written is compared against them.
+    class TrafficReplay : public ByteStream
+    {
+    public:
+        explicit TrafficReplay(ByteSource &log, bool realTime = false);
+
+        [[nodiscard]] bool valid() const; // The log starts with TRAFFIC_LOG_MAGIC.
+        [[nodiscard]] bool finished();
+        // Log time of the last record played, counted from the first one. Keeps running once the log is over.
+        [[nodiscard]] uint64_t micros() const;
+        [[nodiscard]] uint32_t recordsPlayed() const;
+        // Bytes written that differ from the sent records, realtime commands aside.
+        [[nodiscard]] uint32_t mismatches() const;
+
+        [[nodiscard]] int available() override;
+        [[nodiscard]] int read() override;
+        size_t write(const uint8_t *data, size_t length) override;
+
+        std::function<void(const TrafficRecord &record)> onSent;
+
+    private:
+        ByteSource *m_log;
+        bool m_realTime;
+        bool m_valid;
+        bool m_loaded;
+        bool m_exhausted;
+        TrafficRecord m_record;
+        size_t m_offset;
+        uint32_t m_firstTime;
+        uint64_t m_time;
+        uint32_t m_startedAt;
+        uint32_t m_recordsPlayed;
+        uint32_t m_mismatches;
+        uint8_t m_expected[TRAFFIC_REPLAY_EXPECTED_SIZE];
+        size_t m_expectedHead;
+        size_t m_expectedCount;
+
+        // Makes the next received byte ready. A sent record that is due is played instead, which leaves no byte
+        // ready for this call. False if nothing is ready.
+        [[nodiscard]] bool advance();
+        [[nodiscard]] bool load();
+        [[nodiscard]] bool readFully(uint8_t *buffer, size_t length);
+    };
+}